@@ -29,4 +29,7 @@ struct native_board_t {
 
 struct native_engine_t {
     libchess::engine instance;
+
+    // created on the first search, so that its table carries over from move to move
+    std::unique_ptr<libchess::searcher> searcher;
 };
\ No newline at end of file
@@ -56,14 +56,13 @@ LIBCHESS_API bool SetBoardPiece(native_board_t* board, const libchess::coord* po
 }
 
 LIBCHESS_API const char* SerializeBoardFEN(native_board_t* board) {
-    std::string fen = board->instance->serialize();
+    libchess::board::fen_buffer_t fen;
+    const auto& data = board->instance->get_data();
+    size_t length = libchess::board::serialize(data, fen.data(), fen.size());
 
-    size_t length = fen.length();
     size_t size = (length + 1) * sizeof(char);
     char* buffer = (char*)malloc(size);
-
-    buffer[length] = '\0';
-    memcpy(buffer, fen.c_str(), length * sizeof(char));
+    memcpy(buffer, fen.data(), size);
 
     return buffer;
 }
@@ -75,6 +74,9 @@ LIBCHESS_API void AdvanceTurn(native_board_t* board) {
     } else {
         data.current_turn = libchess::player_color::white;
     }
+
+    // keep the position key in sync
+    data.key ^= libchess::zobrist::keys.turn;
 }
 
 LIBCHESS_API libchess::player_color GetCurrentBoardTurn(native_board_t* board) {
@@ -105,6 +107,10 @@ LIBCHESS_API uint64_t GetBoardFullmoveCount(native_board_t* board) {
     return board->instance->get_data().fullmove_count;
 }
 
+LIBCHESS_API uint64_t GetBoardKey(native_board_t* board) {
+    return board->instance->get_data().key;
+}
+
 LIBCHESS_API libchess::board* GetInternalBoardPointer(native_board_t* board) {
     return board->instance.get();
 }
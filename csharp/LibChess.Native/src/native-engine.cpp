@@ -125,6 +125,17 @@ LIBCHESS_API void EngineComputeLegalMoves(native_engine_t* engine, const libches
     }
 }
 
+LIBCHESS_API void EngineGenerateLegalMoves(native_engine_t* engine,
+                                           void (*callback)(const libchess::move_t*)) {
+    libchess::move_list moves;
+    engine->instance.generate_legal_moves(moves);
+
+    for (auto move : moves) {
+        auto unpacked = move.unpack();
+        callback(&unpacked);
+    }
+}
+
 LIBCHESS_API bool EngineIsMoveLegal(native_engine_t* engine, const libchess::move_t* move) {
     return engine->instance.is_move_legal(*move);
 }
@@ -134,6 +145,36 @@ LIBCHESS_API bool EngineCommitMove(native_engine_t* engine, const libchess::move
     return engine->instance.commit_move(*move, true, advance_turn);
 }
 
+LIBCHESS_API bool EngineMakeMove(native_engine_t* engine, const libchess::move_t* move) {
+    return engine->instance.make_move(*move);
+}
+
+LIBCHESS_API bool EngineUnmakeMove(native_engine_t* engine) {
+    return engine->instance.unmake_move();
+}
+
 LIBCHESS_API void ClearEngineCache(native_engine_t* engine) { engine->instance.clear_cache(); }
 
+LIBCHESS_API bool EngineSearch(native_engine_t* engine, uint32_t depth, uint64_t nodes,
+                               uint64_t time_ms, libchess::move_t* move, int32_t* score) {
+    libchess::search_limits_t limits;
+    limits.depth = depth;
+    limits.nodes = nodes;
+    limits.time_ms = time_ms;
+
+    if (!engine->searcher) {
+        engine->searcher = std::make_unique<libchess::searcher>();
+    }
+
+    libchess::search_info_t info;
+    if (!engine->searcher->search(engine->instance, limits, info)) {
+        return false;
+    }
+
+    *move = info.pv[0].unpack();
+    *score = info.score;
+
+    return true;
+}
+
 } // end of p/invoke block
\ No newline at end of file
@@ -187,6 +187,7 @@ namespace LibChess
 
         public ulong HalfmoveClock => NativeFunctions.GetBoardHalfmoveClock(mAddress);
         public ulong FullmoveCount => NativeFunctions.GetBoardFullmoveCount(mAddress);
+        public ulong Key => NativeFunctions.GetBoardKey(mAddress);
 
         public static bool operator ==(Board? lhs, Board? rhs) => lhs?.Equals(rhs) ?? (lhs is null);
         public static bool operator !=(Board? lhs, Board? rhs) => !(lhs == rhs);
@@ -26,6 +26,7 @@ namespace LibChess
     {
         public Coord Position;
         public Coord Destination;
+        public PieceType Promotion;
     }
 
     public struct PieceQuery
@@ -214,6 +215,14 @@ namespace LibChess
             return moves;
         }
 
+        public unsafe IReadOnlyList<Move> GenerateLegalMoves()
+        {
+            var moves = new List<Move>();
+            NativeFunctions.EngineGenerateLegalMoves(mAddress, move => moves.Add(*move));
+
+            return moves;
+        }
+
         public unsafe bool IsMoveLegal(Move move)
         {
             return NativeFunctions.EngineIsMoveLegal(mAddress, &move);
@@ -288,8 +297,24 @@ namespace LibChess
             return true;
         }
 
+        public unsafe bool MakeMove(Move move) => NativeFunctions.EngineMakeMove(mAddress, &move);
+        public bool UnmakeMove() => NativeFunctions.EngineUnmakeMove(mAddress);
+
         public void ClearCache() => NativeFunctions.ClearEngineCache(mAddress);
 
+        // 0 means no limit. the whole search runs natively - nothing crosses back per move
+        public unsafe bool Search(uint depth, ulong nodes, ulong timeMs, out Move move, out int score)
+        {
+            var tempMove = new Move();
+            int tempScore = 0;
+
+            bool found = NativeFunctions.EngineSearch(mAddress, depth, nodes, timeMs, &tempMove, &tempScore);
+            move = tempMove;
+            score = tempScore;
+
+            return found;
+        }
+
         public override int GetHashCode() => mAddress.GetHashCode();
         public override bool Equals(object? obj)
         {
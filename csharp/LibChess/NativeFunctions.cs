@@ -64,6 +64,9 @@ namespace LibChess
         [DllImport(sNativeLibraryName)]
         public static extern ulong GetBoardFullmoveCount(IntPtr address);
 
+        [DllImport(sNativeLibraryName)]
+        public static extern ulong GetBoardKey(IntPtr address);
+
         [DllImport(sNativeLibraryName)]
         public static extern IntPtr GetInternalBoardPointer(IntPtr address);
 
@@ -118,15 +121,28 @@ namespace LibChess
         [DllImport(sNativeLibraryName)]
         public static extern unsafe void EngineComputeLegalMoves(IntPtr address, Coord* position, PositionCallback callback);
 
+        public unsafe delegate void MoveCallback(Move* move);
+        [DllImport(sNativeLibraryName)]
+        public static extern void EngineGenerateLegalMoves(IntPtr address, MoveCallback callback);
+
         [DllImport(sNativeLibraryName)]
         public static extern unsafe bool EngineIsMoveLegal(IntPtr address, Move* move);
 
         [DllImport(sNativeLibraryName)]
         public static extern unsafe bool EngineCommitMove(IntPtr address, Move* move, bool advanceTurn);
 
+        [DllImport(sNativeLibraryName)]
+        public static extern unsafe bool EngineMakeMove(IntPtr address, Move* move);
+
+        [DllImport(sNativeLibraryName)]
+        public static extern bool EngineUnmakeMove(IntPtr address);
+
         [DllImport(sNativeLibraryName)]
         public static extern void ClearEngineCache(IntPtr address);
 
+        [DllImport(sNativeLibraryName)]
+        public static extern unsafe bool EngineSearch(IntPtr address, uint depth, ulong nodes, ulong timeMs, Move* move, int* score);
+
         #endregion
         #region Utilities
 
@@ -18,6 +18,26 @@
 #include "libchesspch.h"
 
 #include "libchess/coord.h"
+#include "libchess/bitboard.h"
 #include "libchess/board.h"
+#include "libchess/attacks.h"
+#include "libchess/zobrist.h"
+#include "libchess/eval.h"
+#include "libchess/move_list.h"
 #include "libchess/engine.h"
+#include "libchess/thread_pool.h"
+#include "libchess/perft.h"
+#include "libchess/mapped_file.h"
+#include "libchess/epd.h"
+#include "libchess/position_file.h"
+#include "libchess/san.h"
+#include "libchess/uci.h"
+#include "libchess/pgn.h"
+#include "libchess/game_archive.h"
+#include "libchess/polyglot.h"
+#include "libchess/tablebase.h"
+#include "libchess/transposition_table.h"
+#include "libchess/move_picker.h"
+#include "libchess/nnue.h"
+#include "libchess/search.h"
 #include "libchess/util.h"
\ No newline at end of file
@@ -0,0 +1,220 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "attacks.h"
+
+namespace libchess::attacks {
+    static bitboard_t compute_offsets(const coord& pos, const std::vector<coord>& offsets) {
+        bitboard_t result = 0;
+        for (const auto& offset : offsets) {
+            coord destination = pos + offset;
+            if (!board::is_out_of_bounds(destination)) {
+                result |= bitboard::square_mask(bitboard::get_square(destination));
+            }
+        }
+
+        return result;
+    }
+
+    // matches the order of ray_direction
+    static const std::vector<coord> s_ray_offsets = { coord(0, 1),   coord(1, 0),
+                                                      coord(1, 1),   coord(-1, 1),
+                                                      coord(0, -1),  coord(-1, 0),
+                                                      coord(-1, -1), coord(1, -1) };
+
+    // the slow way - only used to fill out the tables
+    static bitboard_t compute_ray_attacks(size_t square, bitboard_t occupancy,
+                                          const std::vector<size_t>& directions) {
+        coord pos = bitboard::get_coord(square);
+        bitboard_t result = 0;
+
+        for (size_t direction : directions) {
+            const auto& offset = s_ray_offsets[direction];
+            for (coord current = pos + offset; !board::is_out_of_bounds(current);
+                 current += offset) {
+                bitboard_t mask = bitboard::square_mask(bitboard::get_square(current));
+                result |= mask;
+
+                if ((occupancy & mask) != 0) {
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // xorshift64*, seeded per rank - the seeds are known to find magics quickly
+    static uint64_t next_random(uint64_t& state) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ull;
+    }
+
+    static void compute_magics(std::array<magic_t, board::size>& magics,
+                               const std::vector<size_t>& directions, bitboard_t*& next_attacks) {
+        static constexpr std::array<uint64_t, board::width> seeds = { 728,  10316, 55013, 32803,
+                                                                      12281, 15100, 16645, 255 };
+
+        // a single square can have at most 2^12 blocker configurations
+        std::vector<bitboard_t> occupancies(4096), references(4096);
+        std::vector<uint32_t> epochs(4096, 0);
+        uint32_t current_epoch = 0;
+
+        for (size_t square = 0; square < board::size; square++) {
+            coord pos = bitboard::get_coord(square);
+            auto& magic = magics[square];
+
+            // pieces on the edge of the board never block anything
+            bitboard_t rank_edges = bitboard::rank_1 | bitboard::rank_8;
+            bitboard_t file_edges = bitboard::file_a | bitboard::file_h;
+            bitboard_t edges = (rank_edges & ~bitboard::rank_mask(pos.y)) |
+                               (file_edges & ~bitboard::file_mask(pos.x));
+
+            magic.mask = compute_ray_attacks(square, 0, directions) & ~edges;
+            magic.shift = 64 - bitboard::popcount(magic.mask);
+            magic.attacks = next_attacks;
+
+            // carry-rippler trick to walk every subset of the mask
+            size_t count = 0;
+            bitboard_t subset = 0;
+
+            do {
+                occupancies[count] = subset;
+                references[count] = compute_ray_attacks(square, subset, directions);
+
+                count++;
+                subset = (subset - magic.mask) & magic.mask;
+            } while (subset != 0);
+
+            next_attacks += count;
+            auto attacks = const_cast<bitboard_t*>(magic.attacks);
+
+            uint64_t state = seeds[pos.y];
+            for (size_t i = 0; i < count;) {
+                // sparse candidates make much better magics
+                do {
+                    magic.magic = next_random(state) & next_random(state) & next_random(state);
+                } while (bitboard::popcount((magic.mask * magic.magic) >> 56) < 6);
+
+                // epochs save clearing the attack table between attempts
+                current_epoch++;
+                for (i = 0; i < count; i++) {
+                    size_t index = magic.get_index(occupancies[i]);
+
+                    if (epochs[index] < current_epoch) {
+                        epochs[index] = current_epoch;
+                        attacks[index] = references[i];
+                    } else if (attacks[index] != references[i]) {
+                        break; // destructive collision, try another magic
+                    }
+                }
+            }
+        }
+    }
+
+    static tables_t s_tables;
+    static const tables_t& compute_tables() {
+        static const std::vector<coord> knight_offsets = { coord(1, 2),   coord(2, 1),
+                                                           coord(2, -1),  coord(1, -2),
+                                                           coord(-1, -2), coord(-2, -1),
+                                                           coord(-2, 1),  coord(-1, 2) };
+
+        static const std::vector<coord> king_offsets = { coord(0, 1),   coord(1, 1),
+                                                         coord(1, 0),   coord(1, -1),
+                                                         coord(0, -1),  coord(-1, -1),
+                                                         coord(-1, 0),  coord(-1, 1) };
+
+        static const std::vector<coord> white_pawn_offsets = { coord(-1, 1), coord(1, 1) };
+        static const std::vector<coord> black_pawn_offsets = { coord(-1, -1), coord(1, -1) };
+
+        auto& tables = s_tables;
+        for (size_t square = 0; square < board::size; square++) {
+            coord pos = bitboard::get_coord(square);
+
+            tables.knight[square] = compute_offsets(pos, knight_offsets);
+            tables.king[square] = compute_offsets(pos, king_offsets);
+
+            tables.pawn[(size_t)player_color::white][square] =
+                compute_offsets(pos, white_pawn_offsets);
+
+            tables.pawn[(size_t)player_color::black][square] =
+                compute_offsets(pos, black_pawn_offsets);
+
+            for (size_t i = 0; i < ray_direction_count; i++) {
+                tables.rays[i][square] = compute_ray_attacks(square, 0, { i });
+            }
+        }
+
+        for (size_t square = 0; square < board::size; square++) {
+            tables.between[square].fill(0);
+            tables.line[square].fill(0);
+
+            for (size_t i = 0; i < ray_direction_count; i++) {
+                // opposite directions are 4 apart
+                size_t opposite = (i + ray_direction_count / 2) % ray_direction_count;
+                bitboard_t full_line = tables.rays[i][square] | tables.rays[opposite][square] |
+                                       bitboard::square_mask(square);
+
+                bitboard_t ray = tables.rays[i][square];
+                while (ray != 0) {
+                    size_t other = bitboard::pop_lsb(ray);
+
+                    tables.between[square][other] = tables.rays[i][square] &
+                                                    ~tables.rays[i][other] &
+                                                    ~bitboard::square_mask(other);
+
+                    tables.line[square][other] = full_line;
+                }
+            }
+        }
+
+        static const std::vector<size_t> rook_directions = {
+            ray_direction_north, ray_direction_east, ray_direction_south, ray_direction_west
+        };
+
+        static const std::vector<size_t> bishop_directions = { ray_direction_north_east,
+                                                               ray_direction_north_west,
+                                                               ray_direction_south_west,
+                                                               ray_direction_south_east };
+
+        bitboard_t* next_attacks = tables.slider_attacks.data();
+        compute_magics(tables.rook_magics, rook_directions, next_attacks);
+        compute_magics(tables.bishop_magics, bishop_directions, next_attacks);
+
+        return tables;
+    }
+
+    const tables_t& tables = compute_tables();
+
+    bitboard_t get_attackers(const board::data_t& data, size_t square, player_color color,
+                             bitboard_t occupancy) {
+        const auto& masks = data.piece_masks[(size_t)color];
+        player_color opposing =
+            color != player_color::white ? player_color::white : player_color::black;
+
+        bitboard_t diagonal = masks[(size_t)piece_type::bishop] | masks[(size_t)piece_type::queen];
+        bitboard_t straight = masks[(size_t)piece_type::rook] | masks[(size_t)piece_type::queen];
+
+        // a pawn attacks a square if a pawn of the other color on that square would attack it
+        return (pawn(opposing, square) & masks[(size_t)piece_type::pawn]) |
+               (knight(square) & masks[(size_t)piece_type::knight]) |
+               (king(square) & masks[(size_t)piece_type::king]) |
+               (bishop(square, occupancy) & diagonal) | (rook(square, occupancy) & straight);
+    }
+} // namespace libchess::attacks
\ No newline at end of file
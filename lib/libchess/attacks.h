@@ -0,0 +1,110 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "board.h"
+#include "bitboard.h"
+
+namespace libchess::attacks {
+    // directions that increase the square index come first
+    enum ray_direction : size_t {
+        ray_direction_north = 0,
+        ray_direction_east,
+        ray_direction_north_east,
+        ray_direction_north_west,
+        ray_direction_south,
+        ray_direction_west,
+        ray_direction_south_west,
+        ray_direction_south_east,
+        ray_direction_count
+    };
+
+    // "fancy" magic bitboards - the relevant blockers of a square are multiplied by a magic
+    // number, and the top bits of the product index into that square's slice of the table
+    struct magic_t {
+        bitboard_t mask, magic;
+        const bitboard_t* attacks;
+        uint32_t shift;
+
+        size_t get_index(bitboard_t occupancy) const {
+            return (size_t)(((occupancy & mask) * magic) >> shift);
+        }
+    };
+
+    struct tables_t {
+        std::array<bitboard_t, board::size> knight, king;
+        std::array<std::array<bitboard_t, board::size>, player_color_count> pawn;
+
+        // every square in a direction, up to the edge of the board
+        std::array<std::array<bitboard_t, board::size>, ray_direction_count> rays;
+
+        // for two squares on the same rank, file, or diagonal - the squares strictly between
+        // them, and the entire line through them. 0 for unaligned squares
+        std::array<std::array<bitboard_t, board::size>, board::size> between, line;
+
+        std::array<magic_t, board::size> rook_magics, bishop_magics;
+
+        // 2^12 entries at most for a rook, 2^9 for a bishop. all squares summed up
+        std::array<bitboard_t, 0x19000 + 0x1480> slider_attacks;
+    };
+
+    // computed once at startup, magics included
+    extern const tables_t& tables;
+
+    inline bitboard_t knight(size_t square) { return tables.knight[square]; }
+    inline bitboard_t king(size_t square) { return tables.king[square]; }
+
+    // squares a pawn of the given color on the given square captures on
+    inline bitboard_t pawn(player_color color, size_t square) {
+        return tables.pawn[(size_t)color][square];
+    }
+
+    inline bitboard_t between(size_t first, size_t second) { return tables.between[first][second]; }
+    inline bitboard_t line(size_t first, size_t second) { return tables.line[first][second]; }
+
+    // slow, but doesn't need the magic tables. mostly used to build them
+    inline bitboard_t ray(size_t direction, size_t square, bitboard_t occupancy) {
+        bitboard_t attacks = tables.rays[direction][square];
+        bitboard_t blockers = attacks & occupancy;
+
+        if (blockers != 0) {
+            size_t blocker = direction < ray_direction_south ? bitboard::lsb(blockers)
+                                                             : bitboard::msb(blockers);
+
+            attacks ^= tables.rays[direction][blocker];
+        }
+
+        return attacks;
+    }
+
+    inline bitboard_t rook(size_t square, bitboard_t occupancy) {
+        const auto& magic = tables.rook_magics[square];
+        return magic.attacks[magic.get_index(occupancy)];
+    }
+
+    inline bitboard_t bishop(size_t square, bitboard_t occupancy) {
+        const auto& magic = tables.bishop_magics[square];
+        return magic.attacks[magic.get_index(occupancy)];
+    }
+
+    inline bitboard_t queen(size_t square, bitboard_t occupancy) {
+        return rook(square, occupancy) | bishop(square, occupancy);
+    }
+
+    // every piece of the given color attacking the given square
+    bitboard_t get_attackers(const board::data_t& data, size_t square, player_color color,
+                             bitboard_t occupancy);
+} // namespace libchess::attacks
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "coord.h"
+
+namespace libchess {
+    // one bit per square - bit 0 is a1, bit 7 is h1, and bit 63 is h8
+    using bitboard_t = uint64_t;
+
+    namespace bitboard {
+        static constexpr bitboard_t file_a = 0x0101010101010101ull;
+        static constexpr bitboard_t file_h = file_a << 7;
+        static constexpr bitboard_t rank_1 = 0xFFull;
+        static constexpr bitboard_t rank_8 = rank_1 << 56;
+
+        inline constexpr bitboard_t square_mask(size_t square) { return (bitboard_t)1 << square; }
+
+        inline constexpr bitboard_t file_mask(int32_t x) {
+            return (x < 0 || x >= 8) ? 0 : (file_a << x);
+        }
+
+        inline constexpr bitboard_t rank_mask(int32_t y) {
+            return (y < 0 || y >= 8) ? 0 : (rank_1 << (y * 8));
+        }
+
+        inline constexpr size_t get_square(int32_t x, int32_t y) { return (size_t)(y * 8 + x); }
+        inline size_t get_square(const coord& pos) { return get_square(pos.x, pos.y); }
+        inline coord get_coord(size_t square) {
+            return coord((int32_t)(square % 8), (int32_t)(square / 8));
+        }
+
+        inline uint32_t popcount(bitboard_t bb) {
+#ifdef _MSC_VER
+            return (uint32_t)__popcnt64(bb);
+#else
+            return (uint32_t)__builtin_popcountll(bb);
+#endif
+        }
+
+        // index of the least significant set bit. undefined for an empty board
+        inline size_t lsb(bitboard_t bb) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, bb);
+            return (size_t)index;
+#else
+            return (size_t)__builtin_ctzll(bb);
+#endif
+        }
+
+        // index of the most significant set bit. undefined for an empty board
+        inline size_t msb(bitboard_t bb) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, bb);
+            return (size_t)index;
+#else
+            return (size_t)(63 - __builtin_clzll(bb));
+#endif
+        }
+
+        // removes the least significant set bit and returns its index
+        inline size_t pop_lsb(bitboard_t& bb) {
+            size_t square = lsb(bb);
+            bb &= bb - 1;
+            return square;
+        }
+
+        inline constexpr bitboard_t shift_north(bitboard_t bb) { return bb << 8; }
+        inline constexpr bitboard_t shift_south(bitboard_t bb) { return bb >> 8; }
+        inline constexpr bitboard_t shift_east(bitboard_t bb) { return (bb & ~file_h) << 1; }
+        inline constexpr bitboard_t shift_west(bitboard_t bb) { return (bb & ~file_a) >> 1; }
+    } // namespace bitboard
+} // namespace libchess
\ No newline at end of file
@@ -16,158 +16,238 @@
 
 #include "libchesspch.h"
 #include "board.h"
+#include "zobrist.h"
+#include "eval.h"
 #include "util.h"
 
 namespace libchess {
-    static bool parse_fen_string_pieces(const std::string& pieces, board::data_t& result) {
-        std::vector<std::string> ranks;
-        util::split_string(pieces, '/', ranks, util::string_split_options_omit_empty);
+    // the next space-delimited field. runs of spaces count as one separator
+    static bool next_fen_field(std::string_view fen, size_t& offset, std::string_view& field) {
+        while (offset < fen.length() && fen[offset] == ' ') {
+            offset++;
+        }
 
-        if (ranks.size() != board::width) {
+        if (offset >= fen.length()) {
             return false;
         }
 
-        static const std::regex free_space_regex("[1-8]");
-        for (size_t i = 0; i < board::width; i++) {
-            int32_t x = 0;
-            int32_t y = (int32_t)(board::width - (i + 1));
+        size_t end = fen.find(' ', offset);
+        if (end == std::string_view::npos) {
+            end = fen.length();
+        }
+
+        field = fen.substr(offset, end - offset);
+        offset = end;
+
+        return true;
+    }
+
+    static bool parse_fen_pieces(std::string_view pieces, board::data_t& result) {
+        size_t ranks = 0;
+        int32_t x = 0;
+        bool in_rank = false;
+
+        for (char c : pieces) {
+            if (c == '/') {
+                if (in_rank) {
+                    if (x < board::width) {
+                        return false; // rank's too narrow
+                    }
+
+                    ranks++;
+                    in_rank = false;
+                }
+
+                // empty ranks are skipped, i.e. "//" is the same as "/"
+                continue;
+            }
 
-            std::string rank_string = ranks[i];
-            for (char c : rank_string) {
-                // early check
-                if (x >= board::width) {
+            if (!in_rank) {
+                if (ranks >= board::width) {
                     return false;
                 }
 
-                // spaghetti-esque string creation & parsing
-                std::string character_string(&c, 1);
-                if (std::regex_match(character_string, free_space_regex)) {
-                    int32_t count = std::atoi(character_string.c_str());
+                x = 0;
+                in_rank = true;
+            }
 
-                    for (int32_t j = 0; j < count; j++) {
-                        coord pos(x++, y);
+            if (x >= board::width) {
+                return false;
+            }
 
-                        // later check
-                        if (pos.x >= board::width) {
-                            return false;
-                        }
+            int32_t y = (int32_t)(board::width - (ranks + 1));
+            if (c >= '1' && c <= '8') {
+                int32_t count = (int32_t)(c - '0');
+                if (x + count > board::width) {
+                    return false;
+                }
 
-                        size_t index = board::get_index(pos);
-                        result.pieces[index] = { piece_type::none };
-                    }
-                } else {
-                    piece_info_t temp_piece;
-                    if (util::parse_piece(c, temp_piece)) {
-                        coord pos(x++, y);
-                        size_t index = board::get_index(pos);
-                        result.pieces[index] = temp_piece;
-                    } else {
-                        return false; // invalid character
-                    }
+                for (int32_t i = 0; i < count; i++) {
+                    result.pieces[board::get_index(coord(x++, y))] = { piece_type::none };
                 }
+            } else {
+                piece_info_t piece;
+                if (!util::parse_piece(c, piece)) {
+                    return false; // invalid character
+                }
+
+                result.pieces[board::get_index(coord(x++, y))] = piece;
             }
+        }
 
+        if (in_rank) {
             if (x < board::width) {
-                return false; // rank's too narrow
+                return false;
             }
+
+            ranks++;
         }
 
-        return true;
+        return ranks == board::width;
     }
 
-    static bool parse_fen_string(const std::string& fen, board::data_t& result) {
-        std::vector<std::string> segments;
-        util::split_string(fen, ' ', segments, util::string_split_options_omit_empty);
-
-        // 6 total segments
-        if (segments.size() != 6) {
-            return false;
+    static bool parse_fen_castling(std::string_view field, castling_availability_t& result) {
+        result[player_color::white] = result[player_color::black] = castle_side_none;
+        if (field == "-") {
+            return true;
         }
 
-        // first up is the pieces
-        if (!parse_fen_string_pieces(segments[0], result)) {
-            return false;
+        for (char c : field) {
+            switch (c) {
+            case 'K':
+                result[player_color::white] |= castle_side_king;
+                break;
+            case 'Q':
+                result[player_color::white] |= castle_side_queen;
+                break;
+            case 'k':
+                result[player_color::black] |= castle_side_king;
+                break;
+            case 'q':
+                result[player_color::black] |= castle_side_queen;
+                break;
+            default:
+                return false;
+            }
         }
 
-        // next is current turn
-        std::string turn_segments = segments[1];
+        return true;
+    }
 
-        // segment should only be 1 character long
-        if (turn_segments.length() != 1) {
+    bool board::parse_fen_counter(std::string_view field, uint64_t& result) {
+        if (field.empty()) {
             return false;
         }
 
-        switch (turn_segments[0]) {
-        case 'w':
-            result.current_turn = player_color::white;
-            break;
-        case 'b':
-            result.current_turn = player_color::black;
-            break;
-        default:
-            return false;
+        uint64_t value = 0;
+        for (char c : field) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+
+            uint64_t digit = (uint64_t)(c - '0');
+            if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+                return false; // overflow
+            }
+
+            value = value * 10 + digit;
         }
 
-        // third, castling availability
-        std::string castling_segment = segments[2];
+        result = value;
+        return true;
+    }
 
-        // set defaults
-        result.player_castling_availability[player_color::white] =
-            result.player_castling_availability[player_color::black] = castle_side_none;
+    fen_error board::parse_fen_fields(std::string_view fen, data_t& result, bool optional_clocks,
+                                      size_t& end) {
+        size_t offset = 0;
+        std::string_view field;
 
-        if (castling_segment != "-") {
-            for (char c : castling_segment) {
-                char lower = (char)std::tolower((int)c);
-                player_color color = c != lower ? player_color::white : player_color::black;
+        if (!next_fen_field(fen, offset, field)) {
+            return fen_error::field_count;
+        } else if (!parse_fen_pieces(field, result)) {
+            return fen_error::piece_placement;
+        }
 
-                castle_side flag;
-                switch (lower) {
-                case 'k':
-                    flag = castle_side_king;
-                    break;
-                case 'q':
-                    flag = castle_side_queen;
-                    break;
-                default:
-                    return false;
-                }
+        if (!next_fen_field(fen, offset, field)) {
+            return fen_error::field_count;
+        } else if (field == "w") {
+            result.current_turn = player_color::white;
+        } else if (field == "b") {
+            result.current_turn = player_color::black;
+        } else {
+            return fen_error::current_turn;
+        }
 
-                result.player_castling_availability[color] |= flag;
-            }
+        if (!next_fen_field(fen, offset, field)) {
+            return fen_error::field_count;
+        } else if (!parse_fen_castling(field, result.player_castling_availability)) {
+            return fen_error::castling_availability;
         }
 
-        // fourth, en passant target
-        std::string en_passant_segment = segments[3];
-        if (en_passant_segment != "-") {
+        if (!next_fen_field(fen, offset, field)) {
+            return fen_error::field_count;
+        } else if (field == "-") {
+            result.en_passant_target.reset();
+        } else {
             coord target;
-            if (!util::parse_coordinate(en_passant_segment, target)) {
-                return false;
+            if (!util::parse_coordinate(field, target)) {
+                return fen_error::en_passant_target;
             }
 
             result.en_passant_target = target;
-        } else {
-            result.en_passant_target.reset();
         }
 
-        // lastly, counters
-        std::string halfmove_clock_segment = segments[4];
-        std::string fullmove_count_segment = segments[5];
+        if (optional_clocks) {
+            // epd leaves the clocks out, in which case whatever follows is left alone
+            size_t clock_offset = offset;
+            std::string_view halfmove_field, fullmove_field;
 
-        std::regex counter_regex("[0-9]+");
-        if (!std::regex_match(halfmove_clock_segment, counter_regex) ||
-            !std::regex_match(fullmove_count_segment, counter_regex)) {
-            return false;
+            if (next_fen_field(fen, clock_offset, halfmove_field) &&
+                next_fen_field(fen, clock_offset, fullmove_field) &&
+                parse_fen_counter(halfmove_field, result.halfmove_clock) &&
+                parse_fen_counter(fullmove_field, result.fullmove_count)) {
+                offset = clock_offset;
+            } else {
+                result.halfmove_clock = 0;
+                result.fullmove_count = 1;
+            }
+        } else {
+            if (!next_fen_field(fen, offset, field)) {
+                return fen_error::field_count;
+            } else if (!parse_fen_counter(field, result.halfmove_clock)) {
+                return fen_error::halfmove_clock;
+            }
+
+            if (!next_fen_field(fen, offset, field)) {
+                return fen_error::field_count;
+            } else if (!parse_fen_counter(field, result.fullmove_count)) {
+                return fen_error::fullmove_count;
+            }
         }
 
-        result.halfmove_clock = (uint64_t)std::stoull(halfmove_clock_segment);
-        result.fullmove_count = (uint64_t)std::stoull(fullmove_count_segment);
+        end = offset;
+        refresh(result);
 
-        return true;
+        return fen_error::none;
+    }
+
+    fen_error board::parse_fen(std::string_view fen, data_t& result) {
+        size_t end;
+        fen_error error = parse_fen_fields(fen, result, false, end);
+
+        // nothing but spaces may follow
+        std::string_view field;
+        if (error == fen_error::none && next_fen_field(fen, end, field)) {
+            error = fen_error::field_count;
+        }
+
+        return error;
     }
 
     std::shared_ptr<board> board::create() {
         auto _board = new board;
 
+        _board->m_data.current_turn = player_color::white;
         _board->m_data.halfmove_clock = 0;
         _board->m_data.fullmove_count = 1;
 
@@ -179,6 +259,7 @@ namespace libchess {
             _board->m_data.player_castling_availability[player_color::black] =
                 castle_side_king | castle_side_queen;
 
+        refresh(_board->m_data);
         return std::shared_ptr<board>(_board);
     }
 
@@ -186,24 +267,34 @@ namespace libchess {
         auto _board = new board;
         _board->m_data = data; // a lazy copy should be fine
 
+        // the caller may have only filled out the piece array
+        refresh(_board->m_data);
+
         return std::shared_ptr<board>(_board);
     }
 
     std::shared_ptr<board> board::copy(std::shared_ptr<board> existing) {
         std::shared_ptr<board> result;
         if (existing) {
-            result = create(existing->m_data);
+            result = std::shared_ptr<board>(new board);
+            result->m_data = existing->m_data; // already in sync
         }
 
         return result;
     }
 
-    std::shared_ptr<board> board::create(const std::string& fen) {
+    std::shared_ptr<board> board::create(std::string_view fen, fen_error* error) {
         auto _board = std::shared_ptr<board>(new board);
-        if (!parse_fen_string(fen, _board->m_data)) {
+
+        fen_error result = parse_fen(fen, _board->m_data);
+        if (result != fen_error::none) {
             _board.reset();
         }
 
+        if (error != nullptr) {
+            *error = result;
+        }
+
         return _board;
     }
 
@@ -226,6 +317,25 @@ namespace libchess {
         return pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= width;
     }
 
+    void board::refresh(data_t& data) {
+        for (auto& masks : data.piece_masks) {
+            masks.fill(0);
+        }
+
+        data.color_masks.fill(0);
+        data.occupancy = 0;
+
+        for (size_t square = 0; square < size; square++) {
+            const auto& piece = data.pieces[square ^ 56];
+            if (piece.type != piece_type::none) {
+                place_piece(data, square, piece);
+            }
+        }
+
+        data.key = zobrist::compute(data);
+        data.eval = eval::compute(data);
+    }
+
     bool board::get_piece(const coord& pos, piece_info_t* piece) {
         if (is_out_of_bounds(pos)) {
             if (piece != nullptr) {
@@ -250,104 +360,351 @@ namespace libchess {
             return false;
         }
 
-        size_t index = get_index(pos);
-        m_data.pieces[index] = piece;
+        if ((size_t)piece.type >= piece_type_count || (size_t)piece.color >= player_color_count) {
+            return false;
+        }
+
+        size_t square = bitboard::get_square(pos);
+        const auto& existing = m_data.pieces[square ^ 56];
+        m_data.key ^= zobrist::piece(existing, square);
+        eval::remove(m_data.eval, existing, square);
+        remove_piece(m_data, square);
+
+        if (piece.type != piece_type::none) {
+            m_data.key ^= zobrist::piece(piece, square);
+            eval::add(m_data.eval, piece, square);
+            place_piece(m_data, square, piece);
+        }
 
         return true;
     }
 
-    std::string board::serialize() {
-        std::stringstream fen;
+    static constexpr char s_piece_characters[player_color_count][piece_type_count] = {
+        { '\0', 'K', 'Q', 'R', 'N', 'B', 'P' },
+        { '\0', 'k', 'q', 'r', 'n', 'b', 'p' }
+    };
 
-        piece_info_t piece;
-        for (size_t i = 0; i < board::width; i++) {
-            if (i > 0) {
-                fen << "/";
-            }
+    static char* write_fen_counter(char* output, uint64_t value) {
+        char digits[20];
+        size_t count = 0;
 
-            uint32_t free_spaces = 0;
-            int32_t y = board::width - (i + 1);
-            for (int32_t x = 0; x < board::width; x++) {
-                auto pos = coord(x, y);
+        do {
+            digits[count++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
 
-                if (!get_piece(pos, &piece)) {
-                    free_spaces++;
-                    continue;
-                }
+        while (count > 0) {
+            *output++ = digits[--count];
+        }
 
-                if (free_spaces > 0) {
-                    fen << free_spaces;
-                    free_spaces = 0;
-                }
+        return output;
+    }
+
+    // needs max_fen_length bytes of room. returns the end of the output, or nullptr if the data
+    // holds a piece or turn that can't be written
+    static char* write_fen(const board::data_t& data, char* output) {
+        // the piece array is already in fen order - rank 8 first, a to h
+        for (size_t i = 0; i < board::size; i++) {
+            if (i > 0 && i % board::width == 0) {
+                *output++ = '/';
+            }
 
-                auto serialized_piece = util::serialize_piece(piece);
-                if (!serialized_piece.has_value()) {
-                    throw std::runtime_error("invalid piece type!");
+            const auto& piece = data.pieces[i];
+            if (piece.type == piece_type::none) {
+                // count the whole run of free spaces in the rank
+                char free_spaces = '1';
+                while ((i + 1) % board::width != 0 && data.pieces[i + 1].type == piece_type::none) {
+                    free_spaces++;
+                    i++;
                 }
 
-                fen << serialized_piece.value();
+                *output++ = free_spaces;
+                continue;
             }
 
-            // reused code - though what can you do
-            if (free_spaces > 0) {
-                fen << free_spaces;
+            if ((size_t)piece.type >= piece_type_count ||
+                (size_t)piece.color >= player_color_count) {
+                return nullptr;
             }
+
+            *output++ = s_piece_characters[(size_t)piece.color][(size_t)piece.type];
         }
 
-        char current_turn;
-        switch (m_data.current_turn) {
+        *output++ = ' ';
+        switch (data.current_turn) {
         case player_color::white:
-            current_turn = 'w';
+            *output++ = 'w';
             break;
         case player_color::black:
-            current_turn = 'b';
+            *output++ = 'b';
             break;
         default:
-            throw std::runtime_error("invalid current turn!");
+            return nullptr;
         }
 
-        fen << ' ' << current_turn << ' ';
-        {
-            std::stringstream castling_availability_stream;
-            for (auto color : { player_color::white, player_color::black }) {
-                std::vector<piece_type> available_sides;
-                uint8_t availability = m_data.player_castling_availability.at(color);
+        *output++ = ' ';
+        char* castling_start = output;
 
-                if ((availability & castle_side_king) != castle_side_none) {
-                    available_sides.push_back(piece_type::king);
-                }
+        for (auto color : { player_color::white, player_color::black }) {
+            uint8_t availability = data.player_castling_availability[color];
+            const char* characters = s_piece_characters[(size_t)color];
 
-                if ((availability & castle_side_queen) != castle_side_none) {
-                    available_sides.push_back(piece_type::queen);
-                }
+            if ((availability & castle_side_king) != castle_side_none) {
+                *output++ = characters[(size_t)piece_type::king];
+            }
 
-                for (auto side : available_sides) {
-                    piece_info_t piece_desc;
-                    piece_desc.type = side;
-                    piece_desc.color = color;
+            if ((availability & castle_side_queen) != castle_side_none) {
+                *output++ = characters[(size_t)piece_type::queen];
+            }
+        }
 
-                    castling_availability_stream << util::serialize_piece(piece_desc).value();
-                }
+        if (output == castling_start) {
+            *output++ = '-';
+        }
+
+        *output++ = ' ';
+        if (data.en_passant_target.has_value()) {
+            const auto& target = data.en_passant_target.value();
+            if (board::is_out_of_bounds(target)) {
+                return nullptr;
             }
 
-            std::string castling_availability_desc = castling_availability_stream.str();
-            if (castling_availability_desc.empty()) {
-                fen << '-';
-            } else {
-                fen << castling_availability_desc;
+            *output++ = (char)('a' + target.x);
+            *output++ = (char)('1' + target.y);
+        } else {
+            *output++ = '-';
+        }
+
+        *output++ = ' ';
+        output = write_fen_counter(output, data.halfmove_clock);
+
+        *output++ = ' ';
+        output = write_fen_counter(output, data.fullmove_count);
+
+        return output;
+    }
+
+    size_t board::serialize(const data_t& data, char* buffer, size_t buffer_size) {
+        if (buffer_size == 0) {
+            return 0;
+        }
+
+        char local_buffer[max_fen_length + 1];
+        char* output = buffer_size > max_fen_length ? buffer : local_buffer;
+
+        // leave an empty string behind on failure
+        char* end = write_fen(data, output);
+        if (end == nullptr) {
+            buffer[0] = '\0';
+            return 0;
+        }
+
+        size_t length = (size_t)(end - output);
+        if (output == local_buffer) {
+            if (length >= buffer_size) {
+                buffer[0] = '\0';
+                return 0;
+            }
+
+            memcpy(buffer, local_buffer, length);
+        }
+
+        buffer[length] = '\0';
+        return length;
+    }
+
+    bool board::serialize(const data_t* positions, size_t count, std::string& output,
+                          char delimiter) {
+        // reserve the worst case up front, and trim to what was written
+        size_t start = output.length();
+        output.resize(start + count * (max_fen_length + 1));
+
+        char* current = output.data() + start;
+        for (size_t i = 0; i < count; i++) {
+            current = write_fen(positions[i], current);
+            if (current == nullptr) {
+                output.resize(start);
+                return false;
+            }
+
+            *current++ = delimiter;
+        }
+
+        output.resize((size_t)(current - output.data()));
+        return true;
+    }
+
+    static void write_little_endian(uint8_t* output, uint64_t value, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            output[i] = (uint8_t)(value >> (i * 8));
+        }
+    }
+
+    static uint64_t read_little_endian(const uint8_t* input, size_t size) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; i++) {
+            value |= (uint64_t)input[i] << (i * 8);
+        }
+
+        return value;
+    }
+
+    static constexpr size_t s_packed_pieces_offset = 8;
+    static constexpr size_t s_packed_flags_offset = 24;
+    static constexpr size_t s_packed_en_passant_offset = 25;
+    static constexpr size_t s_packed_halfmove_offset = 26;
+    static constexpr size_t s_packed_fullmove_offset = 28;
+    static constexpr uint8_t s_packed_no_en_passant = 0xFF;
+
+    bool board::pack(const data_t& data, packed_position_t& packed) {
+        if (data.halfmove_clock > std::numeric_limits<uint16_t>::max() ||
+            data.fullmove_count > std::numeric_limits<uint32_t>::max() ||
+            (size_t)data.current_turn >= player_color_count) {
+            return false;
+        }
+
+        auto& bytes = packed.bytes;
+        bytes.fill(0);
+
+        bitboard_t occupancy = 0;
+        size_t piece_count = 0;
+
+        for (size_t square = 0; square < size; square++) {
+            const auto& piece = data.pieces[square ^ 56];
+            if (piece.type == piece_type::none) {
+                continue;
+            }
+
+            if (piece_count == packed_position_t::max_pieces ||
+                (size_t)piece.type >= piece_type_count ||
+                (size_t)piece.color >= player_color_count) {
+                return false;
             }
+
+            uint8_t nibble = (uint8_t)piece.type | (uint8_t)((size_t)piece.color << 3);
+            bytes[s_packed_pieces_offset + piece_count / 2] |= nibble << ((piece_count % 2) * 4);
+
+            occupancy |= bitboard::square_mask(square);
+            piece_count++;
+        }
+
+        write_little_endian(bytes.data(), occupancy, sizeof(uint64_t));
+
+        const auto& castling = data.player_castling_availability;
+        bytes[s_packed_flags_offset] =
+            (uint8_t)data.current_turn | (uint8_t)((castling[player_color::white] & 3) << 1) |
+            (uint8_t)((castling[player_color::black] & 3) << 3);
+
+        uint8_t en_passant = s_packed_no_en_passant;
+        if (data.en_passant_target.has_value()) {
+            const auto& target = data.en_passant_target.value();
+            if (is_out_of_bounds(target)) {
+                return false;
+            }
+
+            en_passant = (uint8_t)bitboard::get_square(target);
+        }
+
+        bytes[s_packed_en_passant_offset] = en_passant;
+        write_little_endian(&bytes[s_packed_halfmove_offset], data.halfmove_clock,
+                            sizeof(uint16_t));
+        write_little_endian(&bytes[s_packed_fullmove_offset], data.fullmove_count,
+                            sizeof(uint32_t));
+
+        return true;
+    }
+
+    bool board::unpack(const packed_position_t& packed, data_t& data) {
+        const auto& bytes = packed.bytes;
+
+        bitboard_t occupancy = read_little_endian(bytes.data(), sizeof(uint64_t));
+        size_t piece_count = bitboard::popcount(occupancy);
+
+        uint8_t flags = bytes[s_packed_flags_offset];
+        uint8_t en_passant = bytes[s_packed_en_passant_offset];
+
+        if (piece_count > packed_position_t::max_pieces || (flags >> 5) != 0 ||
+            (en_passant >= size && en_passant != s_packed_no_en_passant)) {
+            return false;
         }
 
-        fen << ' ';
-        if (m_data.en_passant_target.has_value()) {
-            fen << util::serialize_coordinate(m_data.en_passant_target.value());
+        data.pieces.fill({ piece_type::none });
+        for (auto& masks : data.piece_masks) {
+            masks.fill(0);
+        }
+
+        data.color_masks.fill(0);
+        data.occupancy = 0;
+
+        for (size_t i = 0; i < piece_count; i++) {
+            uint8_t nibble = (bytes[s_packed_pieces_offset + i / 2] >> ((i % 2) * 4)) & 0xF;
+
+            piece_info_t piece;
+            piece.type = (piece_type)(nibble & 7);
+            piece.color = (player_color)(nibble >> 3);
+
+            if (piece.type == piece_type::none || (size_t)piece.type >= piece_type_count) {
+                return false;
+            }
+
+            place_piece(data, bitboard::pop_lsb(occupancy), piece);
+        }
+
+        // the unused nibbles have to be zero, so that every position has exactly one record
+        for (size_t i = piece_count; i < packed_position_t::max_pieces; i++) {
+            if (((bytes[s_packed_pieces_offset + i / 2] >> ((i % 2) * 4)) & 0xF) != 0) {
+                return false;
+            }
+        }
+
+        data.current_turn = (player_color)(flags & 1);
+        data.player_castling_availability[player_color::white] = (flags >> 1) & 3;
+        data.player_castling_availability[player_color::black] = (flags >> 3) & 3;
+
+        if (en_passant != s_packed_no_en_passant) {
+            data.en_passant_target = bitboard::get_coord(en_passant);
         } else {
-            fen << '-';
+            data.en_passant_target.reset();
         }
 
-        fen << ' ' << m_data.halfmove_clock;
-        fen << ' ' << m_data.fullmove_count;
+        data.halfmove_clock = read_little_endian(&bytes[s_packed_halfmove_offset],
+                                                 sizeof(uint16_t));
+        data.fullmove_count = read_little_endian(&bytes[s_packed_fullmove_offset],
+                                                 sizeof(uint32_t));
+
+        data.key = zobrist::compute(data);
+        data.eval = eval::compute(data);
+        return true;
+    }
+
+    size_t board::pack(const data_t* positions, size_t count, packed_position_t* packed) {
+        for (size_t i = 0; i < count; i++) {
+            if (!pack(positions[i], packed[i])) {
+                return i;
+            }
+        }
+
+        return count;
+    }
+
+    size_t board::unpack(const packed_position_t* packed, size_t count, data_t* positions) {
+        for (size_t i = 0; i < count; i++) {
+            if (!unpack(packed[i], positions[i])) {
+                return i;
+            }
+        }
+
+        return count;
+    }
+
+    std::string board::serialize() {
+        fen_buffer_t buffer;
+        size_t length = serialize(m_data, buffer.data(), buffer.size());
+
+        if (length == 0) {
+            throw std::runtime_error("invalid board state!");
+        }
 
-        return fen.str();
+        return std::string(buffer.data(), length);
     }
 } // namespace libchess
\ No newline at end of file
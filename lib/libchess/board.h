@@ -16,45 +16,132 @@
 
 #pragma once
 #include "coord.h"
+#include "bitboard.h"
 
 namespace libchess {
     enum class piece_type : uint8_t { none = 0, king, queen, rook, knight, bishop, pawn };
     enum class player_color : uint8_t { white = 0, black };
 
+    static constexpr size_t piece_type_count = (size_t)piece_type::pawn + 1;
+    static constexpr size_t player_color_count = 2;
+
     enum castle_side : uint8_t {
         castle_side_none = 0,
         castle_side_king = (1 << 0),
         castle_side_queen = (1 << 1)
     };
 
+    // the first field of a fen string that failed to parse
+    enum class fen_error : uint8_t {
+        none = 0,
+        field_count,
+        piece_placement,
+        current_turn,
+        castling_availability,
+        en_passant_target,
+        halfmove_clock,
+        fullmove_count
+    };
+
     struct piece_info_t {
         piece_type type;
         player_color color;
     };
 
+    // a flat table instead of a map, so that copying a board's data never allocates
+    struct castling_availability_t {
+        std::array<uint8_t, player_color_count> flags;
+
+        uint8_t& operator[](player_color color) { return flags[(size_t)color]; }
+        uint8_t operator[](player_color color) const { return flags[(size_t)color]; }
+
+        uint8_t& at(player_color color) { return flags.at((size_t)color); }
+        uint8_t at(player_color color) const { return flags.at((size_t)color); }
+    };
+
+    // running evaluation terms, kept in step with the pieces like the key - see eval.h.
+    // midgame and endgame are from white's point of view
+    struct eval_terms_t {
+        int32_t midgame, endgame;
+        int32_t phase;
+    };
+
+    // a position in 32 bytes, the same on every platform - see board::pack. laid out as:
+    // bytes 0-7: occupancy, little-endian, with bit 0 as a1 (see bitboard.h)
+    // bytes 8-23: a nibble per occupied square in ascending order, low nibble first. the color
+    // is bit 3 and the piece type the rest
+    // byte 24: bit 0 is black to move, bits 1-4 are white's and black's castling availability
+    // byte 25: the en passant target square, or 0xFF
+    // bytes 26-27: halfmove clock, little-endian
+    // bytes 28-31: fullmove count, little-endian
+    struct packed_position_t {
+        static constexpr size_t size = 32;
+        static constexpr size_t max_pieces = 32;
+
+        std::array<uint8_t, size> bytes;
+    };
+
+    static_assert(sizeof(packed_position_t) == packed_position_t::size);
+
     class board : public std::enable_shared_from_this<board> {
     public:
         static constexpr size_t width = 8;
         static constexpr size_t size = width * width;
 
+        // 64 pieces, 7 slashes, "w", "KQkq", "e3", two 20-digit counters and 5 spaces
+        static constexpr size_t max_fen_length = 123;
+        using fen_buffer_t = std::array<char, max_fen_length + 1>;
+
         struct data_t {
             std::array<piece_info_t, size> pieces;
+
+            // derived from pieces - indexed by color, then by piece type
+            std::array<std::array<bitboard_t, piece_type_count>, player_color_count> piece_masks;
+            std::array<bitboard_t, player_color_count> color_masks;
+            bitboard_t occupancy;
+
             player_color current_turn;
-            std::unordered_map<player_color, uint8_t> player_castling_availability;
+            castling_availability_t player_castling_availability;
             std::optional<coord> en_passant_target;
             uint64_t halfmove_clock, fullmove_count;
+
+            // zobrist key of everything but the clocks - see zobrist.h
+            uint64_t key;
+
+            // material and placement, tapered by phase - see eval.h
+            eval_terms_t eval;
         };
 
         static std::shared_ptr<board> create();
         static std::shared_ptr<board> create(const data_t& data);
         static std::shared_ptr<board> copy(std::shared_ptr<board> existing);
 
-        static std::shared_ptr<board> create(const std::string& fen);
+        static std::shared_ptr<board> create(std::string_view fen, fen_error* error = nullptr);
         static std::shared_ptr<board> create_default();
 
+        // fills the caller's data in place, without allocating. the data is only complete
+        // (bitboards and key included) if fen_error::none is returned
+        static fen_error parse_fen(std::string_view fen, data_t& data);
+
+        // parses the leading fields of a fen or epd line, and sets end to the first character
+        // after them. with optional_clocks, missing clocks default to 0 and 1
+        static fen_error parse_fen_fields(std::string_view text, data_t& data, bool optional_clocks,
+                                          size_t& end);
+
+        // a halfmove clock or fullmove number. fails on anything but digits, or on overflow
+        static bool parse_fen_counter(std::string_view field, uint64_t& result);
+
         static size_t get_index(const coord& pos);
         static bool is_out_of_bounds(const coord& pos);
 
+        // recomputes the bitboards, the key, and the evaluation terms from the rest of the data
+        static void refresh(data_t& data);
+
+        // unchecked, square-indexed (see bitboard.h) placement that keeps the bitboards in sync.
+        // the key and the evaluation terms are left to the caller
+        static void place_piece(data_t& data, size_t square, const piece_info_t& piece);
+        static void remove_piece(data_t& data, size_t square);
+
         ~board() = default;
 
         board(const board&) = delete;
@@ -66,9 +153,53 @@ namespace libchess {
         data_t& get_data() { return m_data; }
         std::string serialize();
 
+        // writes a null-terminated fen without allocating. returns its length, or 0 and an empty
+        // string if the buffer is too small or the data is invalid. a fen_buffer_t always fits
+        static size_t serialize(const data_t& data, char* buffer, size_t buffer_size);
+
+        // appends each position's fen followed by the delimiter. on failure, output is left as
+        // it was
+        static bool serialize(const data_t* positions, size_t count, std::string& output,
+                              char delimiter = '\n');
+
+        // fails for more than 32 pieces, or clocks too large for the record
+        static bool pack(const data_t& data, packed_position_t& packed);
+
+        // fails for a malformed record. the data is only complete (bitboards and key included)
+        // if it succeeds
+        static bool unpack(const packed_position_t& packed, data_t& data);
+
+        // return how many positions were converted, stopping at the first failure
+        static size_t pack(const data_t* positions, size_t count, packed_position_t* packed);
+        static size_t unpack(const packed_position_t* packed, size_t count, data_t* positions);
+
     private:
         board() = default;
 
         data_t m_data;
     };
+
+    // the piece array is laid out rank 8 first, so flipping the rank bits converts to it
+    inline void board::place_piece(data_t& data, size_t square, const piece_info_t& piece) {
+        bitboard_t mask = bitboard::square_mask(square);
+
+        data.pieces[square ^ 56] = piece;
+        data.piece_masks[(size_t)piece.color][(size_t)piece.type] |= mask;
+        data.color_masks[(size_t)piece.color] |= mask;
+        data.occupancy |= mask;
+    }
+
+    inline void board::remove_piece(data_t& data, size_t square) {
+        auto& piece = data.pieces[square ^ 56];
+        if (piece.type == piece_type::none) {
+            return;
+        }
+
+        bitboard_t mask = bitboard::square_mask(square);
+        data.piece_masks[(size_t)piece.color][(size_t)piece.type] &= ~mask;
+        data.color_masks[(size_t)piece.color] &= ~mask;
+        data.occupancy &= ~mask;
+
+        piece = { piece_type::none };
+    }
 } // namespace libchess
\ No newline at end of file
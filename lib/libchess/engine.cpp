@@ -16,6 +16,9 @@
 
 #include "libchesspch.h"
 #include "engine.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "eval.h"
 #include "util.h"
 
 namespace libchess {
@@ -23,6 +26,7 @@ namespace libchess {
         if (m_board != _board) {
             clear_cache();
             m_board = _board;
+            m_undo_depth = 0;
 
             // should, in theory, return nullptr if m_board is nullptr as well, but just to be safe
             if (m_board) {
@@ -44,44 +48,50 @@ namespace libchess {
     void engine::find_pieces(const piece_query_t& query, std::vector<coord>& positions) {
         positions.clear();
 
-        for (int32_t y = 0; y < board::width; y++) {
-            for (int32_t x = 0; x < board::width; x++) {
-                auto pos = coord(x, y);
-
-                piece_info_t piece;
-                if (!m_board->get_piece(pos, &piece)) {
-                    continue;
-                }
+        bitboard_t mask;
+        if (query.color.has_value()) {
+            size_t color = (size_t)query.color.value();
+            if (query.type.has_value()) {
+                mask = m_board_data->piece_masks[color][(size_t)query.type.value()];
+            } else {
+                mask = m_board_data->color_masks[color];
+            }
+        } else if (query.type.has_value()) {
+            size_t type = (size_t)query.type.value();
+            mask = m_board_data->piece_masks[(size_t)player_color::white][type] |
+                   m_board_data->piece_masks[(size_t)player_color::black][type];
+        } else {
+            mask = m_board_data->occupancy;
+        }
 
-                if (query.type.has_value()) {
-                    if (piece.type != query.type.value()) {
-                        continue;
-                    }
-                }
+        if (query.x.has_value()) {
+            mask &= bitboard::file_mask(query.x.value());
+        }
 
-                if (query.color.has_value() && piece.color != query.color.value()) {
-                    continue;
-                }
+        if (query.y.has_value()) {
+            mask &= bitboard::rank_mask(query.y.value());
+        }
 
-                if (query.x.has_value() && query.x != x) {
-                    continue;
-                }
+        // ascending square order is a1, b1, ..., h8 - the same order as the old scan
+        while (mask != 0) {
+            auto pos = bitboard::get_coord(bitboard::pop_lsb(mask));
 
-                if (query.y.has_value() && query.y != y) {
-                    continue;
-                }
+            if (query.filter != nullptr) {
+                piece_info_t piece;
+                m_board->get_piece(pos, &piece);
 
-                if (query.filter != nullptr && !(query.filter(pos, piece, query.filter_data))) {
+                if (!query.filter(pos, piece, query.filter_data)) {
                     continue;
                 }
-
-                positions.push_back(pos);
             }
+
+            positions.push_back(pos);
         }
     }
 
     bool engine::compute_check(player_color color, std::vector<coord>& pieces) {
         pieces.clear();
+        validate_cache();
         if (m_checking_pieces_cache.find(color) != m_checking_pieces_cache.end()) {
             const auto& checking_pieces = m_checking_pieces_cache.at(color);
             pieces.insert(pieces.end(), checking_pieces.begin(), checking_pieces.end());
@@ -89,15 +99,14 @@ namespace libchess {
             return !pieces.empty();
         }
 
-        piece_query_t query;
-        query.type = piece_type::king;
-        query.color = color;
+        player_color opposing =
+            color != player_color::white ? player_color::white : player_color::black;
 
-        std::vector<coord> kings;
-        find_pieces(query, kings);
+        bitboard_t kings = m_board_data->piece_masks[(size_t)color][(size_t)piece_type::king];
+        bitboard_t attackers = compute_attackers(kings, opposing);
 
-        if (kings.size() > 0) {
-            compute_check_internal(color, kings, pieces);
+        while (attackers != 0) {
+            pieces.push_back(bitboard::get_coord(bitboard::pop_lsb(attackers)));
         }
 
         m_checking_pieces_cache.insert(std::make_pair(color, pieces));
@@ -109,314 +118,566 @@ namespace libchess {
             return false;
         }
 
+        validate_cache();
         if (m_checkmate_cache.has_value()) {
             return m_checkmate_cache.value();
         }
 
-        piece_query_t query;
-        query.color = color;
-
-        std::vector<coord> pieces;
-        find_pieces(query, pieces);
-
-        bool checkmate = true;
-        for (const auto& piece : pieces) {
-            std::list<coord> legal_moves;
-            compute_legal_moves(piece, legal_moves);
-
-            if (!legal_moves.empty()) {
-                checkmate = false;
-                break;
-            }
-        }
+        move_list moves;
+        generate_legal_moves(moves);
 
+        bool checkmate = moves.empty();
         m_checkmate_cache = checkmate;
         return checkmate;
     }
 
-    enum piece_movement_type : uint32_t {
-        piece_movement_type_unique = 0,
-        piece_movement_type_rook = (1 << 0),
-        piece_movement_type_bishop = (1 << 1)
-    };
-
-    // spaghetti-esque
-    // yknow what no it *is* spaghetti code this shit is awful
-    // i am never touching this again
     bool engine::compute_legal_moves(const coord& pos, std::list<coord>& destinations) {
         destinations.clear();
 
-        std::string serialized = util::serialize_coordinate(pos);
-        if (m_legal_move_cache.find(serialized) != m_legal_move_cache.end()) {
-            const auto& moves = m_legal_move_cache.at(serialized);
+        piece_info_t piece;
+        if (!m_board->get_piece(pos, &piece)) {
+            return false;
+        }
+
+        validate_cache();
+
+        size_t square = bitboard::get_square(pos);
+        if (m_legal_move_cache.find(square) != m_legal_move_cache.end()) {
+            const auto& moves = m_legal_move_cache.at(square);
             destinations.insert(destinations.end(), moves.begin(), moves.end());
 
             return true;
         }
 
-        piece_info_t piece;
-        if (!m_board->get_piece(pos, &piece)) {
-            return false;
+        // only the side to move is held to the rules of check
+        bitboard_t targets = compute_targets(square, piece);
+        if (piece.color == m_board_data->current_turn) {
+            targets = filter_legal_targets(square, piece, targets, compute_legality());
         }
 
-        static const std::vector<int32_t> direction_factors = { 1, -1 };
-        uint32_t movement_type = piece_movement_type_unique;
+        while (targets != 0) {
+            destinations.push_back(bitboard::get_coord(bitboard::pop_lsb(targets)));
+        }
 
-        switch (piece.type) {
-        case piece_type::king: {
-            static const std::vector<int32_t> king_direction_factors = { 1, 0, -1 };
-            for (size_t i = 0; i < king_direction_factors.size(); i++) {
-                int32_t x_factor = king_direction_factors[i];
+        m_legal_move_cache.insert(std::make_pair(square, destinations));
+        return true;
+    }
 
-                for (size_t j = 0; j < king_direction_factors.size(); j++) {
-                    int32_t y_factor = king_direction_factors[j];
+    bitboard_t engine::compute_legal_targets(size_t square) {
+        const auto& piece = m_board_data->pieces[square ^ 56];
+        if (piece.type == piece_type::none) {
+            return 0;
+        }
 
-                    coord delta(x_factor, y_factor);
-                    coord dst = pos + delta;
-                    if (delta.taxicab_length() == 0 || board::is_out_of_bounds(dst)) {
-                        continue;
-                    }
+        bitboard_t targets = compute_targets(square, piece);
+        if (piece.color == m_board_data->current_turn) {
+            targets = filter_legal_targets(square, piece, targets, compute_legality());
+        }
 
-                    piece_info_t temp;
-                    if (m_board->get_piece(dst, &temp) && temp.color == piece.color) {
-                        continue;
-                    }
+        return targets;
+    }
 
-                    destinations.push_back(dst);
-                }
-            }
+    bitboard_t engine::compute_checkers() { return compute_legality().checkers; }
 
-            uint8_t castling_flags = m_board_data->player_castling_availability.at(piece.color);
-            std::vector<std::tuple<int32_t, int32_t>> castling_directions;
+    void engine::generate_legal_moves(move_list& moves) {
+        moves.clear();
 
-            if ((castling_flags & castle_side_queen) != castle_side_none) {
-                castling_directions.push_back(std::make_tuple(-1, -1));
-            }
+        const auto& data = *m_board_data;
+        const auto& legality = compute_legality();
 
-            if ((castling_flags & castle_side_king) != castle_side_none) {
-                castling_directions.push_back(std::make_tuple(1, (int32_t)board::width));
-            }
+        player_color color = data.current_turn;
+        bitboard_t pieces = data.color_masks[(size_t)color];
 
-            for (auto [direction, limit] : castling_directions) {
-                bool castling_valid = false;
-                for (int32_t x = pos.x + direction; x != limit; x += direction) {
-                    piece_info_t current_piece;
-                    if (m_board->get_piece(coord(x, pos.y), &current_piece)) {
-                        if (current_piece.type == piece_type::rook) {
-                            castling_valid = true;
-                        } else {
-                            castling_valid = false;
-                            break;
-                        }
-                    }
-                }
+        // only the king can answer a double check
+        if (bitboard::popcount(legality.checkers) > 1) {
+            pieces &= data.piece_masks[(size_t)color][(size_t)piece_type::king];
+        }
 
-                if (castling_valid) {
-                    coord dst = pos + coord(direction * 2, 0);
+        bitboard_t last_rank = color == player_color::white ? bitboard::rank_8 : bitboard::rank_1;
+        static const std::array<piece_type, 4> promotions = { piece_type::queen, piece_type::rook,
+                                                              piece_type::bishop,
+                                                              piece_type::knight };
 
-                    std::vector<coord> king_positions;
-                    for (int32_t x = pos.x; x != dst.x + direction; x += direction) {
-                        king_positions.push_back(coord(x, pos.y));
-                    }
+        bitboard_t en_passant = 0;
+        if (data.en_passant_target.has_value()) {
+            size_t target = bitboard::get_square(data.en_passant_target.value());
+            en_passant = bitboard::square_mask(target);
+        }
 
-                    std::vector<coord> checking_pieces;
-                    if (piece.color == m_board_data->current_turn) {
-                        compute_check_internal(piece.color, king_positions, checking_pieces);
-                    }
+        while (pieces != 0) {
+            size_t square = bitboard::pop_lsb(pieces);
+            const auto& piece = data.pieces[square ^ 56];
+
+            bitboard_t targets = compute_targets(square, piece);
+            targets = filter_legal_targets(square, piece, targets, legality);
+
+            if (piece.type == piece_type::pawn) {
+                bitboard_t promoting = targets & last_rank;
+                targets &= ~promoting;
 
-                    if (checking_pieces.empty()) {
-                        destinations.push_back(dst);
+                while (promoting != 0) {
+                    size_t destination = bitboard::pop_lsb(promoting);
+                    for (auto promotion : promotions) {
+                        moves.push_back(packed_move_t::create(
+                            square, destination, packed_move_t::flag_promotion, promotion));
                     }
                 }
+
+                if ((targets & en_passant) != 0) {
+                    targets &= ~en_passant;
+                    moves.push_back(packed_move_t::create(square, bitboard::lsb(en_passant),
+                                                          packed_move_t::flag_en_passant));
+                }
+            } else if (piece.type == piece_type::king) {
+                // castling is the only way for a king to move two files
+                bitboard_t castling = targets & ~attacks::king(square);
+                targets &= ~castling;
+
+                while (castling != 0) {
+                    moves.push_back(packed_move_t::create(square, bitboard::pop_lsb(castling),
+                                                          packed_move_t::flag_castling));
+                }
+            }
+
+            while (targets != 0) {
+                moves.push_back(packed_move_t::create(square, bitboard::pop_lsb(targets)));
             }
-        } break;
+        }
+    }
+
+    static bool is_promotion_valid(const move_t& move, const piece_info_t& piece) {
+        if (move.promotion == piece_type::none) {
+            return true;
+        }
+
+        int32_t last_rank = piece.color == player_color::white ? ((int32_t)board::width - 1) : 0;
+        if (piece.type != piece_type::pawn || move.destination.y != last_rank) {
+            return false;
+        }
+
+        switch (move.promotion) {
         case piece_type::queen:
-            movement_type = piece_movement_type_rook | piece_movement_type_bishop;
-            break;
         case piece_type::rook:
-            movement_type = piece_movement_type_rook;
-            break;
-        case piece_type::knight: {
-            static const std::vector<coord> knight_offsets = { coord(2, 1), coord(1, 2) };
-            for (size_t i = 0; i < direction_factors.size(); i++) {
-                int32_t x_factor = direction_factors[i];
-
-                for (size_t j = 0; j < direction_factors.size(); j++) {
-                    int32_t y_factor = direction_factors[j];
-                    coord direction = coord(x_factor, y_factor);
-
-                    for (size_t k = 0; k < knight_offsets.size(); k++) {
-                        coord offset = knight_offsets[k];
-                        coord destination = pos + (direction * offset);
-
-                        if (board::is_out_of_bounds(destination)) {
-                            continue;
-                        }
-
-                        piece_info_t temp_piece;
-                        if (m_board->get_piece(destination, &temp_piece) &&
-                            temp_piece.color == piece.color) {
-                            continue;
-                        }
-
-                        destinations.push_back(destination);
-                    }
-                }
-            }
-        } break;
+        case piece_type::knight:
         case piece_type::bishop:
-            movement_type = piece_movement_type_bishop;
-            break;
-        case piece_type::pawn: { // impossible for a pawn to move out of bounds i think
-            int32_t step_direction = piece.color == player_color::white ? 1 : -1;
-            coord step = coord(0, step_direction);
+            return true;
+        default:
+            return false;
+        }
+    }
 
-            coord single_step = pos + step;
-            if (!m_board->get_piece(single_step, nullptr)) {
-                destinations.push_back(single_step);
+    bool engine::is_move_legal(const move_t& move) {
+        piece_info_t piece;
+        if (!m_board->get_piece(move.position, &piece) || !is_promotion_valid(move, piece)) {
+            return false;
+        }
 
-                int32_t starting_y = piece.color == player_color::white ? 1 : (board::width - 2);
-                coord double_step = single_step + step;
+        std::list<coord> legal_moves;
+        if (!compute_legal_moves(move.position, legal_moves)) {
+            return false;
+        }
 
-                if (pos.y == starting_y && !m_board->get_piece(double_step, nullptr)) {
-                    destinations.push_back(double_step);
-                }
-            }
+        return std::find(legal_moves.begin(), legal_moves.end(), move.destination) !=
+               legal_moves.end();
+    }
 
-            piece_info_t temp_piece;
-            for (size_t i = 0; i < direction_factors.size(); i++) {
-                int32_t capture_direction = direction_factors[i];
-                coord capture_step = single_step + coord(capture_direction, 0);
+    bool engine::commit_move(const move_t& move, bool check_legality, bool advance_turn) {
+        piece_info_t piece;
+        if (!m_board->get_piece(move.position, &piece) ||
+            board::is_out_of_bounds(move.destination)) {
+            return false;
+        }
 
-                if ((m_board->get_piece(capture_step, &temp_piece) &&
-                     temp_piece.color != piece.color) ||
-                    m_board_data->en_passant_target == capture_step) {
-                    destinations.push_back(capture_step);
-                }
-            }
-        } break;
-        default:
+        if (check_legality && !is_move_legal(move)) {
             return false;
         }
 
-        // this part especially is awful
-        {
-            std::vector<coord> movement_directions;
-            if ((movement_type & piece_movement_type_rook) != piece_movement_type_unique) {
-                for (size_t i = 0; i < direction_factors.size(); i++) {
-                    int32_t factor = direction_factors[i];
-                    movement_directions.insert(movement_directions.end(),
-                                               { coord(factor, 0), coord(0, factor) });
-                }
-            }
+        move_undo_t undo;
+        apply_move(move, undo, advance_turn);
+        clear_cache();
 
-            if ((movement_type & piece_movement_type_bishop) != piece_movement_type_unique) {
-                for (size_t i = 0; i < direction_factors.size(); i++) {
-                    int32_t x_factor = direction_factors[i];
+        if (undo.captured.type != piece_type::none && m_capture_callback != nullptr) {
+            m_capture_callback(undo.captured, m_callback_data);
+        }
 
-                    for (size_t j = 0; j < direction_factors.size(); j++) {
-                        int32_t y_factor = direction_factors[j];
-                        movement_directions.push_back(coord(x_factor, y_factor));
-                    }
-                }
-            }
+        return true;
+    }
 
-            for (const auto& direction : movement_directions) {
-                coord current_pos = pos;
-                while (true) {
-                    current_pos += direction;
-                    if (board::is_out_of_bounds(current_pos)) {
-                        break;
-                    }
+    bool engine::make_move(const move_t& move) {
+        if (m_undo_depth >= max_undo_depth || !m_board->get_piece(move.position, nullptr) ||
+            board::is_out_of_bounds(move.destination)) {
+            return false;
+        }
 
-                    piece_info_t current_piece;
-                    if (m_board->get_piece(current_pos, &current_piece)) {
-                        if (current_piece.color != piece.color) {
-                            destinations.push_back(current_pos);
-                        }
+        // the caches are keyed by position, so they don't need to be cleared here
+        apply_move(move, m_undo_stack[m_undo_depth++], true);
+        return true;
+    }
 
-                        break;
-                    } else {
-                        destinations.push_back(current_pos);
-                    }
-                }
+    bool engine::unmake_move() {
+        if (m_undo_depth == 0) {
+            return false;
+        }
+
+        revert_move(m_undo_stack[--m_undo_depth]);
+        return true;
+    }
+
+    void engine::clear_cache() {
+        // clearing an empty map still touches every bucket
+        if (!m_legal_move_cache.empty()) {
+            m_legal_move_cache.clear();
+        }
+
+        if (!m_checking_pieces_cache.empty()) {
+            m_checking_pieces_cache.clear();
+        }
+
+        m_checkmate_cache.reset();
+        m_legality_cache.reset();
+
+        // todo: clear caches as they're added
+    }
+
+    bool engine::probe_tablebase(tablebase_result_t& result) const {
+        return m_tablebases && m_board_data != nullptr &&
+               m_tablebases->probe(*m_board_data, result);
+    }
+
+    bool engine::get_piece(const coord& pos, piece_info_t* piece) const {
+        return m_board->get_piece(pos, piece);
+    }
+
+    bool engine::set_piece(const coord& pos, const piece_info_t& piece) const {
+        return m_board->set_piece(pos, piece);
+    }
+
+    std::string engine::serialize_board() const { return m_board->serialize(); }
+
+    size_t engine::serialize_board(char* buffer, size_t buffer_size) const {
+        return board::serialize(*m_board_data, buffer, buffer_size);
+    }
+    player_color engine::get_current_turn() const { return m_board_data->current_turn; }
+
+    uint8_t engine::get_player_castling_availability(player_color player) const {
+        return m_board_data->player_castling_availability.at(player);
+    }
+
+    const std::optional<coord>& engine::get_en_passant_target() const {
+        return m_board_data->en_passant_target;
+    }
+
+    uint64_t engine::get_halfmove_clock() const { return m_board_data->halfmove_clock; }
+    uint64_t engine::get_fullmove_count() const { return m_board_data->fullmove_count; }
+    uint64_t engine::get_key() const { return m_board_data->key; }
+
+    void engine::validate_cache() {
+        if (m_cache_key != m_board_data->key) {
+            clear_cache();
+            m_cache_key = m_board_data->key;
+        }
+    }
+
+    bitboard_t engine::compute_attackers(bitboard_t targets, player_color color) const {
+        bitboard_t attackers = 0;
+        while (targets != 0) {
+            size_t square = bitboard::pop_lsb(targets);
+            attackers |=
+                attacks::get_attackers(*m_board_data, square, color, m_board_data->occupancy);
+        }
+
+        return attackers;
+    }
+
+    const engine::legality_info_t& engine::compute_legality() {
+        validate_cache();
+        if (m_legality_cache.has_value()) {
+            return m_legality_cache.value();
+        }
+
+        const auto& data = *m_board_data;
+        player_color color = data.current_turn;
+        player_color opposing =
+            color != player_color::white ? player_color::white : player_color::black;
+
+        legality_info_t legality;
+        legality.checkers = legality.pinned = 0;
+        legality.check_mask = ~(bitboard_t)0;
+
+        bitboard_t kings = data.piece_masks[(size_t)color][(size_t)piece_type::king];
+        if (bitboard::popcount(kings) != 1) {
+            legality.king_square = board::size;
+            return m_legality_cache.emplace(legality);
+        }
+
+        size_t king = legality.king_square = bitboard::lsb(kings);
+        legality.checkers = attacks::get_attackers(data, king, opposing, data.occupancy);
+
+        // a single check can be blocked or captured. a double check can only be walked out of
+        switch (bitboard::popcount(legality.checkers)) {
+        case 0:
+            break;
+        case 1:
+            legality.check_mask = legality.checkers |
+                                  attacks::between(king, bitboard::lsb(legality.checkers));
+            break;
+        default:
+            legality.check_mask = 0;
+            break;
+        }
+
+        // sliders that would see the king if it weren't for exactly one of our pieces
+        const auto& opposing_masks = data.piece_masks[(size_t)opposing];
+        bitboard_t opposing_occupancy = data.color_masks[(size_t)opposing];
+        bitboard_t queens = opposing_masks[(size_t)piece_type::queen];
+
+        bitboard_t snipers =
+            (attacks::rook(king, opposing_occupancy) &
+             (opposing_masks[(size_t)piece_type::rook] | queens)) |
+            (attacks::bishop(king, opposing_occupancy) &
+             (opposing_masks[(size_t)piece_type::bishop] | queens));
+
+        while (snipers != 0) {
+            size_t sniper = bitboard::pop_lsb(snipers);
+            bitboard_t blockers = attacks::between(king, sniper) & data.occupancy;
+            if (bitboard::popcount(blockers) == 1) {
+                legality.pinned |= blockers & data.color_masks[(size_t)color];
             }
         }
 
-        if (piece.color == m_board_data->current_turn) {
-            move_t move;
-            move.position = pos;
+        return m_legality_cache.emplace(legality);
+    }
+
+    bitboard_t engine::compute_targets(size_t square, const piece_info_t& piece) {
+        bitboard_t occupancy = m_board_data->occupancy;
+        bitboard_t own = m_board_data->color_masks[(size_t)piece.color];
 
-            engine temp_engine;
-            auto it = destinations.begin();
+        switch (piece.type) {
+        case piece_type::king: {
+            bitboard_t targets = attacks::king(square) & ~own;
+            coord pos = bitboard::get_coord(square);
+
+            player_color opposing =
+                piece.color != player_color::white ? player_color::white : player_color::black;
+
+            const auto& own_masks = m_board_data->piece_masks[(size_t)piece.color];
+            bitboard_t rooks = own_masks[(size_t)piece_type::rook];
+            uint8_t castling_flags = m_board_data->player_castling_availability.at(piece.color);
 
-            while (it != destinations.end()) {
-                move.destination = *it;
+            for (auto side : { castle_side_queen, castle_side_king }) {
+                if ((castling_flags & side) == castle_side_none) {
+                    continue;
+                }
+
+                // the rook has to be in the corner, with nothing in between
+                int32_t direction = side == castle_side_king ? 1 : -1;
+                int32_t rook_x = side == castle_side_king ? ((int32_t)board::width - 1) : 0;
 
-                piece_info_t temp_piece;
-                if (m_board->get_piece(move.destination, &temp_piece) &&
-                    temp_piece.type == piece_type::king) {
-                    it++;
+                size_t rook_square = bitboard::get_square(rook_x, pos.y);
+                if ((rooks & bitboard::square_mask(rook_square)) == 0 ||
+                    (attacks::between(square, rook_square) & occupancy) != 0) {
                     continue;
                 }
 
-                auto new_board = board::copy(m_board);
-                temp_engine.set_board(new_board);
-                temp_engine.commit_move(move, false, false);
+                // the king may not castle out of, through, or into check
+                coord dst = pos + coord(direction * 2, 0);
+                if (board::is_out_of_bounds(dst)) {
+                    continue;
+                }
 
-                std::vector<coord> pieces;
-                temp_engine.compute_check(piece.color, pieces);
+                size_t dst_square = bitboard::get_square(dst);
+                bitboard_t king_path = attacks::between(square, dst_square) |
+                                       bitboard::square_mask(square) |
+                                       bitboard::square_mask(dst_square);
 
-                if (pieces.size() > 0) {
-                    it = destinations.erase(it);
-                } else {
-                    it++;
+                if (piece.color == m_board_data->current_turn &&
+                    compute_attackers(king_path, opposing) != 0) {
+                    continue;
                 }
+
+                targets |= bitboard::square_mask(dst_square);
             }
+
+            return targets;
         }
+        case piece_type::queen:
+            return attacks::queen(square, occupancy) & ~own;
+        case piece_type::rook:
+            return attacks::rook(square, occupancy) & ~own;
+        case piece_type::knight:
+            return attacks::knight(square) & ~own;
+        case piece_type::bishop:
+            return attacks::bishop(square, occupancy) & ~own;
+        case piece_type::pawn: {
+            bitboard_t origin = bitboard::square_mask(square);
+            bitboard_t single_step, double_step;
+
+            if (piece.color == player_color::white) {
+                single_step = bitboard::shift_north(origin) & ~occupancy;
+                double_step = bitboard::shift_north(single_step & bitboard::rank_mask(2));
+            } else {
+                single_step = bitboard::shift_south(origin) & ~occupancy;
+                double_step = bitboard::shift_south(single_step & bitboard::rank_mask(5));
+            }
 
-        m_legal_move_cache.insert(std::make_pair(serialized, destinations));
-        return true;
+            double_step &= ~occupancy;
+
+            bitboard_t capturable = occupancy & ~own;
+            if (m_board_data->en_passant_target.has_value()) {
+                const auto& target = m_board_data->en_passant_target.value();
+                capturable |= bitboard::square_mask(bitboard::get_square(target));
+            }
+
+            return single_step | double_step | (attacks::pawn(piece.color, square) & capturable);
+        }
+        default:
+            return 0;
+        }
     }
 
-    bool engine::is_move_legal(const move_t& move) {
-        std::list<coord> legal_moves;
-        if (!compute_legal_moves(move.position, legal_moves)) {
-            return false;
+    bitboard_t engine::filter_legal_targets(size_t square, const piece_info_t& piece,
+                                            bitboard_t targets, const legality_info_t& legality) {
+        const auto& data = *m_board_data;
+        if (legality.king_square >= board::size) {
+            return filter_targets_by_trial(square, targets);
         }
 
-        return std::find(legal_moves.begin(), legal_moves.end(), move.destination) !=
-               legal_moves.end();
-    }
+        player_color opposing =
+            piece.color != player_color::white ? player_color::white : player_color::black;
 
-    bool engine::commit_move(const move_t& move, bool check_legality, bool advance_turn) {
-        piece_info_t piece;
-        if (!m_board->get_piece(move.position, &piece) ||
-            board::is_out_of_bounds(move.destination)) {
-            return false;
+        size_t king = legality.king_square;
+        if (square == king) {
+            // the king can't hide behind itself from a slider
+            bitboard_t occupancy = data.occupancy ^ bitboard::square_mask(square);
+            bitboard_t result = 0;
+
+            while (targets != 0) {
+                size_t target = bitboard::pop_lsb(targets);
+
+                // castling was already checked for attacked squares
+                bool castle = std::abs((int32_t)target - (int32_t)square) == 2;
+                if (castle || attacks::get_attackers(data, target, opposing, occupancy) == 0) {
+                    result |= bitboard::square_mask(target);
+                }
+            }
+
+            return result;
         }
 
-        if (check_legality && !is_move_legal(move)) {
-            return false;
+        if (bitboard::popcount(legality.checkers) > 1) {
+            return 0;
         }
 
-        bool reset_halfmove_clock = false;
-        if (piece.type == piece_type::pawn) {
-            reset_halfmove_clock = true;
+        // en passant is the only move that takes a piece off of a square it doesn't land on
+        bitboard_t en_passant = 0;
+        if (piece.type == piece_type::pawn && data.en_passant_target.has_value()) {
+            size_t target = bitboard::get_square(data.en_passant_target.value());
+            en_passant = targets & bitboard::square_mask(target) & ~data.occupancy;
+            targets &= ~en_passant;
+        }
+
+        bitboard_t result = targets & legality.check_mask;
+        if ((legality.pinned & bitboard::square_mask(square)) != 0) {
+            result &= attacks::line(king, square);
+        }
+
+        if (en_passant != 0) {
+            size_t target = bitboard::lsb(en_passant);
+            size_t captured = bitboard::get_square((int32_t)(target % board::width),
+                                                   (int32_t)(square / board::width));
+
+            // both pawns leave the rank at once, which can expose the king
+            bitboard_t occupancy = (data.occupancy ^ bitboard::square_mask(square) ^
+                                    bitboard::square_mask(captured)) |
+                                   en_passant;
+
+            const auto& opposing_masks = data.piece_masks[(size_t)opposing];
+            bitboard_t queens = opposing_masks[(size_t)piece_type::queen];
+            bitboard_t sliders = (attacks::rook(king, occupancy) &
+                                  (opposing_masks[(size_t)piece_type::rook] | queens)) |
+                                 (attacks::bishop(king, occupancy) &
+                                  (opposing_masks[(size_t)piece_type::bishop] | queens));
+
+            bitboard_t leapers = legality.checkers & ~bitboard::square_mask(captured) &
+                                 ~(opposing_masks[(size_t)piece_type::rook] |
+                                   opposing_masks[(size_t)piece_type::bishop] | queens);
+
+            if (sliders == 0 && leapers == 0) {
+                result |= en_passant;
+            }
         }
 
-        coord capture_position;
-        if (piece.type == piece_type::pawn && m_board_data->en_passant_target == move.destination) {
-            capture_position = coord(move.destination.x, move.position.y);
+        return result;
+    }
+
+    bitboard_t engine::filter_targets_by_trial(size_t square, bitboard_t targets) {
+        const auto& data = *m_board_data;
+        player_color color = data.current_turn;
+        player_color opposing =
+            color != player_color::white ? player_color::white : player_color::black;
+
+        // a reference, so that king moves are picked up
+        const auto& kings = data.piece_masks[(size_t)color][(size_t)piece_type::king];
+
+        move_t move;
+        move.position = bitboard::get_coord(square);
+
+        move_undo_t undo;
+        bitboard_t result = 0;
+
+        while (targets != 0) {
+            size_t target = bitboard::pop_lsb(targets);
+            move.destination = bitboard::get_coord(target);
+
+            // try the move in place and take it right back
+            apply_move(move, undo, false);
+            bool in_check = compute_attackers(kings, opposing) != 0;
+            revert_move(undo);
+
+            if (!in_check) {
+                result |= bitboard::square_mask(target);
+            }
+        }
+
+        return result;
+    }
+
+    void engine::apply_move(const move_t& move, move_undo_t& undo, bool advance_turn) {
+        auto& data = *m_board_data;
+
+        undo.position = bitboard::get_square(move.position);
+        undo.destination = bitboard::get_square(move.destination);
+        undo.piece = data.pieces[undo.position ^ 56];
+        undo.rook_position = undo.rook_destination = board::size;
+        undo.castling_availability = data.player_castling_availability;
+        undo.en_passant_target = data.en_passant_target;
+        undo.halfmove_clock = data.halfmove_clock;
+        undo.fullmove_count = data.fullmove_count;
+        undo.key = data.key;
+        undo.eval = data.eval;
+        undo.current_turn = data.current_turn;
+
+        uint64_t key = data.key;
+        key ^= zobrist::castling(data.player_castling_availability);
+        key ^= zobrist::en_passant(data.en_passant_target);
+
+        const auto& piece = undo.piece;
+        bool reset_halfmove_clock = piece.type == piece_type::pawn;
+
+        if (piece.type == piece_type::pawn && data.en_passant_target == move.destination) {
+            undo.capture_position = bitboard::get_square(move.destination.x, move.position.y);
         } else {
-            capture_position = move.destination;
+            undo.capture_position = undo.destination;
         }
 
-        piece_info_t captured;
-        if (m_board->get_piece(capture_position, &captured)) {
-            if (captured.type == piece_type::rook && capture_position.y == (captured.color == player_color::white ? 0 : board::width - 1))
-            {
-                uint8_t& availability = m_board->get_data().player_castling_availability[captured.color];
+        undo.captured = data.pieces[undo.capture_position ^ 56];
+        if (undo.captured.type != piece_type::none) {
+            const auto& captured = undo.captured;
+            coord capture_position = bitboard::get_coord(undo.capture_position);
+
+            int32_t home_rank = captured.color == player_color::white ? 0 : board::width - 1;
+            if (captured.type == piece_type::rook && capture_position.y == home_rank) {
+                uint8_t& availability = data.player_castling_availability[captured.color];
                 switch (capture_position.x) {
                 case 0:
                     availability &= ~castle_side_queen;
@@ -427,126 +688,111 @@ namespace libchess {
                 }
             }
 
-            if (m_capture_callback != nullptr) {
-                m_capture_callback(captured, m_callback_data);
-            }
-
-            m_board->set_piece(capture_position, { piece_type::none });
+            key ^= zobrist::piece(captured, undo.capture_position);
+            eval::remove(data.eval, captured, undo.capture_position);
+            board::remove_piece(data, undo.capture_position);
             reset_halfmove_clock = true;
         }
 
-        clear_cache();
-        m_board->set_piece(move.position, { piece_type::none });
-        m_board->set_piece(move.destination, piece);
+        piece_info_t placed = piece;
+        if (piece.type == piece_type::pawn && move.promotion != piece_type::none) {
+            placed.type = move.promotion;
+        }
+
+        key ^= zobrist::piece(piece, undo.position) ^ zobrist::piece(placed, undo.destination);
+        eval::remove(data.eval, piece, undo.position);
+        eval::add(data.eval, placed, undo.destination);
+        board::remove_piece(data, undo.position);
+        board::place_piece(data, undo.destination, placed);
 
         coord delta = move.destination - move.position;
         if (piece.type == piece_type::pawn && std::abs(delta.y) == 2) {
-            m_board_data->en_passant_target = move.position + coord(0, delta.y / 2);
+            data.en_passant_target = move.position + coord(0, delta.y / 2);
         } else {
-            m_board_data->en_passant_target.reset();
+            data.en_passant_target.reset();
         }
 
         if (piece.type == piece_type::king) {
-            m_board_data->player_castling_availability[piece.color] = castle_side_none;
+            data.player_castling_availability[piece.color] = castle_side_none;
 
             if (std::abs(delta.x) == 2) {
-
                 int32_t direction = delta.x / std::abs(delta.x);
                 int32_t rook_x = (direction > 0) ? ((int32_t)board::width - 1) : 0;
-                auto rook_pos = coord(rook_x, move.position.y);
-
-                piece_info_t rook;
-                m_board->get_piece(rook_pos, &rook);
-
-                m_board->set_piece(rook_pos, { piece_type::none });
-                m_board->set_piece(coord(move.destination.x - direction, move.destination.y), rook);
+                size_t rook_position = bitboard::get_square(rook_x, move.position.y);
+
+                // unchecked moves can hop the king two files without a rook to bring along
+                piece_info_t rook = data.pieces[rook_position ^ 56];
+                if (rook.type == piece_type::rook && rook.color == piece.color) {
+                    undo.rook_position = rook_position;
+                    undo.rook_destination =
+                        bitboard::get_square(move.destination.x - direction, move.destination.y);
+
+                    key ^= zobrist::piece(rook, undo.rook_position);
+                    key ^= zobrist::piece(rook, undo.rook_destination);
+                    eval::remove(data.eval, rook, undo.rook_position);
+                    eval::add(data.eval, rook, undo.rook_destination);
+
+                    board::remove_piece(data, undo.rook_position);
+                    board::place_piece(data, undo.rook_destination, rook);
+                }
             }
         }
 
         if (piece.type == piece_type::rook) {
-            static const std::unordered_map<castle_side, int32_t> starting_rook_positions = {
-                { castle_side::castle_side_queen, 0 },
-                { castle_side::castle_side_king, (int32_t)board::width - 1 }
-            };
-
             int32_t y = piece.color == player_color::white ? 0 : (board::width - 1);
-            for (auto [side, x] : starting_rook_positions) {
-                if (move.position == coord(x, y)) {
-                    m_board_data->player_castling_availability[piece.color] &= ~side;
-                    break;
-                }
+            if (move.position == coord(0, y)) {
+                data.player_castling_availability[piece.color] &= ~castle_side_queen;
+            } else if (move.position == coord((int32_t)board::width - 1, y)) {
+                data.player_castling_availability[piece.color] &= ~castle_side_king;
             }
         }
 
+        key ^= zobrist::castling(data.player_castling_availability);
+        key ^= zobrist::en_passant(data.en_passant_target);
+
         // a little spaghetti-y
         if (advance_turn) {
             if (reset_halfmove_clock) {
-                m_board_data->halfmove_clock = 0;
+                data.halfmove_clock = 0;
             } else {
-                m_board_data->halfmove_clock++;
+                data.halfmove_clock++;
             }
 
-            if (m_board_data->current_turn == player_color::white) {
-                m_board_data->current_turn = player_color::black;
+            if (data.current_turn == player_color::white) {
+                data.current_turn = player_color::black;
             } else {
-                m_board_data->current_turn = player_color::white;
-                m_board_data->fullmove_count++;
+                data.current_turn = player_color::white;
+                data.fullmove_count++;
             }
-        }
-
-        return true;
-    }
-
-    void engine::clear_cache() {
-        m_legal_move_cache.clear();
-        m_checking_pieces_cache.clear();
-        m_checkmate_cache.reset();
-
-        // todo: clear caches as they're added
-    }
-
-    bool engine::get_piece(const coord& pos, piece_info_t* piece) const {
-        return m_board->get_piece(pos, piece);
-    }
-
-    bool engine::set_piece(const coord& pos, const piece_info_t& piece) const {
-        return m_board->set_piece(pos, piece);
-    }
 
-    std::string engine::serialize_board() const { return m_board->serialize(); }
-    player_color engine::get_current_turn() const { return m_board_data->current_turn; }
+            key ^= zobrist::keys.turn;
+        }
 
-    uint8_t engine::get_player_castling_availability(player_color player) const {
-        return m_board_data->player_castling_availability.at(player);
+        data.key = key;
     }
 
-    const std::optional<coord>& engine::get_en_passant_target() const {
-        return m_board_data->en_passant_target;
-    }
+    void engine::revert_move(const move_undo_t& undo) {
+        auto& data = *m_board_data;
 
-    uint64_t engine::get_halfmove_clock() const { return m_board_data->halfmove_clock; }
-    uint64_t engine::get_fullmove_count() const { return m_board_data->fullmove_count; }
-
-    void engine::compute_check_internal(player_color color, const std::vector<coord>& kings,
-                                        std::vector<coord>& pieces) {
-        player_color opposing =
-            color != player_color::white ? player_color::white : player_color::black;
-
-        piece_query_t query;
-        query.color = opposing;
-
-        std::vector<coord> opposing_pieces;
-        find_pieces(query, opposing_pieces);
+        if (undo.rook_position < board::size) {
+            piece_info_t rook = data.pieces[undo.rook_destination ^ 56];
+            board::remove_piece(data, undo.rook_destination);
+            board::place_piece(data, undo.rook_position, rook);
+        }
 
-        for (const auto& piece_pos : opposing_pieces) {
-            std::list<coord> legal_moves;
-            compute_legal_moves(piece_pos, legal_moves);
+        board::remove_piece(data, undo.destination);
+        board::place_piece(data, undo.position, undo.piece);
 
-            for (const auto& move : legal_moves) {
-                if (std::find(kings.begin(), kings.end(), move) != kings.end()) {
-                    pieces.push_back(piece_pos);
-                }
-            }
+        if (undo.captured.type != piece_type::none) {
+            board::place_piece(data, undo.capture_position, undo.captured);
         }
+
+        data.player_castling_availability = undo.castling_availability;
+        data.en_passant_target = undo.en_passant_target;
+        data.halfmove_clock = undo.halfmove_clock;
+        data.fullmove_count = undo.fullmove_count;
+        data.key = undo.key;
+        data.eval = undo.eval;
+        data.current_turn = undo.current_turn;
     }
 } // namespace libchess
\ No newline at end of file
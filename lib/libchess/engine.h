@@ -17,12 +17,10 @@
 #pragma once
 #include "board.h"
 #include "coord.h"
+#include "move_list.h"
+#include "tablebase.h"
 
 namespace libchess {
-    struct move_t {
-        coord position, destination;
-    };
-
     struct piece_query_t {
         std::optional<piece_type> type;
         std::optional<player_color> color;
@@ -32,9 +30,27 @@ namespace libchess {
         void* filter_data = nullptr;
     };
 
+    // everything needed to take back a move made with engine::make_move
+    struct move_undo_t {
+        size_t position, destination, capture_position;
+        piece_info_t piece, captured;
+
+        // both are board::size if the move was not a castle
+        size_t rook_position, rook_destination;
+
+        castling_availability_t castling_availability;
+        std::optional<coord> en_passant_target;
+        uint64_t halfmove_clock, fullmove_count;
+        uint64_t key;
+        eval_terms_t eval;
+        player_color current_turn;
+    };
+
     using piece_capture_callback_t = void (*)(const piece_info_t&, void*);
     class engine {
     public:
+        static constexpr size_t max_undo_depth = 512;
+
         engine() = default;
         ~engine() = default;
 
@@ -56,32 +72,107 @@ namespace libchess {
         bool compute_checkmate(player_color color);
 
         bool compute_legal_moves(const coord& pos, std::list<coord>& destinations);
+
+        // every legal move for the side to move, promotions included. en passant captures and
+        // castling are flagged (see packed_move_t)
+        void generate_legal_moves(move_list& moves);
+
+        // compute_legal_moves as a bitboard, for a square index (see bitboard.h). not cached
+        bitboard_t compute_legal_targets(size_t square);
+
+        // pieces giving check to the side to move
+        bitboard_t compute_checkers();
+
         bool is_move_legal(const move_t& move);
+        bool is_move_legal(packed_move_t move) { return is_move_legal(move.unpack()); }
+
         bool commit_move(const move_t& move, bool check_legality = true, bool advance_turn = true);
+        bool commit_move(packed_move_t move, bool check_legality = true, bool advance_turn = true) {
+            return commit_move(move.unpack(), check_legality, advance_turn);
+        }
+
+        // unchecked, reversible moves for exploring the game tree in place. does not allocate
+        bool make_move(const move_t& move);
+        bool make_move(packed_move_t move) { return make_move(move.unpack()); }
+        bool unmake_move();
+        size_t get_undo_depth() const { return m_undo_depth; }
+
+        // the last move made with make_move, or nullptr if there is none to unmake
+        const move_undo_t* get_last_undo() const {
+            return m_undo_depth > 0 ? &m_undo_stack[m_undo_depth - 1] : nullptr;
+        }
 
         void clear_cache();
 
+        // none by default. probe_tablebase fails without them
+        void set_tablebases(std::shared_ptr<tablebase_set> tablebases) {
+            m_tablebases = tablebases;
+        }
+
+        std::shared_ptr<tablebase_set> get_tablebases() const { return m_tablebases; }
+        bool probe_tablebase(tablebase_result_t& result) const;
+
         // board functions
         bool get_piece(const coord& pos, piece_info_t* piece) const;
         bool set_piece(const coord& pos, const piece_info_t& piece) const;
 
         std::string serialize_board() const;
+        size_t serialize_board(char* buffer, size_t buffer_size) const;
         player_color get_current_turn() const;
         uint8_t get_player_castling_availability(player_color player) const;
         const std::optional<coord>& get_en_passant_target() const;
         uint64_t get_halfmove_clock() const;
         uint64_t get_fullmove_count() const;
+        uint64_t get_key() const;
 
     private:
-        void compute_check_internal(player_color color, const std::vector<coord>& kings,
-                                    std::vector<coord>& pieces);
+        struct legality_info_t {
+            // pieces giving check, and the squares a move other than a king move has to land on
+            bitboard_t checkers, check_mask;
+
+            // pieces that can only move along the line between their king and the attacker
+            bitboard_t pinned;
+
+            // board::size if the side to move doesn't have exactly one king
+            size_t king_square;
+        };
+
+        // clears the caches if the position changed since they were filled
+        void validate_cache();
+
+        // pieces of the given color attacking any of the target squares
+        bitboard_t compute_attackers(bitboard_t targets, player_color color) const;
+
+        // pin and check information for the side to move. cached
+        const legality_info_t& compute_legality();
+
+        // destinations for a piece, without regard for check
+        bitboard_t compute_targets(size_t square, const piece_info_t& piece);
+
+        bitboard_t filter_legal_targets(size_t square, const piece_info_t& piece,
+                                        bitboard_t targets, const legality_info_t& legality);
+
+        // the slow way - only used if the side to move doesn't have exactly one king
+        bitboard_t filter_targets_by_trial(size_t square, bitboard_t targets);
+
+        // the guts of commit_move and make_move. neither checks anything or touches the cache
+        void apply_move(const move_t& move, move_undo_t& undo, bool advance_turn);
+        void revert_move(const move_undo_t& undo);
 
         std::shared_ptr<board> m_board;
         board::data_t* m_board_data = nullptr; // convenience
 
-        std::unordered_map<std::string, std::list<coord>> m_legal_move_cache;
+        // only valid for the position with m_cache_key
+        std::unordered_map<size_t, std::list<coord>> m_legal_move_cache;
         std::unordered_map<player_color, std::vector<coord>> m_checking_pieces_cache;
         std::optional<bool> m_checkmate_cache;
+        std::optional<legality_info_t> m_legality_cache;
+        uint64_t m_cache_key = 0;
+
+        std::array<move_undo_t, max_undo_depth> m_undo_stack;
+        size_t m_undo_depth = 0;
+
+        std::shared_ptr<tablebase_set> m_tablebases;
 
         void* m_callback_data = nullptr;
         piece_capture_callback_t m_capture_callback = nullptr;
@@ -0,0 +1,207 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "epd.h"
+#include "mapped_file.h"
+
+namespace libchess {
+    static bool is_epd_space(char c) { return c == ' ' || c == '\t'; }
+
+    static std::string_view trim_epd_field(std::string_view field) {
+        while (!field.empty() && is_epd_space(field.front())) {
+            field.remove_prefix(1);
+        }
+
+        while (!field.empty() && is_epd_space(field.back())) {
+            field.remove_suffix(1);
+        }
+
+        return field;
+    }
+
+    static void parse_epd_operations(std::string_view text, epd_record_t& record) {
+        record.operation_count = 0;
+
+        size_t i = 0;
+        while (record.operation_count < epd_record_t::max_operations) {
+            while (i < text.length() && (is_epd_space(text[i]) || text[i] == ';')) {
+                i++;
+            }
+
+            if (i >= text.length()) {
+                break;
+            }
+
+            size_t opcode_start = i;
+            while (i < text.length() && !is_epd_space(text[i]) && text[i] != ';') {
+                i++;
+            }
+
+            auto& operation = record.operations[record.operation_count++];
+            operation.opcode = text.substr(opcode_start, i - opcode_start);
+
+            // semicolons inside a quoted string don't end the operation
+            size_t operands_start = i;
+            bool quoted = false;
+
+            while (i < text.length() && (quoted || text[i] != ';')) {
+                if (text[i] == '"') {
+                    quoted = !quoted;
+                }
+
+                i++;
+            }
+
+            operation.operands = trim_epd_field(text.substr(operands_start, i - operands_start));
+        }
+    }
+
+    std::optional<std::string_view> epd_record_t::find_operation(std::string_view opcode) const {
+        for (size_t i = 0; i < operation_count; i++) {
+            if (operations[i].opcode == opcode) {
+                return operations[i].operands;
+            }
+        }
+
+        return {};
+    }
+
+    std::shared_ptr<epd_reader> epd_reader::open(const std::string& path) {
+        auto file = mapped_file::open(path, file_access::sequential);
+        if (!file) {
+            return nullptr;
+        }
+
+        auto reader = std::shared_ptr<epd_reader>(new epd_reader);
+        reader->m_text = file->get_view();
+        reader->m_storage = file;
+
+        return reader;
+    }
+
+    std::shared_ptr<epd_reader> epd_reader::create(std::istream& stream) {
+        auto buffer = std::make_shared<std::string>(std::istreambuf_iterator<char>(stream),
+                                                    std::istreambuf_iterator<char>());
+
+        auto reader = std::shared_ptr<epd_reader>(new epd_reader);
+        reader->m_text = *buffer;
+        reader->m_storage = buffer;
+
+        return reader;
+    }
+
+    std::shared_ptr<epd_reader> epd_reader::create(std::string_view text) {
+        auto reader = std::shared_ptr<epd_reader>(new epd_reader);
+        reader->m_text = text;
+
+        return reader;
+    }
+
+    bool epd_reader::next(epd_record_t& record) {
+        while (m_offset < m_text.length()) {
+            const char* start = m_text.data() + m_offset;
+            size_t remaining = m_text.length() - m_offset;
+
+            // memchr is vectorized by every libc we build against
+            auto newline = (const char*)memchr(start, '\n', remaining);
+            size_t length = newline != nullptr ? (size_t)(newline - start) : remaining;
+
+            m_offset += newline != nullptr ? length + 1 : length;
+            m_line_number++;
+
+            std::string_view line(start, length);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+
+            auto trimmed = trim_epd_field(line);
+            if (trimmed.empty() || trimmed[0] == '#') {
+                continue;
+            }
+
+            record.line = line;
+            record.line_number = m_line_number;
+            record.operation_count = 0;
+
+            size_t end;
+            record.error = board::parse_fen_fields(line, record.data, true, end);
+            if (record.error != fen_error::none) {
+                return true;
+            }
+
+            parse_epd_operations(line.substr(end), record);
+
+            // explicit clocks take precedence over the defaults
+            for (size_t i = 0; i < record.operation_count; i++) {
+                const auto& operation = record.operations[i];
+
+                if (operation.opcode == "hmvc") {
+                    if (!board::parse_fen_counter(operation.operands,
+                                                  record.data.halfmove_clock)) {
+                        record.error = fen_error::halfmove_clock;
+                        break;
+                    }
+                } else if (operation.opcode == "fmvn") {
+                    if (!board::parse_fen_counter(operation.operands,
+                                                  record.data.fullmove_count)) {
+                        record.error = fen_error::fullmove_count;
+                        break;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void epd_reader::rewind() {
+        m_offset = 0;
+        m_line_number = 0;
+    }
+
+    void epd_reader::split(size_t count, std::vector<std::shared_ptr<epd_reader>>& chunks) const {
+        chunks.clear();
+        if (count == 0) {
+            return;
+        }
+
+        size_t start = 0;
+        for (size_t i = 1; i <= count && start < m_text.length(); i++) {
+            size_t end = m_text.length();
+
+            if (i < count) {
+                // cut after the first newline at or past the even split point
+                size_t target = std::max(m_text.length() * i / count, start);
+                auto newline = (const char*)memchr(m_text.data() + target, '\n',
+                                                   m_text.length() - target);
+
+                if (newline != nullptr) {
+                    end = (size_t)(newline - m_text.data()) + 1;
+                }
+            }
+
+            auto chunk = std::shared_ptr<epd_reader>(new epd_reader);
+            chunk->m_storage = m_storage;
+            chunk->m_text = m_text.substr(start, end - start);
+
+            chunks.push_back(chunk);
+            start = end;
+        }
+    }
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "board.h"
+
+namespace libchess {
+    struct epd_operation_t {
+        std::string_view opcode;
+
+        // everything up to the terminating semicolon, trimmed. quotes are left in
+        std::string_view operands;
+    };
+
+    struct epd_record_t {
+        static constexpr size_t max_operations = 32;
+
+        // without the line ending. views point into the reader's memory
+        std::string_view line;
+        size_t line_number;
+
+        // data is only valid if this is fen_error::none
+        fen_error error;
+        board::data_t data;
+
+        // operations past max_operations are dropped
+        std::array<epd_operation_t, max_operations> operations;
+        size_t operation_count;
+
+        // operands of the first operation with the given opcode
+        std::optional<std::string_view> find_operation(std::string_view opcode) const;
+    };
+
+    // reads epd lines, or fen lines optionally followed by epd operations, one record at a time.
+    // nothing is copied out of the input, and a record can be reused for every line
+    class epd_reader {
+    public:
+        // maps the file instead of reading it. nullptr if it can't be opened
+        static std::shared_ptr<epd_reader> open(const std::string& path);
+
+        // reads the whole stream into memory owned by the reader
+        static std::shared_ptr<epd_reader> create(std::istream& stream);
+
+        // does not copy - the text has to outlive the reader and anything split from it
+        static std::shared_ptr<epd_reader> create(std::string_view text);
+
+        ~epd_reader() = default;
+
+        epd_reader(const epd_reader&) = delete;
+        epd_reader& operator=(const epd_reader&) = delete;
+
+        // skips blank lines and lines starting with '#'. returns false at the end of the input.
+        // lines that fail to parse are still returned, with record.error set
+        bool next(epd_record_t& record);
+        void rewind();
+
+        // splits the input into at most count readers over roughly equal slices, cut at line
+        // boundaries, for handing to separate threads. line numbers restart in every chunk
+        void split(size_t count, std::vector<std::shared_ptr<epd_reader>>& chunks) const;
+
+        std::string_view get_text() const { return m_text; }
+
+    private:
+        epd_reader() = default;
+
+        // the mapping or buffer m_text points into, if the reader owns it
+        std::shared_ptr<const void> m_storage;
+
+        std::string_view m_text;
+        size_t m_offset = 0;
+        size_t m_line_number = 0;
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "board.h"
+
+namespace libchess::eval {
+    // the phase of the starting position. promotions can push a position past it
+    static constexpr int32_t max_phase = 24;
+
+    struct tables_t {
+        // indexed by color, piece type, and then square (see bitboard.h). the material and
+        // placement of a single piece, negated for black, and its share of the phase
+        std::array<std::array<std::array<eval_terms_t, board::size>, piece_type_count>,
+                   player_color_count>
+            pieces;
+    };
+
+    // built from the piece-square tables at startup
+    extern const tables_t tables;
+
+    inline const eval_terms_t& piece(const piece_info_t& piece, size_t square) {
+        return tables.pieces[(size_t)piece.color][(size_t)piece.type][square];
+    }
+
+    inline void add(eval_terms_t& terms, const piece_info_t& piece, size_t square) {
+        const auto& delta = eval::piece(piece, square);
+        terms.midgame += delta.midgame;
+        terms.endgame += delta.endgame;
+        terms.phase += delta.phase;
+    }
+
+    inline void remove(eval_terms_t& terms, const piece_info_t& piece, size_t square) {
+        const auto& delta = eval::piece(piece, square);
+        terms.midgame -= delta.midgame;
+        terms.endgame -= delta.endgame;
+        terms.phase -= delta.phase;
+    }
+
+    // computes the terms of a position from scratch, square by square
+    eval_terms_t compute(const board::data_t& data);
+
+    // the running terms blended by phase, in centipawns from the side to move's point of view
+    inline int32_t evaluate(const board::data_t& data) {
+        const auto& terms = data.eval;
+        int32_t phase = std::min(terms.phase, max_phase);
+
+        int32_t score = (terms.midgame * phase + terms.endgame * (max_phase - phase)) / max_phase;
+        return data.current_turn == player_color::white ? score : -score;
+    }
+} // namespace libchess::eval
\ No newline at end of file
@@ -0,0 +1,365 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "game_archive.h"
+#include "mapped_file.h"
+#include "util.h"
+
+namespace libchess {
+    static constexpr char s_archive_magic[4] = { 'L', 'C', 'G', 'A' };
+    static constexpr size_t s_archive_header_size = 16;
+    static constexpr size_t s_archive_footer_size = 24;
+    static constexpr size_t s_game_header_size = 8 + packed_position_t::size;
+
+    static void write_little_endian(uint8_t* output, uint64_t value, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            output[i] = (uint8_t)(value >> (i * 8));
+        }
+    }
+
+    static uint64_t read_little_endian(const uint8_t* input, size_t size) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; i++) {
+            value |= (uint64_t)input[i] << (i * 8);
+        }
+
+        return value;
+    }
+
+    static void write_archive_header(uint8_t* output, uint64_t length) {
+        memcpy(output, s_archive_magic, sizeof(s_archive_magic));
+        write_little_endian(output + 4, game_archive::version, sizeof(uint32_t));
+        write_little_endian(output + 8, length, sizeof(uint64_t));
+    }
+
+    static void write_archive_footer(uint8_t* output, uint64_t index_offset, uint64_t count) {
+        write_little_endian(output, index_offset, sizeof(uint64_t));
+        write_little_endian(output + 8, count, sizeof(uint64_t));
+        memcpy(output + 16, s_archive_magic, sizeof(s_archive_magic));
+        write_little_endian(output + 20, game_archive::version, sizeof(uint32_t));
+    }
+
+    // sets length to the part of a file of the given size that holds the archive. anything
+    // past it was written after the last close, and isn't part of the archive yet
+    static bool read_archive_header(const uint8_t* header, uint64_t size, uint64_t& length) {
+        if (memcmp(header, s_archive_magic, sizeof(s_archive_magic)) != 0 ||
+            read_little_endian(header + 4, sizeof(uint32_t)) != game_archive::version) {
+            return false;
+        }
+
+        length = read_little_endian(header + 8, sizeof(uint64_t));
+        if (length == 0) {
+            length = size;
+        }
+
+        return length <= size;
+    }
+
+    // finds the index of an archive of the given size. the index has to fill the space between
+    // the games and the footer exactly
+    static bool read_archive_footer(const uint8_t* footer, uint64_t size, uint64_t& index_offset,
+                                    uint64_t& count) {
+        if (size < s_archive_header_size + s_archive_footer_size ||
+            memcmp(footer + 16, s_archive_magic, sizeof(s_archive_magic)) != 0 ||
+            read_little_endian(footer + 20, sizeof(uint32_t)) != game_archive::version) {
+            return false;
+        }
+
+        index_offset = read_little_endian(footer, sizeof(uint64_t));
+        count = read_little_endian(footer + 8, sizeof(uint64_t));
+
+        uint64_t index_end = size - s_archive_footer_size;
+        return index_offset >= s_archive_header_size && index_offset <= index_end &&
+               count == (index_end - index_offset) / sizeof(uint64_t) &&
+               (index_end - index_offset) % sizeof(uint64_t) == 0;
+    }
+
+    std::shared_ptr<game_archive> game_archive::create(std::string_view bytes,
+                                                       std::shared_ptr<const void> storage) {
+        const uint8_t* data = (const uint8_t*)bytes.data();
+
+        uint64_t length, index_offset, count;
+        if (bytes.length() < s_archive_header_size + s_archive_footer_size ||
+            !read_archive_header(data, bytes.length(), length) ||
+            length < s_archive_header_size + s_archive_footer_size ||
+            !read_archive_footer(data + length - s_archive_footer_size, length, index_offset,
+                                 count)) {
+            return nullptr;
+        }
+
+        auto archive = std::shared_ptr<game_archive>(new game_archive);
+        archive->m_bytes = bytes.substr(0, (size_t)length);
+        archive->m_index = data + index_offset;
+        archive->m_count = (size_t)count;
+        archive->m_storage = storage;
+
+        return archive;
+    }
+
+    std::shared_ptr<game_archive> game_archive::open(const std::string& path) {
+        auto file = mapped_file::open(path);
+        if (!file) {
+            return nullptr;
+        }
+
+        return create(file->get_view(), file);
+    }
+
+    std::shared_ptr<game_archive> game_archive::create(std::string_view bytes) {
+        return create(bytes, nullptr);
+    }
+
+    game_result game_archive::parse_result(std::string_view result) {
+        if (result == "1-0") {
+            return game_result::white_wins;
+        } else if (result == "0-1") {
+            return game_result::black_wins;
+        } else if (result == "1/2-1/2") {
+            return game_result::draw;
+        }
+
+        return game_result::unknown;
+    }
+
+    bool game_archive::read(size_t id, archive_game_t& game) const {
+        if (id >= m_count) {
+            return false;
+        }
+
+        const uint8_t* bytes = (const uint8_t*)m_bytes.data();
+        size_t index_offset = (size_t)(m_index - bytes);
+
+        uint64_t offset = read_little_endian(m_index + id * sizeof(uint64_t), sizeof(uint64_t));
+        if (offset < s_archive_header_size || offset + s_game_header_size > index_offset) {
+            return false;
+        }
+
+        const uint8_t* record = bytes + offset;
+        uint64_t ply_count = read_little_endian(record, sizeof(uint32_t));
+        if (ply_count > index_offset - offset - s_game_header_size ||
+            record[4] > (uint8_t)game_result::draw) {
+            return false;
+        }
+
+        game.result = (game_result)record[4];
+
+        packed_position_t packed;
+        memcpy(packed.bytes.data(), record + 8, packed_position_t::size);
+        if (!board::unpack(packed, game.initial_position)) {
+            return false;
+        }
+
+        engine instance(board::create(game.initial_position));
+        move_list moves;
+
+        game.moves.clear();
+        game.moves.reserve((size_t)ply_count);
+
+        const uint8_t* indices = record + s_game_header_size;
+        for (size_t i = 0; i < ply_count; i++) {
+            instance.generate_legal_moves(moves);
+            if (indices[i] >= moves.size()) {
+                return false;
+            }
+
+            auto move = moves[indices[i]];
+            game.moves.push_back(move);
+            instance.commit_move(move, false);
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<game_archive_writer> game_archive_writer::create(const std::string& path) {
+        auto writer = std::shared_ptr<game_archive_writer>(new game_archive_writer);
+        writer->m_stream.open(path, std::ios::in | std::ios::out | std::ios::binary |
+                                        std::ios::trunc);
+
+        if (!writer->m_stream.is_open()) {
+            return nullptr;
+        }
+
+        // a length of 0 covers the whole file, which has no footer until it's closed
+        uint8_t header[s_archive_header_size];
+        write_archive_header(header, 0);
+
+        writer->m_stream.write((const char*)header, sizeof(header));
+        if (!writer->m_stream) {
+            return nullptr;
+        }
+
+        writer->m_end = sizeof(header);
+        writer->m_closed = false;
+
+        return writer;
+    }
+
+    std::shared_ptr<game_archive_writer> game_archive_writer::append(const std::string& path) {
+        auto writer = std::shared_ptr<game_archive_writer>(new game_archive_writer);
+        auto& stream = writer->m_stream;
+
+        stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!stream.is_open()) {
+            return nullptr;
+        }
+
+        // only the header, footer and index are needed - the games stay where they are
+        stream.seekg(0, std::ios::end);
+        uint64_t size = (uint64_t)stream.tellg();
+        if (size < s_archive_header_size + s_archive_footer_size) {
+            return nullptr;
+        }
+
+        uint8_t header[s_archive_header_size], footer[s_archive_footer_size];
+        stream.seekg(0);
+        stream.read((char*)header, sizeof(header));
+
+        uint64_t length;
+        if (!stream || !read_archive_header(header, size, length) ||
+            length < s_archive_header_size + s_archive_footer_size) {
+            return nullptr;
+        }
+
+        stream.seekg((std::streamoff)(length - sizeof(footer)));
+        stream.read((char*)footer, sizeof(footer));
+
+        uint64_t index_offset, count;
+        if (!stream || !read_archive_footer(footer, length, index_offset, count)) {
+            return nullptr;
+        }
+
+        writer->m_offsets.resize((size_t)count);
+        std::vector<uint8_t> index(writer->m_offsets.size() * sizeof(uint64_t));
+
+        stream.seekg((std::streamoff)index_offset);
+        stream.read((char*)index.data(), (std::streamsize)index.size());
+        if (!stream) {
+            return nullptr;
+        }
+
+        for (size_t i = 0; i < writer->m_offsets.size(); i++) {
+            writer->m_offsets[i] = read_little_endian(&index[i * sizeof(uint64_t)],
+                                                      sizeof(uint64_t));
+        }
+
+        // new games go after the old footer, which stays the archive's end until close writes
+        // a new one. the old index is left behind as dead space
+        writer->m_end = length;
+        writer->m_closed = false;
+
+        return writer;
+    }
+
+    game_archive_writer::~game_archive_writer() { close(); }
+
+    bool game_archive_writer::add(const board::data_t& initial_position,
+                                  const packed_move_t* moves, size_t count, game_result result,
+                                  size_t* id) {
+        if (count > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+
+        std::vector<uint8_t> record(s_game_header_size + count);
+        write_little_endian(record.data(), count, sizeof(uint32_t));
+        record[4] = (uint8_t)result;
+
+        packed_position_t packed;
+        if (!board::pack(initial_position, packed)) {
+            return false;
+        }
+
+        memcpy(record.data() + 8, packed.bytes.data(), packed_position_t::size);
+
+        // encoding is the expensive part, so it happens before taking the lock
+        engine instance(board::create(initial_position));
+        move_list legal_moves;
+
+        for (size_t i = 0; i < count; i++) {
+            instance.generate_legal_moves(legal_moves);
+
+            size_t index = 0;
+            while (index < legal_moves.size() && !legal_moves[index].matches(moves[i])) {
+                index++;
+            }
+
+            if (index == legal_moves.size()) {
+                return false;
+            }
+
+            record[s_game_header_size + i] = (uint8_t)index;
+            instance.commit_move(legal_moves[index], false);
+        }
+
+        util::mutex_lock lock(m_mutex);
+        if (m_closed) {
+            return false;
+        }
+
+        m_stream.seekp((std::streamoff)m_end);
+        m_stream.write((const char*)record.data(), (std::streamsize)record.size());
+        if (!m_stream) {
+            return false;
+        }
+
+        if (id != nullptr) {
+            *id = m_offsets.size();
+        }
+
+        m_offsets.push_back(m_end);
+        m_end += record.size();
+
+        return true;
+    }
+
+    bool game_archive_writer::close() {
+        util::mutex_lock lock(m_mutex);
+        if (m_closed) {
+            return true;
+        }
+
+        m_closed = true;
+
+        std::vector<uint8_t> tail(m_offsets.size() * sizeof(uint64_t) + s_archive_footer_size);
+        for (size_t i = 0; i < m_offsets.size(); i++) {
+            write_little_endian(&tail[i * sizeof(uint64_t)], m_offsets[i], sizeof(uint64_t));
+        }
+
+        write_archive_footer(&tail[m_offsets.size() * sizeof(uint64_t)], m_end,
+                             m_offsets.size());
+
+        m_stream.seekp((std::streamoff)m_end);
+        m_stream.write((const char*)tail.data(), (std::streamsize)tail.size());
+        m_stream.flush();
+
+        // only once the new tail is written does the header point past the old one
+        if (m_stream) {
+            uint8_t header[s_archive_header_size];
+            write_archive_header(header, m_end + tail.size());
+
+            m_stream.seekp(0);
+            m_stream.write((const char*)header, sizeof(header));
+        }
+
+        m_stream.close();
+        return !m_stream.fail();
+    }
+
+    size_t game_archive_writer::get_count() {
+        util::mutex_lock lock(m_mutex);
+        return m_offsets.size();
+    }
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,119 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+
+namespace libchess {
+    enum class game_result : uint8_t { unknown = 0, white_wins, black_wins, draw };
+
+    struct archive_game_t {
+        board::data_t initial_position;
+        game_result result;
+
+        // flagged as generate_legal_moves flags them
+        std::vector<packed_move_t> moves;
+    };
+
+    // an append-only file of games, each stored as its initial position followed by one byte
+    // per ply - the move's index in generate_legal_moves. everything is little-endian:
+    // header: "LCGA", a 32-bit version and the 64-bit length of the archive as of its last
+    // close, or 0 for the whole file
+    // game: a 32-bit ply count, the result, 3 reserved bytes, a packed_position_t and the moves
+    // index: a 64-bit offset per game, in id order
+    // footer: the 64-bit offset of the index, the 64-bit game count, "LCGA" and the version
+    // appended games go after the footer, and the new index and footer after them. until the
+    // header is updated on close, readers still see the archive as it was
+    // the move indices depend on the order generate_legal_moves produces moves in, so changing
+    // that order means bumping the version
+    class game_archive {
+    public:
+        static constexpr uint32_t version = 1;
+
+        // maps the file instead of reading it. nullptr if it can't be opened, or isn't a
+        // complete archive
+        static std::shared_ptr<game_archive> open(const std::string& path);
+
+        // does not copy - the bytes have to outlive the archive
+        static std::shared_ptr<game_archive> create(std::string_view bytes);
+
+        // "1-0", "0-1" and "1/2-1/2" as in pgn. anything else is unknown
+        static game_result parse_result(std::string_view result);
+
+        ~game_archive() = default;
+
+        game_archive(const game_archive&) = delete;
+        game_archive& operator=(const game_archive&) = delete;
+
+        size_t get_count() const { return m_count; }
+
+        // replays the stored indices from the initial position. fails for an id out of range or
+        // a corrupt game
+        bool read(size_t id, archive_game_t& game) const;
+
+    private:
+        game_archive() = default;
+
+        static std::shared_ptr<game_archive> create(std::string_view bytes,
+                                                    std::shared_ptr<const void> storage);
+
+        // the mapping m_bytes points into, if the archive owns it
+        std::shared_ptr<const void> m_storage;
+
+        std::string_view m_bytes;
+        const uint8_t* m_index = nullptr;
+        size_t m_count = 0;
+    };
+
+    // appends games to an archive. add is safe to call from several threads at once - games are
+    // encoded in parallel, and only the write itself is serialized
+    class game_archive_writer {
+    public:
+        // creates the file, or truncates an existing one. nullptr if it can't be opened
+        static std::shared_ptr<game_archive_writer> create(const std::string& path);
+
+        // adds to an existing archive, which stays readable as it was until close. nullptr if
+        // the file can't be opened or isn't a complete archive
+        static std::shared_ptr<game_archive_writer> append(const std::string& path);
+
+        // closes the archive if it hasn't been already
+        ~game_archive_writer();
+
+        game_archive_writer(const game_archive_writer&) = delete;
+        game_archive_writer& operator=(const game_archive_writer&) = delete;
+
+        // fails if a move is illegal, the game is too long, or the writer is closed. id is set
+        // to the game's position in the archive
+        bool add(const board::data_t& initial_position, const packed_move_t* moves, size_t count,
+                 game_result result, size_t* id = nullptr);
+
+        // writes the index and footer. nothing can be added afterwards
+        bool close();
+
+        size_t get_count();
+
+    private:
+        game_archive_writer() = default;
+
+        std::mutex m_mutex;
+        std::fstream m_stream;
+        std::vector<uint64_t> m_offsets;
+        uint64_t m_end = 0;
+
+        // until the file is fully opened, so that a failed open never writes an index
+        bool m_closed = true;
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,144 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "mapped_file.h"
+
+#ifdef LIBCHESS_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace libchess {
+#ifdef LIBCHESS_PLATFORM_WINDOWS
+    static DWORD get_access_flags(file_access access) {
+        switch (access) {
+        case file_access::sequential:
+            return FILE_FLAG_SEQUENTIAL_SCAN;
+        case file_access::random:
+            return FILE_FLAG_RANDOM_ACCESS;
+        default:
+            return FILE_ATTRIBUTE_NORMAL;
+        }
+    }
+
+    std::shared_ptr<mapped_file> mapped_file::open(const std::string& path, file_access access) {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, get_access_flags(access), nullptr);
+
+        if (file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        auto result = std::shared_ptr<mapped_file>(new mapped_file);
+        result->m_file = file;
+        result->m_size = (size_t)size.QuadPart;
+
+        if (result->m_size == 0) {
+            return result;
+        }
+
+        result->m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (result->m_mapping == nullptr) {
+            return nullptr;
+        }
+
+        result->m_data = (const char*)MapViewOfFile(result->m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (result->m_data == nullptr) {
+            return nullptr;
+        }
+
+        return result;
+    }
+
+    mapped_file::~mapped_file() {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+        }
+
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+        }
+
+        if (m_file != nullptr) {
+            CloseHandle(m_file);
+        }
+    }
+#else
+    static int get_access_advice(file_access access) {
+        switch (access) {
+        case file_access::sequential:
+            return MADV_SEQUENTIAL;
+        case file_access::random:
+            return MADV_RANDOM;
+        default:
+            return MADV_NORMAL;
+        }
+    }
+
+    std::shared_ptr<mapped_file> mapped_file::open(const std::string& path, file_access access) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return nullptr;
+        }
+
+        auto result = std::shared_ptr<mapped_file>(new mapped_file);
+        result->m_size = (size_t)info.st_size;
+
+        if (result->m_size > 0) {
+            void* data = mmap(nullptr, result->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                result->m_size = 0;
+                result.reset();
+            } else {
+                if (access != file_access::normal) {
+                    madvise(data, result->m_size, get_access_advice(access));
+                }
+
+                result->m_data = (const char*)data;
+            }
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+        return result;
+    }
+
+    mapped_file::~mapped_file() {
+        if (m_data != nullptr) {
+            munmap((void*)m_data, m_size);
+        }
+    }
+#endif
+} // namespace libchess
\ No newline at end of file
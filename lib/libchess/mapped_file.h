@@ -0,0 +1,51 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+namespace libchess {
+    // how a file will be read, passed on to the os so that it can read ahead (or not) to suit
+    enum class file_access : uint8_t { normal = 0, sequential, random };
+
+    // a read-only view of a whole file, mapped into memory instead of read into a buffer
+    class mapped_file {
+    public:
+        // nullptr if the file can't be opened or mapped
+        static std::shared_ptr<mapped_file> open(const std::string& path,
+                                                 file_access access = file_access::normal);
+
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        const char* get_data() const { return m_data; }
+        size_t get_size() const { return m_size; }
+        std::string_view get_view() const { return std::string_view(m_data, m_size); }
+
+    private:
+        mapped_file() = default;
+
+        // an empty file has no mapping, only a null view
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef LIBCHESS_PLATFORM_WINDOWS
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,129 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "bitboard.h"
+#include "board.h"
+#include "coord.h"
+
+namespace libchess {
+    struct move_t {
+        coord position, destination;
+
+        // only used when a pawn reaches the last rank
+        piece_type promotion = piece_type::none;
+    };
+
+    // a move in 16 bits: the origin square in bits 0-5, the destination in bits 6-11, the
+    // promotion piece in bits 12-13 and a move_flag in bits 14-15. squares are as in bitboard.h
+    struct packed_move_t {
+        enum move_flag : uint16_t {
+            flag_none = 0,
+            flag_promotion,
+            flag_en_passant,
+            flag_castling
+        };
+
+        uint16_t value = 0;
+
+        static constexpr packed_move_t create(size_t position, size_t destination,
+                                              move_flag flag = flag_none,
+                                              piece_type promotion = piece_type::queen) {
+            return { (uint16_t)(position | (destination << 6) |
+                                (((size_t)promotion - (size_t)piece_type::queen) & 3) << 12 |
+                                ((size_t)flag << 14)) };
+        }
+
+        // the flags are only known when generated from a position, so this only sets
+        // flag_promotion
+        static packed_move_t pack(const move_t& move) {
+            if (move.promotion == piece_type::none) {
+                return create(bitboard::get_square(move.position),
+                              bitboard::get_square(move.destination));
+            }
+
+            return create(bitboard::get_square(move.position),
+                          bitboard::get_square(move.destination), flag_promotion, move.promotion);
+        }
+
+        size_t get_position() const { return value & 63; }
+        size_t get_destination() const { return (value >> 6) & 63; }
+        move_flag get_flag() const { return (move_flag)(value >> 14); }
+
+        // queen, rook, knight and bishop are contiguous in piece_type
+        piece_type get_promotion() const {
+            return get_flag() == flag_promotion
+                       ? (piece_type)(((value >> 12) & 3) + (size_t)piece_type::queen)
+                       : piece_type::none;
+        }
+
+        move_t unpack() const {
+            move_t move;
+            move.position = bitboard::get_coord(get_position());
+            move.destination = bitboard::get_coord(get_destination());
+            move.promotion = get_promotion();
+
+            return move;
+        }
+
+        // the same move, disregarding en passant and castling flags
+        bool matches(packed_move_t other) const {
+            uint16_t mask = (get_flag() == flag_promotion || other.get_flag() == flag_promotion)
+                                ? 0xFFFF
+                                : 0x0FFF;
+
+            return ((value ^ other.value) & mask) == 0;
+        }
+
+        bool operator==(packed_move_t other) const { return value == other.value; }
+        bool operator!=(packed_move_t other) const { return value != other.value; }
+    };
+
+    static_assert(sizeof(packed_move_t) == sizeof(uint16_t));
+
+    // no legal chess position has more than 218 moves, so this never needs to allocate
+    class move_list {
+    public:
+        static constexpr size_t capacity = 256;
+
+        move_list() = default;
+        ~move_list() = default;
+
+        // moves past capacity are dropped
+        void push_back(packed_move_t move) {
+            if (m_size < capacity) {
+                m_moves[m_size++] = move;
+            }
+        }
+
+        void clear() { m_size = 0; }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        packed_move_t& operator[](size_t index) { return m_moves[index]; }
+        packed_move_t operator[](size_t index) const { return m_moves[index]; }
+
+        packed_move_t* begin() { return m_moves.data(); }
+        packed_move_t* end() { return m_moves.data() + m_size; }
+        const packed_move_t* begin() const { return m_moves.data(); }
+        const packed_move_t* end() const { return m_moves.data() + m_size; }
+
+    private:
+        std::array<packed_move_t, capacity> m_moves;
+        size_t m_size = 0;
+    };
+} // namespace libchess
\ No newline at end of file
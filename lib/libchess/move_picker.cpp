@@ -0,0 +1,173 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "move_picker.h"
+
+namespace libchess {
+    // indexed by piece type. only ever compared with each other
+    static constexpr std::array<int32_t, piece_type_count> s_piece_values = { 0, 10, 9, 5,
+                                                                              3, 3,  1 };
+
+    static constexpr int32_t s_table_move_score = 1 << 30;
+    static constexpr int32_t s_tactical_score = 1 << 28;
+    static constexpr int32_t s_underpromotion_score = s_tactical_score - 1024;
+    static constexpr int32_t s_killer_score = 1 << 26;
+    static constexpr int32_t s_counter_move_score =
+        s_killer_score - (int32_t)move_history_t::killer_count;
+
+    void move_history_t::clear() {
+        for (auto& ply : killers) {
+            ply.fill(packed_move_t());
+        }
+
+        for (auto& color : scores) {
+            for (auto& origin : color) {
+                origin.fill(0);
+            }
+        }
+
+        for (auto& color : counter_moves) {
+            for (auto& type : color) {
+                type.fill(packed_move_t());
+            }
+        }
+    }
+
+    void move_history_t::new_search() {
+        for (auto& ply : killers) {
+            ply.fill(packed_move_t());
+        }
+
+        for (auto& color : scores) {
+            for (auto& origin : color) {
+                for (auto& score : origin) {
+                    score /= 2;
+                }
+            }
+        }
+    }
+
+    // moves a score towards the bonus's limit by less the closer it already is
+    static void apply_bonus(int32_t& score, int32_t bonus) {
+        score += bonus - score * std::abs(bonus) / move_history_t::max_score;
+    }
+
+    void move_history_t::update(const board::data_t& data, const move_undo_t* previous,
+                                size_t ply, uint32_t depth, packed_move_t move,
+                                const packed_move_t* tried, size_t tried_count) {
+        if (ply < max_ply && killers[ply][0] != move) {
+            auto& ply_killers = killers[ply];
+            std::copy_backward(ply_killers.begin(), ply_killers.end() - 1, ply_killers.end());
+            ply_killers[0] = move;
+        }
+
+        if (previous != nullptr) {
+            const auto& piece = data.pieces[previous->destination ^ 56];
+            counter_moves[(size_t)piece.color][(size_t)piece.type][previous->destination] = move;
+        }
+
+        auto& color_scores = scores[(size_t)data.current_turn];
+        int32_t bonus = std::min((int32_t)(depth * depth), max_score / 2);
+
+        apply_bonus(color_scores[move.get_position()][move.get_destination()], bonus);
+        for (size_t i = 0; i < tried_count; i++) {
+            auto other = tried[i];
+            apply_bonus(color_scores[other.get_position()][other.get_destination()], -bonus);
+        }
+    }
+
+    packed_move_t move_history_t::get_counter_move(const board::data_t& data,
+                                                   const move_undo_t* previous) const {
+        if (previous == nullptr) {
+            return packed_move_t();
+        }
+
+        const auto& piece = data.pieces[previous->destination ^ 56];
+        return counter_moves[(size_t)piece.color][(size_t)piece.type][previous->destination];
+    }
+
+    move_picker::move_picker(const board::data_t& data, move_list& moves,
+                             packed_move_t table_move, const move_history_t& history, size_t ply,
+                             const move_undo_t* previous)
+        : m_moves(moves), m_ordered(true) {
+        static const std::array<packed_move_t, move_history_t::killer_count> s_no_killers = {};
+        const auto& killers = ply < move_history_t::max_ply ? history.killers[ply] : s_no_killers;
+
+        auto counter_move = history.get_counter_move(data, previous);
+        const auto& color_scores = history.scores[(size_t)data.current_turn];
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            auto move = moves[i];
+            int32_t& score = m_scores[i];
+
+            if (move == table_move) {
+                score = s_table_move_score;
+            } else if (is_tactical(data, move)) {
+                size_t position = move.get_position();
+                size_t destination = move.get_destination();
+
+                // en passant takes a pawn from an empty square
+                piece_type victim = move.get_flag() == packed_move_t::flag_en_passant
+                                        ? piece_type::pawn
+                                        : data.pieces[destination ^ 56].type;
+
+                piece_type attacker = data.pieces[position ^ 56].type;
+                piece_type promotion = move.get_promotion();
+
+                score = promotion == piece_type::none || promotion == piece_type::queen
+                            ? s_tactical_score
+                            : s_underpromotion_score;
+
+                score += (s_piece_values[(size_t)victim] + s_piece_values[(size_t)promotion]) * 16;
+                score -= s_piece_values[(size_t)attacker];
+            } else {
+                auto killer = std::find(killers.begin(), killers.end(), move);
+                if (killer != killers.end()) {
+                    score = s_killer_score - (int32_t)(killer - killers.begin());
+                } else if (move == counter_move) {
+                    score = s_counter_move_score;
+                } else {
+                    score = color_scores[move.get_position()][move.get_destination()];
+                }
+            }
+        }
+    }
+
+    move_picker::move_picker(move_list& moves) : m_moves(moves), m_ordered(false) {}
+
+    bool move_picker::next(packed_move_t& move) {
+        size_t count = m_moves.size();
+        if (m_index >= count) {
+            return false;
+        }
+
+        if (m_ordered) {
+            size_t best = m_index;
+            for (size_t i = m_index + 1; i < count; i++) {
+                if (m_scores[i] > m_scores[best]) {
+                    best = i;
+                }
+            }
+
+            std::swap(m_moves[m_index], m_moves[best]);
+            std::swap(m_scores[m_index], m_scores[best]);
+        }
+
+        move = m_moves[m_index++];
+        return true;
+    }
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+
+namespace libchess {
+    // what a search has learned about quiet moves so far, for ordering the rest of it. owned
+    // by one thread
+    struct move_history_t {
+        static constexpr size_t max_ply = 128;
+        static constexpr size_t killer_count = 2;
+
+        // history scores stay within this, either way
+        static constexpr int32_t max_score = 1 << 14;
+
+        // quiet moves that caused a cutoff at each ply, most recent first
+        std::array<std::array<packed_move_t, killer_count>, max_ply> killers;
+
+        // butterfly scores - indexed by color, origin and destination
+        std::array<std::array<std::array<int32_t, board::size>, board::size>, player_color_count>
+            scores;
+
+        // the quiet move that refuted a move, indexed by the color, type and destination of
+        // the piece that made it
+        std::array<std::array<std::array<packed_move_t, board::size>, piece_type_count>,
+                   player_color_count>
+            counter_moves;
+
+        void clear();
+
+        // forgets the killers, and halves the scores so that newer results count for more
+        void new_search();
+
+        // the quiet move that caused a cutoff becomes a killer and the counter to the previous
+        // move, and gains score. the quiet moves searched before it lose score
+        void update(const board::data_t& data, const move_undo_t* previous, size_t ply,
+                    uint32_t depth, packed_move_t move, const packed_move_t* tried,
+                    size_t tried_count);
+
+        packed_move_t get_counter_move(const board::data_t& data,
+                                       const move_undo_t* previous) const;
+    };
+
+    // hands out a node's moves best first. every move is scored up front into a buffer on the
+    // stack, and each call to next selects the best of those left, so that a node cut off
+    // after a move or two never sorts the rest. in order of score:
+    // - the transposition table's move
+    // - captures and promotions, the most valuable victim first and then the least valuable
+    // attacker. underpromotions come last of these
+    // - the killers of the ply, then the counter to the previous move
+    // - every other quiet move, by history score
+    class move_picker {
+    public:
+        // captures, en passant and promotions
+        static bool is_tactical(const board::data_t& data, packed_move_t move) {
+            return move.get_flag() == packed_move_t::flag_promotion ||
+                   move.get_flag() == packed_move_t::flag_en_passant ||
+                   (data.occupancy & bitboard::square_mask(move.get_destination())) != 0;
+        }
+
+        // previous is the move that led to the position, if any. the moves are reordered in
+        // place as they're picked
+        move_picker(const board::data_t& data, move_list& moves, packed_move_t table_move,
+                    const move_history_t& history, size_t ply, const move_undo_t* previous);
+
+        // hands the moves out in the order they're in instead
+        move_picker(move_list& moves);
+
+        // false once every move has been handed out
+        bool next(packed_move_t& move);
+
+    private:
+        move_list& m_moves;
+        std::array<int32_t, move_list::capacity> m_scores;
+        size_t m_index = 0;
+        bool m_ordered;
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,419 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "nnue.h"
+#include "mapped_file.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LIBCHESS_NNUE_X86
+#ifndef _MSC_VER
+#include <immintrin.h>
+#endif
+#endif
+
+// kernels are compiled for their instruction set on their own, so that the rest of the library
+// still runs on any x86-64 cpu. msvc needs no flag to emit them
+#ifdef _MSC_VER
+#define LIBCHESS_NNUE_TARGET(isa)
+#else
+#define LIBCHESS_NNUE_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace libchess::nnue {
+    static constexpr char s_network_magic[] = { 'L', 'C', 'N', 'N' };
+    static constexpr size_t s_network_header_size = 64;
+
+    static constexpr size_t s_feature_weight_count = feature_count * hidden_size;
+    static constexpr size_t s_output_weight_count = player_color_count * hidden_size;
+    static constexpr size_t s_weight_count =
+        s_feature_weight_count + hidden_size + s_output_weight_count;
+
+    // at most two pieces leave or land on a square per move, for each side
+    static constexpr size_t s_max_changes = 2;
+
+    // destination = source + every added row - every removed row, over hidden_size values
+    using update_kernel_t = void (*)(int16_t* destination, const int16_t* source,
+                                     const int16_t* const* added, size_t added_count,
+                                     const int16_t* const* removed, size_t removed_count);
+
+    // the clipped accumulators of both sides dotted with the output weights
+    using output_kernel_t = int32_t (*)(const int16_t* us, const int16_t* them,
+                                        const int16_t* weights);
+
+    struct kernels_t {
+        update_kernel_t update;
+        output_kernel_t output;
+    };
+
+    static void update_scalar(int16_t* destination, const int16_t* source,
+                              const int16_t* const* added, size_t added_count,
+                              const int16_t* const* removed, size_t removed_count) {
+        for (size_t i = 0; i < hidden_size; i++) {
+            int32_t value = source[i];
+            for (size_t j = 0; j < added_count; j++) {
+                value += added[j][i];
+            }
+
+            for (size_t j = 0; j < removed_count; j++) {
+                value -= removed[j][i];
+            }
+
+            // wraps the same way the simd kernels do
+            destination[i] = (int16_t)value;
+        }
+    }
+
+    static int32_t output_scalar(const int16_t* us, const int16_t* them, const int16_t* weights) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < hidden_size; i++) {
+            sum += std::clamp<int32_t>(us[i], 0, activation_max) * weights[i];
+            sum += std::clamp<int32_t>(them[i], 0, activation_max) * weights[hidden_size + i];
+        }
+
+        return sum;
+    }
+
+#ifdef LIBCHESS_NNUE_X86
+    LIBCHESS_NNUE_TARGET("sse4.1")
+    static void update_sse41(int16_t* destination, const int16_t* source,
+                             const int16_t* const* added, size_t added_count,
+                             const int16_t* const* removed, size_t removed_count) {
+        for (size_t i = 0; i < hidden_size; i += 8) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(source + i));
+            for (size_t j = 0; j < added_count; j++) {
+                value = _mm_add_epi16(value, _mm_loadu_si128((const __m128i*)(added[j] + i)));
+            }
+
+            for (size_t j = 0; j < removed_count; j++) {
+                value = _mm_sub_epi16(value, _mm_loadu_si128((const __m128i*)(removed[j] + i)));
+            }
+
+            _mm_storeu_si128((__m128i*)(destination + i), value);
+        }
+    }
+
+    LIBCHESS_NNUE_TARGET("sse4.1")
+    static int32_t output_sse41(const int16_t* us, const int16_t* them, const int16_t* weights) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i max = _mm_set1_epi16((int16_t)activation_max);
+
+        __m128i sum = zero;
+        for (size_t side = 0; side < player_color_count; side++) {
+            const int16_t* values = side == 0 ? us : them;
+            const int16_t* side_weights = weights + side * hidden_size;
+
+            for (size_t i = 0; i < hidden_size; i += 8) {
+                __m128i value = _mm_loadu_si128((const __m128i*)(values + i));
+                value = _mm_min_epi16(_mm_max_epi16(value, zero), max);
+
+                __m128i weight = _mm_loadu_si128((const __m128i*)(side_weights + i));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(value, weight));
+            }
+        }
+
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+    LIBCHESS_NNUE_TARGET("avx2")
+    static void update_avx2(int16_t* destination, const int16_t* source,
+                            const int16_t* const* added, size_t added_count,
+                            const int16_t* const* removed, size_t removed_count) {
+        for (size_t i = 0; i < hidden_size; i += 16) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(source + i));
+            for (size_t j = 0; j < added_count; j++) {
+                __m256i row = _mm256_loadu_si256((const __m256i*)(added[j] + i));
+                value = _mm256_add_epi16(value, row);
+            }
+
+            for (size_t j = 0; j < removed_count; j++) {
+                __m256i row = _mm256_loadu_si256((const __m256i*)(removed[j] + i));
+                value = _mm256_sub_epi16(value, row);
+            }
+
+            _mm256_storeu_si256((__m256i*)(destination + i), value);
+        }
+    }
+
+    LIBCHESS_NNUE_TARGET("avx2")
+    static int32_t output_avx2(const int16_t* us, const int16_t* them, const int16_t* weights) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i max = _mm256_set1_epi16((int16_t)activation_max);
+
+        __m256i sum = zero;
+        for (size_t side = 0; side < player_color_count; side++) {
+            const int16_t* values = side == 0 ? us : them;
+            const int16_t* side_weights = weights + side * hidden_size;
+
+            for (size_t i = 0; i < hidden_size; i += 16) {
+                __m256i value = _mm256_loadu_si256((const __m256i*)(values + i));
+                value = _mm256_min_epi16(_mm256_max_epi16(value, zero), max);
+
+                __m256i weight = _mm256_loadu_si256((const __m256i*)(side_weights + i));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(value, weight));
+            }
+        }
+
+        __m128i folded =
+            _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+        folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0x4E));
+        folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0xB1));
+        return _mm_cvtsi128_si32(folded);
+    }
+#endif
+
+    // indexed by simd_level
+    static const std::array<kernels_t, 3> s_kernels = {
+        kernels_t{ update_scalar, output_scalar },
+#ifdef LIBCHESS_NNUE_X86
+        kernels_t{ update_sse41, output_sse41 },
+        kernels_t{ update_avx2, output_avx2 },
+#else
+        kernels_t{ update_scalar, output_scalar },
+        kernels_t{ update_scalar, output_scalar },
+#endif
+    };
+
+    simd_level detect_simd_level() {
+        bool sse41 = false;
+        bool avx2 = false;
+
+#if defined(LIBCHESS_NNUE_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        sse41 = (info[2] & (1 << 19)) != 0;
+
+        // the os has to save the ymm registers too
+        bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                   (_xgetbv(0) & 6) == 6;
+
+        __cpuidex(info, 7, 0);
+        avx2 = avx && (info[1] & (1 << 5)) != 0;
+#elif defined(LIBCHESS_NNUE_X86)
+        __builtin_cpu_init();
+        sse41 = __builtin_cpu_supports("sse4.1");
+        avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+        if (avx2) {
+            return simd_level::avx2;
+        } else if (sse41) {
+            return simd_level::sse41;
+        } else {
+            return simd_level::scalar;
+        }
+    }
+
+    static simd_level get_detected_simd_level() {
+        static const simd_level level = detect_simd_level();
+        return level;
+    }
+
+    size_t get_feature(player_color perspective, const piece_info_t& piece, size_t square) {
+        size_t color = piece.color == perspective ? 0 : 1;
+        if (perspective == player_color::black) {
+            square ^= 56;
+        }
+
+        return (color * (piece_type_count - 1) + (size_t)piece.type - 1) * board::size + square;
+    }
+
+    static bool is_little_endian() {
+        uint16_t value = 1;
+        uint8_t first;
+
+        memcpy(&first, &value, sizeof(first));
+        return first == 1;
+    }
+
+    static uint32_t read_header_field(const uint8_t* data, size_t offset) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            value |= (uint32_t)data[offset + i] << (i * 8);
+        }
+
+        return value;
+    }
+
+    static void write_header_field(uint8_t* data, size_t offset, uint32_t value) {
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            data[offset + i] = (uint8_t)(value >> (i * 8));
+        }
+    }
+
+    std::shared_ptr<network> network::open(const std::string& path) {
+        auto file = mapped_file::open(path);
+        if (!file) {
+            return nullptr;
+        }
+
+        auto result = create(file->get_view());
+        if (result) {
+            result->m_storage = file;
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<network> network::create(std::string_view bytes) {
+        // the weights are read in place, so they have to be laid out the way the cpu reads them
+        if (!is_little_endian() || (uintptr_t)bytes.data() % alignof(int16_t) != 0) {
+            return nullptr;
+        }
+
+        if (bytes.length() != s_network_header_size + s_weight_count * sizeof(int16_t) ||
+            memcmp(bytes.data(), s_network_magic, sizeof(s_network_magic)) != 0) {
+            return nullptr;
+        }
+
+        auto data = (const uint8_t*)bytes.data();
+        if (read_header_field(data, 4) != version ||
+            read_header_field(data, 8) != (uint32_t)feature_count ||
+            read_header_field(data, 12) != (uint32_t)hidden_size) {
+            return nullptr;
+        }
+
+        auto result = std::shared_ptr<network>(new network);
+        result->m_feature_weights = (const int16_t*)(data + s_network_header_size);
+        result->m_feature_biases = result->m_feature_weights + s_feature_weight_count;
+        result->m_output_weights = result->m_feature_biases + hidden_size;
+        result->m_output_bias = (int32_t)read_header_field(data, 16);
+        result->m_simd_level = get_detected_simd_level();
+
+        // the kernels sum in 32 bits, and the largest output possible has to fit
+        int64_t bound = std::abs((int64_t)result->m_output_bias);
+        for (size_t i = 0; i < s_output_weight_count; i++) {
+            bound += (int64_t)activation_max * std::abs((int64_t)result->m_output_weights[i]);
+        }
+
+        if (bound > std::numeric_limits<int32_t>::max()) {
+            return nullptr;
+        }
+
+        return result;
+    }
+
+    bool network::write(std::ostream& stream, const network_weights_t& weights) {
+        if (weights.feature_weights.size() != s_feature_weight_count ||
+            weights.feature_biases.size() != hidden_size ||
+            weights.output_weights.size() != s_output_weight_count) {
+            return false;
+        }
+
+        uint8_t header[s_network_header_size] = {};
+        memcpy(header, s_network_magic, sizeof(s_network_magic));
+
+        write_header_field(header, 4, version);
+        write_header_field(header, 8, (uint32_t)feature_count);
+        write_header_field(header, 12, (uint32_t)hidden_size);
+        write_header_field(header, 16, (uint32_t)weights.output_bias);
+
+        stream.write((const char*)header, sizeof(header));
+        for (const auto* values :
+             { &weights.feature_weights, &weights.feature_biases, &weights.output_weights }) {
+            for (int16_t value : *values) {
+                char bytes[] = { (char)(value & 0xFF), (char)((uint16_t)value >> 8) };
+                stream.write(bytes, sizeof(bytes));
+            }
+        }
+
+        return !stream.fail();
+    }
+
+    void network::refresh(accumulator_t& accumulator, const board::data_t& data) const {
+        const auto& kernels = s_kernels[(size_t)m_simd_level];
+
+        for (size_t perspective = 0; perspective < player_color_count; perspective++) {
+            std::array<const int16_t*, board::size> rows;
+            size_t count = 0;
+
+            bitboard_t occupancy = data.occupancy;
+            while (occupancy != 0) {
+                size_t square = bitboard::pop_lsb(occupancy);
+                size_t feature =
+                    get_feature((player_color)perspective, data.pieces[square ^ 56], square);
+
+                rows[count++] = m_feature_weights + feature * hidden_size;
+            }
+
+            kernels.update(accumulator.values[perspective].data(), m_feature_biases, rows.data(),
+                           count, nullptr, 0);
+        }
+    }
+
+    void network::update(const accumulator_t& parent, accumulator_t& child,
+                         const move_undo_t& undo, const board::data_t& data) const {
+        struct change_t {
+            piece_info_t piece;
+            size_t square;
+        };
+
+        std::array<change_t, s_max_changes> added, removed;
+        size_t added_count = 0;
+        size_t removed_count = 0;
+
+        // promotions land as whatever the pawn became
+        removed[removed_count++] = { undo.piece, undo.position };
+        added[added_count++] = { data.pieces[undo.destination ^ 56], undo.destination };
+
+        if (undo.captured.type != piece_type::none) {
+            removed[removed_count++] = { undo.captured, undo.capture_position };
+        }
+
+        if (undo.rook_position < board::size) {
+            const auto& rook = data.pieces[undo.rook_destination ^ 56];
+            removed[removed_count++] = { rook, undo.rook_position };
+            added[added_count++] = { rook, undo.rook_destination };
+        }
+
+        const auto& kernels = s_kernels[(size_t)m_simd_level];
+        for (size_t perspective = 0; perspective < player_color_count; perspective++) {
+            auto get_row = [&](const change_t& change) {
+                auto side = (player_color)perspective;
+                size_t feature = get_feature(side, change.piece, change.square);
+                return m_feature_weights + feature * hidden_size;
+            };
+
+            std::array<const int16_t*, s_max_changes> added_rows, removed_rows;
+            std::transform(added.begin(), added.begin() + added_count, added_rows.begin(), get_row);
+            std::transform(removed.begin(), removed.begin() + removed_count, removed_rows.begin(),
+                           get_row);
+
+            kernels.update(child.values[perspective].data(), parent.values[perspective].data(),
+                           added_rows.data(), added_count, removed_rows.data(), removed_count);
+        }
+    }
+
+    int32_t network::evaluate(const accumulator_t& accumulator, player_color current_turn) const {
+        const auto& kernels = s_kernels[(size_t)m_simd_level];
+
+        size_t us = (size_t)current_turn;
+        size_t them = us ^ 1;
+
+        int64_t output = kernels.output(accumulator.values[us].data(),
+                                        accumulator.values[them].data(), m_output_weights);
+
+        output += m_output_bias;
+        return (int32_t)(output * output_scale / (activation_max * output_quantization));
+    }
+
+    void network::set_simd_level(simd_level level) {
+        m_simd_level = std::min(level, get_detected_simd_level());
+    }
+} // namespace libchess::nnue
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+
+namespace libchess::nnue {
+    // one input per color, piece type and square, as seen by each side
+    static constexpr size_t feature_count =
+        player_color_count * (piece_type_count - 1) * board::size;
+    static constexpr size_t hidden_size = 256;
+
+    // the hidden layer is clipped to [0, activation_max] before the output layer, whose weights
+    // are scaled by output_quantization. output_scale converts the result to centipawns
+    static constexpr int32_t activation_max = 255;
+    static constexpr int32_t output_quantization = 64;
+    static constexpr int32_t output_scale = 400;
+
+    enum class simd_level : uint8_t { scalar = 0, sse41, avx2 };
+
+    // the widest kernels this cpu can run
+    simd_level detect_simd_level();
+
+    // the input of a piece on a square (see bitboard.h) from one side's point of view. black
+    // sees the board flipped, so that both sides share the same weights
+    size_t get_feature(player_color perspective, const piece_info_t& piece, size_t square);
+
+    // the first layer's output for both sides, kept up to date move by move instead of being
+    // recomputed from every piece
+    struct alignas(64) accumulator_t {
+        // indexed by perspective
+        std::array<std::array<int16_t, hidden_size>, player_color_count> values;
+    };
+
+    // a network's parameters, in the order they are stored
+    struct network_weights_t {
+        // feature_count rows of hidden_size
+        std::vector<int16_t> feature_weights;
+        std::vector<int16_t> feature_biases;
+
+        // hidden_size for the side to move, then hidden_size for the other side
+        std::vector<int16_t> output_weights;
+        int32_t output_bias = 0;
+    };
+
+    // a perspective network with one hidden layer: feature_count inputs to hidden_size int16
+    // neurons per side, clipped and concatenated with the side to move first, to one output.
+    //
+    // files start with "LCNN", the version, feature_count, hidden_size and the output bias,
+    // each 4 bytes and little-endian, padded to 64 bytes. the little-endian int16 weights
+    // follow in network_weights_t order, and are used where they lie
+    class network {
+    public:
+        static constexpr uint32_t version = 1;
+
+        // maps the file instead of reading it. nullptr if it can't be opened or isn't a network
+        static std::shared_ptr<network> open(const std::string& path);
+
+        // does not copy - the bytes have to outlive the network, and be 2-byte aligned. fails
+        // if the output layer could overflow
+        static std::shared_ptr<network> create(std::string_view bytes);
+
+        // fails if the weights are the wrong size
+        static bool write(std::ostream& stream, const network_weights_t& weights);
+
+        ~network() = default;
+
+        network(const network&) = delete;
+        network& operator=(const network&) = delete;
+
+        // computes both sides' accumulators from every piece on the board
+        void refresh(accumulator_t& accumulator, const board::data_t& data) const;
+
+        // the accumulator after a move, from the one before it. undo describes the move, and
+        // data is the position it led to
+        void update(const accumulator_t& parent, accumulator_t& child, const move_undo_t& undo,
+                    const board::data_t& data) const;
+
+        // in centipawns from the side to move's point of view
+        int32_t evaluate(const accumulator_t& accumulator, player_color current_turn) const;
+
+        // the detected level by default. anything wider than the cpu supports is lowered to it
+        void set_simd_level(simd_level level);
+        simd_level get_simd_level() const { return m_simd_level; }
+
+    private:
+        network() = default;
+
+        // the mapping the weights point into, if the network owns it
+        std::shared_ptr<const void> m_storage;
+
+        const int16_t* m_feature_weights = nullptr;
+        const int16_t* m_feature_biases = nullptr;
+        const int16_t* m_output_weights = nullptr;
+        int32_t m_output_bias = 0;
+
+        simd_level m_simd_level = simd_level::scalar;
+    };
+} // namespace libchess::nnue
\ No newline at end of file
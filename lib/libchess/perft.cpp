@@ -0,0 +1,251 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "perft.h"
+
+namespace libchess {
+    // 8 bits of depth, 56 bits of count
+    static constexpr uint32_t s_depth_bits = 8;
+    static constexpr uint64_t s_depth_mask = ((uint64_t)1 << s_depth_bits) - 1;
+
+    perft_table::perft_table(size_t size_mb) {
+        size_t entry_count = std::max<size_t>(size_mb * 1024 * 1024 / sizeof(entry_t), 1);
+
+        // round down to a power of two so that indexing is a mask
+        size_t power = 1;
+        while (power * 2 <= entry_count) {
+            power *= 2;
+        }
+
+        m_entries = std::make_unique<entry_t[]>(power);
+        m_mask = power - 1;
+
+        clear();
+    }
+
+    bool perft_table::probe(uint64_t key, uint32_t depth, uint64_t& nodes) const {
+        const auto& entry = m_entries[key & m_mask];
+
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) != key || (data & s_depth_mask) != depth) {
+            return false;
+        }
+
+        nodes = data >> s_depth_bits;
+        return true;
+    }
+
+    void perft_table::store(uint64_t key, uint32_t depth, uint64_t nodes) {
+        auto& entry = m_entries[key & m_mask];
+        uint64_t data = (nodes << s_depth_bits) | (depth & s_depth_mask);
+
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    void perft_table::clear() {
+        // depth 0 is never stored, so a zeroed entry never matches
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_entries[i].check.store(0, std::memory_order_relaxed);
+            m_entries[i].data.store(0, std::memory_order_relaxed);
+        }
+
+        reset_stats();
+    }
+
+    void perft_table::add_stats(const stats_t& stats) {
+        m_probes.fetch_add(stats.probes, std::memory_order_relaxed);
+        m_hits.fetch_add(stats.hits, std::memory_order_relaxed);
+    }
+
+    perft_table::stats_t perft_table::get_stats() const {
+        stats_t stats;
+        stats.probes = m_probes.load(std::memory_order_relaxed);
+        stats.hits = m_hits.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    void perft_table::reset_stats() {
+        m_probes = 0;
+        m_hits = 0;
+    }
+
+    static uint64_t perft_internal(engine& instance, uint32_t depth) {
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        // bulk count the last ply instead of making every move
+        if (depth == 1) {
+            return moves.size();
+        }
+
+        uint64_t nodes = 0;
+        for (const auto& move : moves) {
+            instance.make_move(move);
+            nodes += perft_internal(instance, depth - 1);
+            instance.unmake_move();
+        }
+
+        return nodes;
+    }
+
+    static uint64_t perft_hashed(engine& instance, uint32_t depth, perft_table& table,
+                                 perft_table::stats_t& stats) {
+        // a probe costs more than bulk counting a single ply
+        if (depth == 1) {
+            return perft_internal(instance, depth);
+        }
+
+        uint64_t key = instance.get_key();
+        uint64_t nodes;
+
+        stats.probes++;
+        if (table.probe(key, depth, nodes)) {
+            stats.hits++;
+            return nodes;
+        }
+
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        nodes = 0;
+        for (const auto& move : moves) {
+            instance.make_move(move);
+            nodes += perft_hashed(instance, depth - 1, table, stats);
+            instance.unmake_move();
+        }
+
+        table.store(key, depth, nodes);
+        return nodes;
+    }
+
+    // the entry point for both the serial and parallel searches
+    static uint64_t perft_subtree(engine& instance, uint32_t depth, perft_table* table) {
+        if (table == nullptr) {
+            return perft_internal(instance, depth);
+        }
+
+        perft_table::stats_t stats;
+        uint64_t nodes = perft_hashed(instance, depth, *table, stats);
+
+        table->add_stats(stats);
+        return nodes;
+    }
+
+    static void collect_split_paths(engine& instance, uint32_t depth,
+                                    std::vector<packed_move_t>& path,
+                                    std::vector<packed_move_t>& paths) {
+        if (depth == 0) {
+            paths.insert(paths.end(), path.begin(), path.end());
+            return;
+        }
+
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        for (const auto& move : moves) {
+            path.push_back(move);
+            instance.make_move(move);
+
+            collect_split_paths(instance, depth - 1, path, paths);
+
+            instance.unmake_move();
+            path.pop_back();
+        }
+    }
+
+    uint64_t perft(engine& instance, uint32_t depth, perft_table* table) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        return perft_subtree(instance, depth, table);
+    }
+
+    uint64_t perft_divide(engine& instance, uint32_t depth,
+                          std::vector<perft_divide_entry_t>& entries) {
+        entries.clear();
+        if (depth == 0) {
+            return 1;
+        }
+
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        uint64_t nodes = 0;
+        for (const auto& move : moves) {
+            auto& entry = entries.emplace_back();
+            entry.move = move;
+
+            instance.make_move(move);
+            entry.nodes = perft(instance, depth - 1);
+            instance.unmake_move();
+
+            nodes += entry.nodes;
+        }
+
+        return nodes;
+    }
+
+    uint64_t perft_parallel(engine& instance, uint32_t depth, thread_pool& pool,
+                            uint32_t split_depth, perft_table* table) {
+        if (split_depth == 0 || depth <= split_depth) {
+            return perft(instance, depth, table);
+        }
+
+        // flattened, split_depth moves per task
+        std::vector<packed_move_t> path, paths;
+        collect_split_paths(instance, split_depth, path, paths);
+
+        size_t task_count = paths.size() / split_depth;
+        std::vector<uint64_t> results(task_count, 0);
+
+        std::vector<std::unique_ptr<engine>> engines;
+        for (size_t i = 0; i < pool.get_thread_count(); i++) {
+            engines.push_back(std::make_unique<engine>(board::copy(instance.get_board())));
+        }
+
+        for (size_t i = 0; i < task_count; i++) {
+            pool.submit([&, i](size_t worker) {
+                auto& worker_engine = *engines[worker];
+                const packed_move_t* task_path = &paths[i * split_depth];
+
+                for (uint32_t j = 0; j < split_depth; j++) {
+                    worker_engine.make_move(task_path[j]);
+                }
+
+                results[i] = perft_subtree(worker_engine, depth - split_depth, table);
+
+                for (uint32_t j = 0; j < split_depth; j++) {
+                    worker_engine.unmake_move();
+                }
+            });
+        }
+
+        pool.wait();
+
+        uint64_t nodes = 0;
+        for (uint64_t result : results) {
+            nodes += result;
+        }
+
+        return nodes;
+    }
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,79 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+#include "thread_pool.h"
+
+namespace libchess {
+    struct perft_divide_entry_t {
+        packed_move_t move;
+        uint64_t nodes;
+    };
+
+    // subtree counts keyed by position and depth. lock-free and safe to share between threads:
+    // every entry is written as two independent words, the first xored with the second, so a
+    // torn write fails the key check on probe instead of returning a bad count
+    class perft_table {
+    public:
+        struct stats_t {
+            uint64_t probes = 0;
+            uint64_t hits = 0;
+        };
+
+        // rounded down to a power of two entries
+        perft_table(size_t size_mb);
+        ~perft_table() = default;
+
+        perft_table(const perft_table&) = delete;
+        perft_table& operator=(const perft_table&) = delete;
+
+        bool probe(uint64_t key, uint32_t depth, uint64_t& nodes) const;
+        void store(uint64_t key, uint32_t depth, uint64_t nodes);
+
+        // drops every entry and resets the statistics
+        void clear();
+
+        size_t get_entry_count() const { return m_mask + 1; }
+
+        // statistics are gathered per search and added once, to keep the hot path uncontended
+        void add_stats(const stats_t& stats);
+        stats_t get_stats() const;
+        void reset_stats();
+
+    private:
+        struct entry_t {
+            std::atomic<uint64_t> check, data;
+        };
+
+        std::unique_ptr<entry_t[]> m_entries;
+        size_t m_mask;
+
+        std::atomic<uint64_t> m_probes, m_hits;
+    };
+
+    // counts the leaf nodes of the legal move tree below the engine's current position
+    uint64_t perft(engine& instance, uint32_t depth, perft_table* table = nullptr);
+
+    // same as perft, but also reports the node count under each root move
+    uint64_t perft_divide(engine& instance, uint32_t depth,
+                          std::vector<perft_divide_entry_t>& entries);
+
+    // splits the tree into one task per move sequence of split_depth plies and runs them on
+    // the pool. every worker searches its own copy of the board, and instance is left untouched
+    uint64_t perft_parallel(engine& instance, uint32_t depth, thread_pool& pool,
+                            uint32_t split_depth = 2, perft_table* table = nullptr);
+} // namespace libchess
\ No newline at end of file
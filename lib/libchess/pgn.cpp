@@ -0,0 +1,413 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "pgn.h"
+#include "mapped_file.h"
+#include "san.h"
+
+namespace libchess {
+    static const board::data_t& get_standard_position() {
+        static const board::data_t data = []() {
+            board::data_t result;
+            board::parse_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", result);
+
+            return result;
+        }();
+
+        return data;
+    }
+
+    static bool is_pgn_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    // characters that end a movetext token
+    static bool is_pgn_delimiter(char c) {
+        return is_pgn_space(c) || c == '{' || c == '}' || c == ';' || c == '(' || c == ')' ||
+               c == '$';
+    }
+
+    static size_t skip_to_line_end(std::string_view text, size_t i) {
+        auto newline = (const char*)memchr(text.data() + i, '\n', text.length() - i);
+        return newline != nullptr ? (size_t)(newline - text.data()) + 1 : text.length();
+    }
+
+    static size_t skip_comment(std::string_view text, size_t i) {
+        auto end = (const char*)memchr(text.data() + i, '}', text.length() - i);
+        return end != nullptr ? (size_t)(end - text.data()) + 1 : text.length();
+    }
+
+    // i is just past the opening parenthesis. variations nest, and may hold comments
+    static size_t skip_variation(std::string_view text, size_t i) {
+        size_t depth = 1;
+        while (i < text.length() && depth > 0) {
+            switch (text[i]) {
+            case '(':
+                depth++;
+                i++;
+                break;
+            case ')':
+                depth--;
+                i++;
+                break;
+            case '{':
+                i = skip_comment(text, i + 1);
+                break;
+            case ';':
+                i = skip_to_line_end(text, i);
+                break;
+            default:
+                i++;
+                break;
+            }
+        }
+
+        return i;
+    }
+
+    static bool parse_tag(std::string_view text, size_t& i, pgn_tag_t& tag) {
+        // i is just past the opening bracket
+        while (i < text.length() && is_pgn_space(text[i])) {
+            i++;
+        }
+
+        size_t name_start = i;
+        while (i < text.length() && !is_pgn_space(text[i]) && text[i] != '"' && text[i] != ']') {
+            i++;
+        }
+
+        tag.name = text.substr(name_start, i - name_start);
+        while (i < text.length() && is_pgn_space(text[i])) {
+            i++;
+        }
+
+        if (tag.name.empty() || i >= text.length() || text[i] != '"') {
+            return false;
+        }
+
+        size_t value_start = ++i;
+        while (i < text.length() && text[i] != '"') {
+            // skip over whatever is escaped, quotes included
+            i += text[i] == '\\' ? 2 : 1;
+        }
+
+        if (i >= text.length()) {
+            return false;
+        }
+
+        tag.value = text.substr(value_start, i - value_start);
+        i++;
+
+        while (i < text.length() && is_pgn_space(text[i])) {
+            i++;
+        }
+
+        if (i >= text.length() || text[i] != ']') {
+            return false;
+        }
+
+        i++;
+        return true;
+    }
+
+    static bool is_pgn_result(std::string_view token) {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+    }
+
+    std::optional<std::string_view> pgn_game_t::find_tag(std::string_view name) const {
+        for (size_t i = 0; i < tag_count; i++) {
+            if (tags[i].name == name) {
+                return tags[i].value;
+            }
+        }
+
+        return {};
+    }
+
+    std::shared_ptr<pgn_reader> pgn_reader::open(const std::string& path) {
+        auto file = mapped_file::open(path, file_access::sequential);
+        if (!file) {
+            return nullptr;
+        }
+
+        auto reader = std::shared_ptr<pgn_reader>(new pgn_reader);
+        reader->m_text = file->get_view();
+        reader->m_storage = file;
+
+        return reader;
+    }
+
+    std::shared_ptr<pgn_reader> pgn_reader::create(std::istream& stream) {
+        auto buffer = std::make_shared<std::string>(std::istreambuf_iterator<char>(stream),
+                                                    std::istreambuf_iterator<char>());
+
+        auto reader = std::shared_ptr<pgn_reader>(new pgn_reader);
+        reader->m_text = *buffer;
+        reader->m_storage = buffer;
+
+        return reader;
+    }
+
+    std::shared_ptr<pgn_reader> pgn_reader::create(std::string_view text) {
+        auto reader = std::shared_ptr<pgn_reader>(new pgn_reader);
+        reader->m_text = text;
+
+        return reader;
+    }
+
+    bool pgn_reader::decode(std::string_view text, engine& instance, pgn_game_t& game) {
+        game.text = text;
+        game.tag_count = 0;
+        game.moves.clear();
+        game.result = "*";
+        game.error = pgn_error::none;
+        game.error_token = std::string_view();
+
+        size_t i = 0;
+        while (true) {
+            while (i < text.length() && is_pgn_space(text[i])) {
+                i++;
+            }
+
+            if (i >= text.length() || text[i] != '[') {
+                break;
+            }
+
+            size_t tag_start = i++;
+            pgn_tag_t tag;
+
+            if (!parse_tag(text, i, tag)) {
+                game.error = pgn_error::tag;
+                game.error_token = text.substr(tag_start, skip_to_line_end(text, i) - tag_start);
+
+                return false;
+            }
+
+            if (game.tag_count < pgn_game_t::max_tags) {
+                game.tags[game.tag_count++] = tag;
+            }
+        }
+
+        auto fen = game.find_tag("FEN");
+        if (fen.has_value()) {
+            if (board::parse_fen(fen.value(), game.initial_position) != fen_error::none) {
+                game.error = pgn_error::fen;
+                game.error_token = fen.value();
+
+                return false;
+            }
+        } else {
+            game.initial_position = get_standard_position();
+        }
+
+        if (!instance) {
+            instance.set_board(board::create());
+        }
+
+        instance.get_board()->get_data() = game.initial_position;
+        instance.clear_cache();
+
+        while (i < text.length()) {
+            char c = text[i];
+            if (is_pgn_space(c) || c == ')' || c == '}') {
+                i++;
+                continue;
+            }
+
+            switch (c) {
+            case '{':
+                i = skip_comment(text, i + 1);
+                continue;
+            case ';':
+                i = skip_to_line_end(text, i);
+                continue;
+            case '(':
+                i = skip_variation(text, i + 1);
+                continue;
+            case '$':
+                // numeric annotation glyph
+                i++;
+                while (i < text.length() && text[i] >= '0' && text[i] <= '9') {
+                    i++;
+                }
+
+                continue;
+            case '%':
+                if (i == 0 || text[i - 1] == '\n') {
+                    i = skip_to_line_end(text, i);
+                    continue;
+                }
+
+                break;
+            }
+
+            size_t token_start = i;
+            while (i < text.length() && !is_pgn_delimiter(text[i])) {
+                i++;
+            }
+
+            auto token = text.substr(token_start, i - token_start);
+            if (is_pgn_result(token)) {
+                game.result = token;
+                break;
+            }
+
+            // move numbers, possibly glued to the move: "12.", "12...", "12.e4"
+            auto san = token;
+            if (san[0] >= '1' && san[0] <= '9') {
+                while (!san.empty() && san[0] >= '0' && san[0] <= '9') {
+                    san.remove_prefix(1);
+                }
+
+                while (!san.empty() && san[0] == '.') {
+                    san.remove_prefix(1);
+                }
+            }
+
+            if (san.empty()) {
+                continue;
+            }
+
+            move_t move;
+            if (!san::parse(instance, san, move)) {
+                game.error = pgn_error::move;
+                game.error_token = token;
+
+                return false;
+            }
+
+            game.moves.push_back(packed_move_t::pack(move));
+            instance.commit_move(move, false);
+        }
+
+        return true;
+    }
+
+    size_t pgn_reader::find_games() {
+        if (m_games_found) {
+            return m_games.size();
+        }
+
+        m_games.clear();
+        m_games_found = true;
+
+        size_t game_start = std::string_view::npos;
+        bool in_movetext = false;
+        bool in_comment = false;
+
+        size_t offset = 0;
+        while (offset < m_text.length()) {
+            size_t line_start = offset;
+            offset = skip_to_line_end(m_text, offset);
+
+            auto line = m_text.substr(line_start, offset - line_start);
+            size_t first = 0;
+            while (first < line.length() && is_pgn_space(line[first])) {
+                first++;
+            }
+
+            if (first == line.length()) {
+                continue;
+            }
+
+            // a tag after movetext starts the next game
+            if (!in_comment && line[first] == '[') {
+                if (game_start == std::string_view::npos || in_movetext) {
+                    if (game_start != std::string_view::npos) {
+                        m_games.push_back(m_text.substr(game_start, line_start - game_start));
+                    }
+
+                    game_start = line_start;
+                    in_movetext = false;
+                }
+
+                continue;
+            }
+
+            if (game_start == std::string_view::npos) {
+                game_start = line_start;
+            }
+
+            // only brace comments can span lines, and only they can hide a '[' at a line start
+            in_movetext = true;
+            for (char c : line) {
+                if (in_comment) {
+                    in_comment = c != '}';
+                } else if (c == '{') {
+                    in_comment = true;
+                } else if (c == ';') {
+                    break;
+                }
+            }
+        }
+
+        if (game_start != std::string_view::npos) {
+            m_games.push_back(m_text.substr(game_start));
+        }
+
+        return m_games.size();
+    }
+
+    size_t pgn_reader::read(const game_callback_t& callback, thread_pool* pool) {
+        find_games();
+
+        struct worker_state_t {
+            engine instance;
+            pgn_game_t game;
+        };
+
+        size_t worker_count = pool != nullptr ? pool->get_thread_count() : 1;
+        std::vector<std::unique_ptr<worker_state_t>> workers;
+
+        for (size_t i = 0; i < worker_count; i++) {
+            auto& worker = workers.emplace_back(std::make_unique<worker_state_t>());
+            worker->instance.set_board(board::create());
+        }
+
+        std::atomic<size_t> decoded;
+        decoded = 0;
+
+        auto decode_range = [&](size_t worker_index, size_t begin, size_t end) {
+            auto& worker = *workers[worker_index];
+            size_t successes = 0;
+
+            for (size_t i = begin; i < end; i++) {
+                worker.game.index = i;
+                if (decode(m_games[i], worker.instance, worker.game)) {
+                    successes++;
+                }
+
+                callback(worker.game, worker_index);
+            }
+
+            decoded += successes;
+        };
+
+        if (pool == nullptr) {
+            decode_range(0, 0, m_games.size());
+            return decoded;
+        }
+
+        // small batches, so that stealing can even out games of very different lengths
+        size_t batch_size = std::max<size_t>(m_games.size() / (worker_count * 16), 1);
+        for (size_t begin = 0; begin < m_games.size(); begin += batch_size) {
+            size_t end = std::min(begin + batch_size, m_games.size());
+            pool->submit([&, begin, end](size_t worker) { decode_range(worker, begin, end); });
+        }
+
+        pool->wait();
+        return decoded;
+    }
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,113 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+#include "thread_pool.h"
+
+namespace libchess {
+    enum class pgn_error : uint8_t {
+        none = 0,
+
+        // a malformed tag pair
+        tag,
+
+        // the FEN tag didn't parse
+        fen,
+
+        // a movetext token that isn't a legal, unambiguous move in the position
+        move
+    };
+
+    struct pgn_tag_t {
+        std::string_view name;
+
+        // as written, without the quotes. escape sequences are left in
+        std::string_view value;
+    };
+
+    // views point into the reader's memory, and everything is reused from game to game
+    struct pgn_game_t {
+        static constexpr size_t max_tags = 64;
+
+        // the game's position in the input, counting from 0
+        size_t index;
+        std::string_view text;
+
+        // tags past max_tags are dropped
+        std::array<pgn_tag_t, max_tags> tags;
+        size_t tag_count;
+
+        // the starting position, from the FEN tag if there is one
+        board::data_t initial_position;
+
+        // packed from the san, so en passant and castling aren't flagged
+        std::vector<packed_move_t> moves;
+
+        // "*" if the movetext doesn't end in a result
+        std::string_view result;
+
+        pgn_error error;
+
+        // the token that caused the error, if any
+        std::string_view error_token;
+
+        std::optional<std::string_view> find_tag(std::string_view name) const;
+    };
+
+    class pgn_reader {
+    public:
+        // called once per game. from worker threads, in no particular order, when reading in
+        // parallel - the worker index identifies the thread
+        using game_callback_t = std::function<void(const pgn_game_t&, size_t)>;
+
+        // maps the file instead of reading it. nullptr if it can't be opened
+        static std::shared_ptr<pgn_reader> open(const std::string& path);
+
+        // reads the whole stream into memory owned by the reader
+        static std::shared_ptr<pgn_reader> create(std::istream& stream);
+
+        // does not copy - the text has to outlive the reader
+        static std::shared_ptr<pgn_reader> create(std::string_view text);
+
+        // decodes a single game's text. moves are replayed through instance, which is left at
+        // the final position
+        static bool decode(std::string_view text, engine& instance, pgn_game_t& game);
+
+        ~pgn_reader() = default;
+
+        pgn_reader(const pgn_reader&) = delete;
+        pgn_reader& operator=(const pgn_reader&) = delete;
+
+        // the fast first pass - finds where each game starts without decoding anything. done
+        // automatically by read if it hasn't been already
+        size_t find_games();
+        const std::vector<std::string_view>& get_games() const { return m_games; }
+
+        // decodes every game, across the pool's workers if one is given. returns the number of
+        // games decoded without errors
+        size_t read(const game_callback_t& callback, thread_pool* pool = nullptr);
+
+    private:
+        pgn_reader() = default;
+
+        std::shared_ptr<const void> m_storage;
+        std::string_view m_text;
+
+        std::vector<std::string_view> m_games;
+        bool m_games_found = false;
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,338 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "polyglot.h"
+#include "attacks.h"
+#include "mapped_file.h"
+
+#ifdef LIBCHESS_POLYGLOT_RANDOM
+#include "polyglot_random.h"
+#endif
+
+namespace libchess {
+    namespace polyglot {
+        static constexpr size_t s_castling_offset = 768;
+        static constexpr size_t s_en_passant_offset = 772;
+        static constexpr size_t s_turn_offset = 780;
+
+        // polyglot orders pieces pawn, knight, bishop, rook, queen, king - black before white
+        static constexpr size_t s_piece_kinds[piece_type_count] = { 0, 10, 8, 6, 2, 4, 0 };
+
+        static std::optional<uint32_t> parse_hex_digit(char c) {
+            if (c >= '0' && c <= '9') {
+                return (uint32_t)(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                return (uint32_t)(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                return (uint32_t)(c - 'A' + 10);
+            }
+
+            return {};
+        }
+
+        bool load_random_table(std::istream& stream, random_table_t& table) {
+            std::string text(std::istreambuf_iterator<char>(stream),
+                             (std::istreambuf_iterator<char>()));
+
+            size_t count = 0;
+            size_t offset = 0;
+
+            while (offset < text.length()) {
+                char c = text[offset];
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',') {
+                    offset++;
+                    continue;
+                }
+
+                if (count == random_count) {
+                    return false;
+                }
+
+                if (text.compare(offset, 2, "0x") == 0 || text.compare(offset, 2, "0X") == 0) {
+                    offset += 2;
+                }
+
+                uint64_t value = 0;
+                size_t digits = 0;
+
+                std::optional<uint32_t> digit;
+                while (offset < text.length() && (digit = parse_hex_digit(text[offset]))) {
+                    value = (value << 4) | digit.value();
+                    offset++;
+                    digits++;
+                }
+
+                // c++ suffixes are allowed, so that the array can come straight from source
+                while (offset < text.length() && (text[offset] == 'u' || text[offset] == 'U' ||
+                                                  text[offset] == 'l' || text[offset] == 'L')) {
+                    offset++;
+                }
+
+                bool terminated = offset == text.length() || text[offset] == ',' ||
+                                  isspace((unsigned char)text[offset]);
+
+                if (digits == 0 || digits > 16 || !terminated) {
+                    return false;
+                }
+
+                table[count++] = value;
+            }
+
+            return count == random_count;
+        }
+
+        std::shared_ptr<const random_table_t> get_random_table() {
+#ifdef LIBCHESS_POLYGLOT_RANDOM
+            static const auto s_table = []() -> std::shared_ptr<const random_table_t> {
+                auto table = std::make_shared<random_table_t>();
+
+                std::stringstream stream(s_random_text);
+                if (!load_random_table(stream, *table)) {
+                    return nullptr;
+                }
+
+                return table;
+            }();
+
+            return s_table;
+#else
+            return nullptr;
+#endif
+        }
+
+        uint64_t compute_key(const board::data_t& data, const random_table_t& table) {
+            uint64_t key = 0;
+
+            bitboard_t occupancy = data.occupancy;
+            while (occupancy != 0) {
+                size_t square = bitboard::pop_lsb(occupancy);
+                const auto& piece = data.pieces[square ^ 56];
+
+                size_t kind = s_piece_kinds[(size_t)piece.type];
+                if (piece.color == player_color::white) {
+                    kind++;
+                }
+
+                key ^= table[kind * board::size + square];
+            }
+
+            static constexpr std::array<std::pair<player_color, castle_side>, 4> castling = {
+                std::make_pair(player_color::white, castle_side_king),
+                std::make_pair(player_color::white, castle_side_queen),
+                std::make_pair(player_color::black, castle_side_king),
+                std::make_pair(player_color::black, castle_side_queen),
+            };
+
+            for (size_t i = 0; i < castling.size(); i++) {
+                const auto& [color, side] = castling[i];
+                if ((data.player_castling_availability[color] & side) != castle_side_none) {
+                    key ^= table[s_castling_offset + i];
+                }
+            }
+
+            if (data.en_passant_target.has_value()) {
+                // the pawns that could take en passant stand beside the target, one rank closer
+                // to the side to move
+                size_t target = bitboard::get_square(data.en_passant_target.value());
+                player_color color = data.current_turn;
+                player_color opposing =
+                    color != player_color::white ? player_color::white : player_color::black;
+
+                bitboard_t pawns = data.piece_masks[(size_t)color][(size_t)piece_type::pawn];
+                if ((attacks::pawn(opposing, target) & pawns) != 0) {
+                    key ^= table[s_en_passant_offset + target % board::width];
+                }
+            }
+
+            if (data.current_turn == player_color::white) {
+                key ^= table[s_turn_offset];
+            }
+
+            return key;
+        }
+    } // namespace polyglot
+
+    static uint64_t read_big_endian(const uint8_t* input, size_t size) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; i++) {
+            value = (value << 8) | input[i];
+        }
+
+        return value;
+    }
+
+    std::shared_ptr<polyglot_book> polyglot_book::create(
+        std::string_view bytes, std::shared_ptr<const polyglot::random_table_t> table) {
+        if (!table || bytes.length() % polyglot::entry_size != 0) {
+            return nullptr;
+        }
+
+        auto book = std::shared_ptr<polyglot_book>(new polyglot_book);
+        book->m_entries = (const uint8_t*)bytes.data();
+        book->m_count = bytes.length() / polyglot::entry_size;
+        book->m_table = table;
+
+        return book;
+    }
+
+    std::shared_ptr<polyglot_book> polyglot_book::open(
+        const std::string& path, std::shared_ptr<const polyglot::random_table_t> table) {
+        auto file = mapped_file::open(path, file_access::random);
+        if (!file) {
+            return nullptr;
+        }
+
+        auto book = create(file->get_view(), table);
+        if (book) {
+            book->m_storage = file;
+        }
+
+        return book;
+    }
+
+    polyglot::entry_t polyglot_book::get_entry(size_t index) const {
+        const uint8_t* data = m_entries + index * polyglot::entry_size;
+
+        polyglot::entry_t entry;
+        entry.key = read_big_endian(data, sizeof(uint64_t));
+        entry.move = (uint16_t)read_big_endian(data + 8, sizeof(uint16_t));
+        entry.weight = (uint16_t)read_big_endian(data + 10, sizeof(uint16_t));
+        entry.learn = (uint32_t)read_big_endian(data + 12, sizeof(uint32_t));
+
+        return entry;
+    }
+
+    size_t polyglot_book::find(uint64_t key, size_t& first) const {
+        // lower bound, reading only the keys
+        size_t low = 0, high = m_count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (read_big_endian(m_entries + middle * polyglot::entry_size, sizeof(uint64_t)) <
+                key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        first = low;
+
+        size_t last = low;
+        while (last < m_count &&
+               read_big_endian(m_entries + last * polyglot::entry_size, sizeof(uint64_t)) == key) {
+            last++;
+        }
+
+        return last - first;
+    }
+
+    uint64_t polyglot_book::compute_key(const board::data_t& data) const {
+        return polyglot::compute_key(data, *m_table);
+    }
+
+    // polyglot's move bits, converted to a move that can be matched against generated moves
+    static packed_move_t decode_book_move(const board::data_t& data, uint16_t move) {
+        size_t destination = move & 63;
+        size_t position = (move >> 6) & 63;
+        size_t promotion = (move >> 12) & 7;
+
+        // king takes own rook
+        const auto& piece = data.pieces[position ^ 56];
+        const auto& target = data.pieces[destination ^ 56];
+
+        if (piece.type == piece_type::king && target.type == piece_type::rook &&
+            target.color == piece.color) {
+            size_t rank = position - position % board::width;
+            destination = rank + (destination > position ? 6 : 2);
+
+            return packed_move_t::create(position, destination, packed_move_t::flag_castling);
+        }
+
+        static constexpr piece_type promotions[] = { piece_type::none, piece_type::knight,
+                                                     piece_type::bishop, piece_type::rook,
+                                                     piece_type::queen };
+
+        if (promotion == 0 || promotion >= std::size(promotions)) {
+            return packed_move_t::create(position, destination);
+        }
+
+        return packed_move_t::create(position, destination, packed_move_t::flag_promotion,
+                                     promotions[promotion]);
+    }
+
+    size_t polyglot_book::probe(engine& instance, move_list& moves, uint16_t* weights) const {
+        moves.clear();
+
+        const auto& data = instance.get_board()->get_data();
+        size_t first;
+        size_t count = find(compute_key(data), first);
+
+        if (count == 0) {
+            return 0;
+        }
+
+        move_list legal_moves;
+        instance.generate_legal_moves(legal_moves);
+
+        for (size_t i = first; i < first + count; i++) {
+            auto entry = get_entry(i);
+            auto book_move = decode_book_move(data, entry.move);
+
+            for (auto move : legal_moves) {
+                if (move.matches(book_move)) {
+                    if (weights != nullptr && moves.size() < move_list::capacity) {
+                        weights[moves.size()] = entry.weight;
+                    }
+
+                    moves.push_back(move);
+                    break;
+                }
+            }
+        }
+
+        return moves.size();
+    }
+
+    bool polyglot_book::pick(engine& instance, uint64_t random, packed_move_t& move) const {
+        move_list moves;
+        std::array<uint16_t, move_list::capacity> weights;
+
+        size_t count = probe(instance, moves, weights.data());
+        uint64_t total = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            total += weights[i];
+        }
+
+        // a weight of 0 means the move is in the book but shouldn't be played
+        if (total == 0) {
+            return false;
+        }
+
+        uint64_t value = random % total;
+        for (size_t i = 0; i < count; i++) {
+            if (value < weights[i]) {
+                move = moves[i];
+                return true;
+            }
+
+            value -= weights[i];
+        }
+
+        return false;
+    }
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,95 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+
+namespace libchess {
+    namespace polyglot {
+        static constexpr size_t random_count = 781;
+
+        // polyglot's Random64 array, in the order the specification lists it: 768 piece-square
+        // numbers, 4 for castling, 8 for en passant files and 1 for white to move
+        using random_table_t = std::array<uint64_t, random_count>;
+
+        // reads random_count hex numbers, with or without a 0x prefix, separated by whitespace
+        // or commas - so the array can be pasted from the specification as is
+        bool load_random_table(std::istream& stream, random_table_t& table);
+
+        // the array built in with LIBCHESS_POLYGLOT_RANDOM (see lib/CMakeLists.txt), or nullptr
+        // if the library was built without one
+        std::shared_ptr<const random_table_t> get_random_table();
+
+        // the en passant file is only hashed if a pawn of the side to move could capture there
+        uint64_t compute_key(const board::data_t& data, const random_table_t& table);
+
+        struct entry_t {
+            uint64_t key;
+
+            // to file and rank in bits 0-5, from file and rank in bits 6-11, and the promotion
+            // in bits 12-14. castling is written as the king taking its own rook
+            uint16_t move;
+            uint16_t weight;
+            uint32_t learn;
+        };
+
+        static constexpr size_t entry_size = 16;
+    } // namespace polyglot
+
+    // a polyglot .bin book - big-endian entries sorted by key. the file is mapped as is, and
+    // probing neither copies nor allocates
+    class polyglot_book {
+    public:
+        // nullptr if the file can't be opened, or its size isn't a whole number of entries
+        static std::shared_ptr<polyglot_book> open(
+            const std::string& path, std::shared_ptr<const polyglot::random_table_t> table);
+
+        // does not copy - the bytes have to outlive the book
+        static std::shared_ptr<polyglot_book> create(
+            std::string_view bytes, std::shared_ptr<const polyglot::random_table_t> table);
+
+        ~polyglot_book() = default;
+
+        polyglot_book(const polyglot_book&) = delete;
+        polyglot_book& operator=(const polyglot_book&) = delete;
+
+        size_t get_entry_count() const { return m_count; }
+        polyglot::entry_t get_entry(size_t index) const;
+
+        // the range of entries with the given key. returns how many there are
+        size_t find(uint64_t key, size_t& first) const;
+
+        uint64_t compute_key(const board::data_t& data) const;
+
+        // the book's legal moves for the engine's position, and their weights. entries the
+        // position has no legal move for are skipped. weights can be nullptr
+        size_t probe(engine& instance, move_list& moves, uint16_t* weights) const;
+
+        // picks a book move with probability proportional to its weight, given a random number
+        // from the caller. fails if the position isn't in the book
+        bool pick(engine& instance, uint64_t random, packed_move_t& move) const;
+
+    private:
+        polyglot_book() = default;
+
+        // the mapping m_entries points into, if the book owns it
+        std::shared_ptr<const void> m_storage;
+        std::shared_ptr<const polyglot::random_table_t> m_table;
+
+        const uint8_t* m_entries = nullptr;
+        size_t m_count = 0;
+    };
+} // namespace libchess
\ No newline at end of file
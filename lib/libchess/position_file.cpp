@@ -0,0 +1,91 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "position_file.h"
+#include "mapped_file.h"
+
+namespace libchess {
+    // records are only bytes, so they can be read straight out of any buffer
+    static_assert(alignof(packed_position_t) == 1);
+
+    std::shared_ptr<position_file> position_file::create(std::string_view bytes,
+                                                         std::shared_ptr<const void> storage) {
+        if (bytes.length() % packed_position_t::size != 0) {
+            return nullptr;
+        }
+
+        auto file = std::shared_ptr<position_file>(new position_file);
+        file->m_records = (const packed_position_t*)bytes.data();
+        file->m_count = bytes.length() / packed_position_t::size;
+        file->m_storage = storage;
+
+        return file;
+    }
+
+    std::shared_ptr<position_file> position_file::open(const std::string& path) {
+        auto file = mapped_file::open(path, file_access::sequential);
+        if (!file) {
+            return nullptr;
+        }
+
+        return create(file->get_view(), file);
+    }
+
+    std::shared_ptr<position_file> position_file::create(std::istream& stream) {
+        auto buffer = std::make_shared<std::string>(std::istreambuf_iterator<char>(stream),
+                                                    std::istreambuf_iterator<char>());
+
+        return create(*buffer, buffer);
+    }
+
+    std::shared_ptr<position_file> position_file::create(std::string_view bytes) {
+        return create(bytes, nullptr);
+    }
+
+    bool position_file::write(std::ostream& stream, const board::data_t* positions,
+                              size_t count) {
+        // packed in chunks, so that a big batch goes out in a few large writes
+        static constexpr size_t chunk_size = 1024;
+        std::vector<packed_position_t> chunk(std::min(count, chunk_size));
+
+        for (size_t offset = 0; offset < count; offset += chunk_size) {
+            size_t chunk_count = std::min(count - offset, chunk_size);
+            size_t packed = board::pack(positions + offset, chunk_count, chunk.data());
+
+            stream.write((const char*)chunk.data(),
+                         (std::streamsize)(packed * packed_position_t::size));
+
+            if (packed < chunk_count || !stream) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool position_file::read(size_t index, board::data_t& data) const {
+        return index < m_count && board::unpack(m_records[index], data);
+    }
+
+    size_t position_file::read(size_t first, size_t count, board::data_t* positions) const {
+        if (first >= m_count) {
+            return 0;
+        }
+
+        return board::unpack(m_records + first, std::min(count, m_count - first), positions);
+    }
+} // namespace libchess
\ No newline at end of file
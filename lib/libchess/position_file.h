@@ -0,0 +1,65 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "board.h"
+
+namespace libchess {
+    // a flat array of packed_position_t records, with no header. any record can be read in
+    // constant time, and nothing is parsed until it is
+    class position_file {
+    public:
+        // maps the file instead of reading it. nullptr if it can't be opened, or its size isn't
+        // a whole number of records
+        static std::shared_ptr<position_file> open(const std::string& path);
+
+        // reads the whole stream into memory owned by the file
+        static std::shared_ptr<position_file> create(std::istream& stream);
+
+        // does not copy - the bytes have to outlive the file
+        static std::shared_ptr<position_file> create(std::string_view bytes);
+
+        // packs and appends every position. positions before one that can't be packed are
+        // still written
+        static bool write(std::ostream& stream, const board::data_t* positions, size_t count);
+
+        ~position_file() = default;
+
+        position_file(const position_file&) = delete;
+        position_file& operator=(const position_file&) = delete;
+
+        size_t get_count() const { return m_count; }
+        const packed_position_t* get_records() const { return m_records; }
+
+        bool read(size_t index, board::data_t& data) const;
+
+        // returns how many positions were read, stopping at the end of the file or the first
+        // malformed record
+        size_t read(size_t first, size_t count, board::data_t* positions) const;
+
+    private:
+        position_file() = default;
+
+        static std::shared_ptr<position_file> create(std::string_view bytes,
+                                                     std::shared_ptr<const void> storage);
+
+        // the mapping or buffer m_records points into, if the file owns it
+        std::shared_ptr<const void> m_storage;
+
+        const packed_position_t* m_records = nullptr;
+        size_t m_count = 0;
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,341 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "san.h"
+#include "attacks.h"
+#include "util.h"
+
+namespace libchess::san {
+    static constexpr char s_piece_letters[piece_type_count] = { '\0', 'K', 'Q', 'R',
+                                                                'N',  'B', 'P' };
+
+    static std::optional<piece_type> parse_piece_letter(char c) {
+        switch (c) {
+        case 'K':
+            return piece_type::king;
+        case 'Q':
+            return piece_type::queen;
+        case 'R':
+            return piece_type::rook;
+        case 'B':
+            return piece_type::bishop;
+        case 'N':
+            return piece_type::knight;
+        default:
+            return {};
+        }
+    }
+
+    // squares holding a piece of the given type and color that could reach the target, before
+    // legality. for pawns, capture says which way they would have to move
+    static bitboard_t get_origins(const board::data_t& data, size_t target, piece_type type,
+                                  player_color color, bool capture) {
+        bitboard_t pieces = data.piece_masks[(size_t)color][(size_t)type];
+        player_color opposing =
+            color != player_color::white ? player_color::white : player_color::black;
+
+        switch (type) {
+        case piece_type::king:
+            return attacks::king(target) & pieces;
+        case piece_type::queen:
+            return attacks::queen(target, data.occupancy) & pieces;
+        case piece_type::rook:
+            return attacks::rook(target, data.occupancy) & pieces;
+        case piece_type::bishop:
+            return attacks::bishop(target, data.occupancy) & pieces;
+        case piece_type::knight:
+            return attacks::knight(target) & pieces;
+        case piece_type::pawn:
+            break;
+        default:
+            return 0;
+        }
+
+        if (capture) {
+            // a pawn attacks a square from wherever an enemy pawn on it would attack
+            return attacks::pawn(opposing, target) & pieces;
+        }
+
+        bitboard_t target_mask = bitboard::square_mask(target);
+        bitboard_t single = color == player_color::white ? bitboard::shift_south(target_mask)
+                                                          : bitboard::shift_north(target_mask);
+
+        if ((single & pieces) != 0) {
+            return single;
+        } else if ((single & data.occupancy) != 0) {
+            return 0;
+        }
+
+        bitboard_t start_rank = bitboard::rank_mask(color == player_color::white ? 1 : 6);
+        bitboard_t double_push = color == player_color::white ? bitboard::shift_south(single)
+                                                               : bitboard::shift_north(single);
+
+        return double_push & pieces & start_rank;
+    }
+
+    static bool is_last_rank(size_t square, player_color color) {
+        size_t rank = square / board::width;
+        return rank == (color == player_color::white ? board::width - 1 : 0);
+    }
+
+    bool parse(engine& instance, std::string_view san, move_t& move) {
+        while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' ||
+                                san.back() == '?')) {
+            san.remove_suffix(1);
+        }
+
+        if (!instance || san.empty()) {
+            return false;
+        }
+
+        const auto& data = instance.get_board()->get_data();
+        player_color color = data.current_turn;
+
+        std::optional<int32_t> castle_direction;
+        if (san == "O-O" || san == "0-0") {
+            castle_direction = 1;
+        } else if (san == "O-O-O" || san == "0-0-0") {
+            castle_direction = -1;
+        }
+
+        if (castle_direction.has_value()) {
+            bitboard_t kings = data.piece_masks[(size_t)color][(size_t)piece_type::king];
+            if (bitboard::popcount(kings) != 1) {
+                return false;
+            }
+
+            size_t king = bitboard::lsb(kings);
+            int32_t destination = (int32_t)king + castle_direction.value() * 2;
+
+            if (destination < 0 || destination / board::width != king / board::width ||
+                (instance.compute_legal_targets(king) &
+                 bitboard::square_mask((size_t)destination)) == 0) {
+                return false;
+            }
+
+            move.position = bitboard::get_coord(king);
+            move.destination = bitboard::get_coord((size_t)destination);
+            move.promotion = piece_type::none;
+
+            return true;
+        }
+
+        size_t start = 0;
+        piece_type type = piece_type::pawn;
+
+        auto letter = parse_piece_letter(san[0]);
+        if (letter.has_value()) {
+            type = letter.value();
+            start = 1;
+        }
+
+        size_t end = san.length();
+        piece_type promotion = piece_type::none;
+
+        if (type == piece_type::pawn && end >= 3) {
+            auto promotion_letter = parse_piece_letter(san[end - 1]);
+            if (promotion_letter.has_value() && promotion_letter.value() != piece_type::king) {
+                promotion = promotion_letter.value();
+                end -= san[end - 2] == '=' ? 2 : 1;
+            }
+        }
+
+        coord destination;
+        if (end < start + 2 || !util::parse_coordinate(san.substr(end - 2, 2), destination)) {
+            return false;
+        }
+
+        // whatever is left is disambiguation and the capture marker
+        bitboard_t filter = ~(bitboard_t)0;
+        bool capture = false;
+
+        for (char c : san.substr(start, end - 2 - start)) {
+            if (c >= 'a' && c <= 'h') {
+                filter &= bitboard::file_mask((int32_t)(c - 'a'));
+            } else if (c >= '1' && c <= '8') {
+                filter &= bitboard::rank_mask((int32_t)(c - '1'));
+            } else if (c == 'x' || c == ':') {
+                capture = true;
+            } else {
+                return false;
+            }
+        }
+
+        // pawn captures always name the file they come from
+        if (type == piece_type::pawn && capture && filter == ~(bitboard_t)0) {
+            return false;
+        }
+
+        // the marker has to be there exactly when something is taken, en passant included
+        size_t target = bitboard::get_square(destination);
+        bool takes = ((data.occupancy & ~data.color_masks[(size_t)color]) &
+                      bitboard::square_mask(target)) != 0;
+
+        if (type == piece_type::pawn && data.en_passant_target == destination) {
+            takes = true;
+        }
+
+        if (capture != takes) {
+            return false;
+        }
+
+        bool promoting = promotion != piece_type::none;
+        if (type == piece_type::pawn && promoting != is_last_rank(target, color)) {
+            return false;
+        }
+
+        bitboard_t origins = get_origins(data, target, type, color, capture) & filter;
+        bitboard_t target_mask = bitboard::square_mask(target);
+
+        size_t matches = 0;
+        while (origins != 0) {
+            size_t origin = bitboard::pop_lsb(origins);
+            if ((instance.compute_legal_targets(origin) & target_mask) == 0) {
+                continue;
+            }
+
+            move.position = bitboard::get_coord(origin);
+            matches++;
+        }
+
+        if (matches != 1) {
+            return false;
+        }
+
+        move.destination = destination;
+        move.promotion = promotion;
+
+        return true;
+    }
+
+    size_t serialize(engine& instance, const move_t& move, char* buffer, size_t buffer_size) {
+        if (buffer_size == 0) {
+            return 0;
+        }
+
+        buffer[0] = '\0';
+        if (!instance || board::is_out_of_bounds(move.position) ||
+            board::is_out_of_bounds(move.destination)) {
+            return 0;
+        }
+
+        const auto& data = instance.get_board()->get_data();
+        size_t origin = bitboard::get_square(move.position);
+        size_t target = bitboard::get_square(move.destination);
+
+        piece_info_t piece = data.pieces[origin ^ 56];
+        if (piece.type == piece_type::none || piece.color != data.current_turn ||
+            (instance.compute_legal_targets(origin) & bitboard::square_mask(target)) == 0) {
+            return 0;
+        }
+
+        bool promoting = piece.type == piece_type::pawn && is_last_rank(target, piece.color);
+        if (promoting != (move.promotion != piece_type::none) ||
+            move.promotion == piece_type::king || move.promotion == piece_type::pawn) {
+            return 0;
+        }
+
+        char output[max_length + 1];
+        size_t length = 0;
+
+        int32_t dx = move.destination.x - move.position.x;
+        bool capture = (data.occupancy & bitboard::square_mask(target)) != 0;
+
+        if (piece.type == piece_type::king && std::abs(dx) == 2) {
+            const char* castle = dx > 0 ? "O-O" : "O-O-O";
+            while (*castle != '\0') {
+                output[length++] = *castle++;
+            }
+        } else {
+            if (piece.type == piece_type::pawn) {
+                // anything diagonal is a capture, en passant included
+                if (dx != 0) {
+                    output[length++] = (char)('a' + move.position.x);
+                    capture = true;
+                }
+            } else {
+                output[length++] = s_piece_letters[(size_t)piece.type];
+
+                bitboard_t others = get_origins(data, target, piece.type, piece.color, capture) &
+                                    ~bitboard::square_mask(origin);
+
+                bitboard_t ambiguous = 0;
+                while (others != 0) {
+                    size_t other = bitboard::pop_lsb(others);
+                    if ((instance.compute_legal_targets(other) & bitboard::square_mask(target)) !=
+                        0) {
+                        ambiguous |= bitboard::square_mask(other);
+                    }
+                }
+
+                if (ambiguous != 0) {
+                    bool shares_file = (ambiguous & bitboard::file_mask(move.position.x)) != 0;
+                    bool shares_rank = (ambiguous & bitboard::rank_mask(move.position.y)) != 0;
+
+                    if (!shares_file) {
+                        output[length++] = (char)('a' + move.position.x);
+                    } else if (!shares_rank) {
+                        output[length++] = (char)('1' + move.position.y);
+                    } else {
+                        output[length++] = (char)('a' + move.position.x);
+                        output[length++] = (char)('1' + move.position.y);
+                    }
+                }
+            }
+
+            if (capture) {
+                output[length++] = 'x';
+            }
+
+            output[length++] = (char)('a' + move.destination.x);
+            output[length++] = (char)('1' + move.destination.y);
+
+            if (promoting) {
+                output[length++] = '=';
+                output[length++] = s_piece_letters[(size_t)move.promotion];
+            }
+        }
+
+        // the suffix needs the position after the move
+        if (instance.make_move(move)) {
+            if (instance.compute_checkers() != 0) {
+                move_list replies;
+                instance.generate_legal_moves(replies);
+
+                output[length++] = replies.empty() ? '#' : '+';
+            }
+
+            instance.unmake_move();
+        }
+
+        if (length >= buffer_size) {
+            return 0;
+        }
+
+        memcpy(buffer, output, length);
+        buffer[length] = '\0';
+
+        return length;
+    }
+
+    std::string serialize(engine& instance, const move_t& move) {
+        buffer_t buffer;
+        size_t length = serialize(instance, move, buffer.data(), buffer.size());
+
+        return std::string(buffer.data(), length);
+    }
+} // namespace libchess::san
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+
+// standard algebraic notation, e.g. "Nbd7", "exd6", "O-O-O", "e8=Q+"
+namespace libchess::san {
+    // "Qa1xb2+" or "exd8=Q#"
+    static constexpr size_t max_length = 7;
+    using buffer_t = std::array<char, max_length + 1>;
+
+    // the legal move the san describes in the engine's position. check, mate and annotation
+    // suffixes are ignored. fails if the move is illegal or ambiguous, or if the capture marker
+    // is missing from a capture or present on a move that takes nothing
+    bool parse(engine& instance, std::string_view san, move_t& move);
+
+    // writes the null-terminated san of a legal move. returns its length, or 0 if the move
+    // isn't legal or the buffer is too small
+    size_t serialize(engine& instance, const move_t& move, char* buffer, size_t buffer_size);
+
+    // empty if the move isn't legal
+    std::string serialize(engine& instance, const move_t& move);
+} // namespace libchess::san
\ No newline at end of file
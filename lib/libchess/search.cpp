@@ -0,0 +1,558 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "search.h"
+#include "eval.h"
+
+namespace libchess {
+    // mate and tablebase scores are stored as distances from the node rather than from the
+    // root, so that an entry means the same thing wherever the position turns up again
+    static bool is_distance_score(int32_t score) {
+        return searcher::is_mate_score(score) || searcher::is_tablebase_score(score);
+    }
+
+    static int32_t score_to_table(int32_t score, size_t ply) {
+        if (is_distance_score(score)) {
+            return score > 0 ? score + (int32_t)ply : score - (int32_t)ply;
+        }
+
+        return score;
+    }
+
+    static int32_t score_from_table(int32_t score, size_t ply) {
+        if (is_distance_score(score)) {
+            return score > 0 ? score - (int32_t)ply : score + (int32_t)ply;
+        }
+
+        return score;
+    }
+
+    // the most quiet moves a node remembers trying before a cutoff
+    static constexpr size_t s_max_tried_quiets = 64;
+
+    // moves the given move to the front, if it's in the list at all
+    static void move_to_front(move_list& moves, packed_move_t move) {
+        auto found = std::find(moves.begin(), moves.end(), move);
+        if (found != moves.end()) {
+            std::swap(*moves.begin(), *found);
+        }
+    }
+
+    searcher::searcher() {
+        m_table = std::make_shared<transposition_table>();
+        set_thread_count(1);
+    }
+
+    searcher::~searcher() {
+        // helpers only run inside search, but make sure none outlive their state
+        if (m_pool) {
+            m_pool->wait();
+        }
+    }
+
+    void searcher::set_thread_count(size_t count) {
+        if (count == 0) {
+            count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        m_threads.clear();
+        for (size_t i = 0; i < count; i++) {
+            auto& thread = m_threads.emplace_back(std::make_unique<thread_state_t>());
+            thread->index = i;
+            thread->history.clear();
+
+            if (i > 0) {
+                thread->own_engine = std::make_unique<engine>();
+                thread->instance = thread->own_engine.get();
+            }
+        }
+
+        m_pool.reset();
+        if (count > 1) {
+            m_pool = std::make_unique<thread_pool>(count - 1);
+        }
+    }
+
+    bool searcher::search(engine& instance, const search_limits_t& limits, search_info_t& info,
+                          const search_callback_t& callback) {
+        m_limits = limits;
+        m_start = std::chrono::steady_clock::now();
+        m_stopped = false;
+
+        info = search_info_t();
+        if (m_table) {
+            m_table->new_search();
+        }
+
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        if (moves.empty()) {
+            info.score = instance.compute_checkers() != 0 ? -mate_score : 0;
+            return false;
+        }
+
+        const auto& data = instance.get_board()->get_data();
+        for (auto& thread : m_threads) {
+            if (thread->index == 0) {
+                thread->instance = &instance;
+            } else {
+                thread->instance->set_board(board::create(data));
+                thread->instance->set_tablebases(instance.get_tablebases());
+            }
+
+            thread->nodes = 0;
+            thread->cutoffs = 0;
+            thread->first_move_cutoffs = 0;
+            thread->history.new_search();
+            thread->keys[0] = data.key;
+
+            if (m_network) {
+                m_network->refresh(thread->accumulators[0], data);
+            }
+
+            // a move to return even if the first iteration doesn't finish
+            thread->root_move = *moves.begin();
+        }
+
+        info.pv.push_back(*moves.begin());
+
+        uint32_t max_depth = limits.depth > 0 ? std::min(limits.depth, (uint32_t)max_ply - 1)
+                                              : (uint32_t)max_ply - 1;
+
+        for (size_t i = 1; i < m_threads.size(); i++) {
+            auto thread = m_threads[i].get();
+            m_pool->submit([this, thread, max_depth](size_t) { run_helper(*thread, max_depth); });
+        }
+
+        auto& main = *m_threads[0];
+        for (uint32_t depth = 1; depth <= max_depth; depth++) {
+            main.depth = depth;
+
+            int32_t score = negamax(main, -infinite_score, infinite_score, depth, 0);
+            if (m_stopped) {
+                break;
+            }
+
+            main.root_move = main.pv[0][0];
+
+            info.depth = depth;
+            info.score = score;
+            info.pv.assign(main.pv[0].begin(), main.pv[0].begin() + main.pv_length[0]);
+            info.nodes = get_total_nodes();
+            info.seconds = get_elapsed_seconds();
+            get_cutoffs(info);
+
+            if (callback) {
+                callback(info);
+            }
+
+            // the next iteration would take several times as long - don't start what can't end
+            if (limits.time_ms > 0 && info.seconds * 1000.0 * 2.0 > (double)limits.time_ms) {
+                break;
+            }
+
+            // nothing left to find once a forced mate is in view
+            if (is_mate_score(score) && mate_score - std::abs(score) <= (int32_t)depth) {
+                break;
+            }
+        }
+
+        // the helpers have nothing to stop them otherwise
+        m_stopped = true;
+        if (m_pool) {
+            m_pool->wait();
+        }
+
+        info.nodes = get_total_nodes();
+        info.seconds = get_elapsed_seconds();
+        get_cutoffs(info);
+
+        return true;
+    }
+
+    void searcher::run_helper(thread_state_t& thread, uint32_t max_depth) {
+        // odd helpers start a ply ahead, so that threads are spread over two depths at once
+        for (uint32_t depth = 1 + (uint32_t)(thread.index % 2); depth <= max_depth; depth++) {
+            thread.depth = depth;
+
+            negamax(thread, -infinite_score, infinite_score, depth, 0);
+            if (m_stopped) {
+                break;
+            }
+
+            thread.root_move = thread.pv[0][0];
+        }
+    }
+
+    int32_t searcher::negamax(thread_state_t& thread, int32_t alpha, int32_t beta, uint32_t depth,
+                              size_t ply) {
+        thread.pv_length[ply] = 0;
+        if (depth == 0) {
+            return quiesce(thread, alpha, beta, ply);
+        }
+
+        increment(thread.nodes);
+
+        if (ply > 0) {
+            int32_t score;
+            if (is_draw(thread, ply)) {
+                return 0;
+            } else if (probe_tablebase(thread, ply, score)) {
+                return score;
+            }
+
+            // no line from here can beat a mate already found closer to the root
+            alpha = std::max(alpha, -mate_score + (int32_t)ply);
+            beta = std::min(beta, mate_score - (int32_t)ply - 1);
+
+            if (alpha >= beta) {
+                return alpha;
+            }
+        }
+
+        auto& instance = *thread.instance;
+        auto& data = instance.get_board()->get_data();
+
+        if (ply >= max_ply - 1) {
+            return evaluate(thread, ply);
+        }
+
+        if (should_stop(thread)) {
+            return 0;
+        }
+
+        uint64_t key = data.key;
+        packed_move_t table_move = {};
+        tt_entry_t entry;
+
+        if (m_table && m_table->probe(key, entry)) {
+            table_move = entry.move;
+
+            // a deep enough result from earlier settles this node, except at the root
+            int32_t score = score_from_table(entry.score, ply);
+            if (ply > 0 && entry.depth >= depth &&
+                (entry.bound == tt_bound::exact ||
+                 (entry.bound == tt_bound::lower && score >= beta) ||
+                 (entry.bound == tt_bound::upper && score <= alpha))) {
+                return score;
+            }
+        }
+
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        bool in_check = instance.compute_checkers() != 0;
+        if (moves.empty()) {
+            return in_check ? -mate_score + (int32_t)ply : 0;
+        }
+
+        // the previous iteration's best move goes first at the root, the table's elsewhere. a
+        // table move is only trusted if it's legal here
+        packed_move_t first_move = ply == 0 ? thread.root_move : table_move;
+        const move_undo_t* previous = instance.get_last_undo();
+
+        // helpers try the rest of the root moves in a different order each, instead of by score
+        bool rotated = ply == 0 && thread.index > 0 && moves.size() > 2;
+        if (rotated) {
+            move_to_front(moves, first_move);
+
+            size_t offset = thread.index % (moves.size() - 1);
+            std::rotate(moves.begin() + 1, moves.begin() + 1 + offset, moves.end());
+        }
+
+        move_picker picker = rotated ? move_picker(moves)
+                                     : move_picker(data, moves, first_move, thread.history, ply,
+                                                   previous);
+
+        int32_t original_alpha = alpha;
+        int32_t best = -infinite_score;
+        packed_move_t best_move = {};
+
+        // quiet moves that failed to cut off, to be penalized if a later one does
+        std::array<packed_move_t, s_max_tried_quiets> quiets;
+        size_t quiet_count = 0;
+        size_t searched = 0;
+
+        packed_move_t move;
+        while (picker.next(move)) {
+            bool tactical = move_picker::is_tactical(data, move);
+
+            make_move(thread, move, ply);
+            if (m_table) {
+                m_table->prefetch(data.key);
+            }
+
+            // checks are searched a ply deeper, so that a mate at the horizon isn't missed. a
+            // run of checks can only stretch a line to twice the iteration's depth
+            uint32_t next_depth = depth - 1;
+            if (in_check && ply < thread.depth * 2) {
+                next_depth++;
+            }
+
+            int32_t score = -negamax(thread, -beta, -alpha, next_depth, ply + 1);
+
+            instance.unmake_move();
+            if (m_stopped) {
+                return 0;
+            }
+
+            searched++;
+            if (score > best) {
+                best = score;
+
+                if (score > alpha) {
+                    alpha = score;
+                    best_move = move;
+                    update_pv(thread, ply, move);
+
+                    if (alpha >= beta) {
+                        increment(thread.cutoffs);
+                        if (searched == 1) {
+                            increment(thread.first_move_cutoffs);
+                        }
+
+                        if (!tactical) {
+                            thread.history.update(data, previous, ply, depth, move, quiets.data(),
+                                                  quiet_count);
+                        }
+
+                        break;
+                    }
+                }
+            }
+
+            if (!tactical && quiet_count < quiets.size()) {
+                quiets[quiet_count++] = move;
+            }
+        }
+
+        if (m_table) {
+            tt_bound bound = tt_bound::upper;
+            if (best >= beta) {
+                bound = tt_bound::lower;
+            } else if (best > original_alpha) {
+                bound = tt_bound::exact;
+            }
+
+            m_table->store(key, best_move, score_to_table(best, ply), depth, bound);
+        }
+
+        return best;
+    }
+
+    int32_t searcher::quiesce(thread_state_t& thread, int32_t alpha, int32_t beta, size_t ply) {
+        increment(thread.nodes);
+
+        thread.pv_length[ply] = 0;
+
+        auto& instance = *thread.instance;
+        auto& data = instance.get_board()->get_data();
+
+        if (is_draw(thread, ply)) {
+            return 0;
+        }
+
+        if (ply >= max_ply - 1 || should_stop(thread)) {
+            return evaluate(thread, ply);
+        }
+
+        // standing pat is only an option when not in check - every evasion is searched otherwise
+        bool in_check = instance.compute_checkers() != 0;
+        int32_t best = -infinite_score;
+
+        if (!in_check) {
+            best = evaluate(thread, ply);
+            if (best >= beta) {
+                return best;
+            }
+
+            alpha = std::max(alpha, best);
+        }
+
+        move_list moves;
+        instance.generate_legal_moves(moves);
+
+        if (moves.empty()) {
+            return in_check ? -mate_score + (int32_t)ply : 0;
+        }
+
+        move_picker picker(data, moves, packed_move_t(), thread.history, ply,
+                           instance.get_last_undo());
+
+        packed_move_t move;
+        while (picker.next(move)) {
+            // tactical moves are picked before any quiet one, so the rest can all be skipped
+            if (!in_check && !move_picker::is_tactical(data, move)) {
+                break;
+            }
+
+            make_move(thread, move, ply);
+            int32_t score = -quiesce(thread, -beta, -alpha, ply + 1);
+            instance.unmake_move();
+
+            if (m_stopped) {
+                return 0;
+            }
+
+            if (score > best) {
+                best = score;
+
+                if (score > alpha) {
+                    alpha = score;
+                    update_pv(thread, ply, move);
+
+                    if (alpha >= beta) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        return best;
+    }
+
+    void searcher::make_move(thread_state_t& thread, packed_move_t move, size_t ply) {
+        auto& instance = *thread.instance;
+        instance.make_move(move);
+
+        const auto& data = instance.get_board()->get_data();
+        thread.keys[ply + 1] = data.key;
+
+        if (m_network) {
+            m_network->update(thread.accumulators[ply], thread.accumulators[ply + 1],
+                              *instance.get_last_undo(), data);
+        }
+    }
+
+    int32_t searcher::evaluate(const thread_state_t& thread, size_t ply) const {
+        const auto& data = thread.instance->get_board()->get_data();
+        if (m_network) {
+            // a network's output isn't bounded by anything near a mate score
+            int32_t score = m_network->evaluate(thread.accumulators[ply], data.current_turn);
+            return std::clamp(score, -max_eval_score, max_eval_score);
+        }
+
+        return eval::evaluate(data);
+    }
+
+    bool searcher::is_draw(const thread_state_t& thread, size_t ply) const {
+        const auto& data = thread.instance->get_board()->get_data();
+        if (data.halfmove_clock >= 100) {
+            return true;
+        }
+
+        // a capture or pawn move resets the clock, and nothing before it can repeat. past the
+        // root, the line continues into the game's history
+        size_t reversible = std::min((size_t)data.halfmove_clock, ply + m_game_history.size());
+
+        for (size_t distance = 4; distance <= reversible; distance += 2) {
+            uint64_t key = distance <= ply
+                               ? thread.keys[ply - distance]
+                               : m_game_history[m_game_history.size() - (distance - ply)];
+
+            if (key == data.key) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool searcher::probe_tablebase(thread_state_t& thread, size_t ply, int32_t& score) {
+        const auto& data = thread.instance->get_board()->get_data();
+        if (bitboard::popcount(data.occupancy) > tablebase::max_pieces) {
+            return false;
+        }
+
+        tablebase_result_t result;
+        if (!thread.instance->probe_tablebase(result)) {
+            return false;
+        }
+
+        int32_t distance = (int32_t)std::min(ply + result.distance, (size_t)max_tablebase_distance);
+        switch (result.wdl) {
+        case tablebase_wdl::win:
+            score = tablebase_score - distance;
+            break;
+        case tablebase_wdl::loss:
+            score = -tablebase_score + distance;
+            break;
+        default:
+            score = 0;
+            break;
+        }
+
+        return true;
+    }
+
+    bool searcher::should_stop(thread_state_t& thread) {
+        if (m_stopped) {
+            return true;
+        }
+
+        // exact with one thread. summing every thread's count on every node costs too much
+        uint64_t nodes = thread.nodes.load(std::memory_order_relaxed);
+        bool exact = m_threads.size() == 1;
+
+        if (m_limits.nodes > 0 && (exact || (nodes & 1023) == 0) &&
+            get_total_nodes() >= m_limits.nodes) {
+            m_stopped = true;
+        } else if (m_limits.time_ms > 0 && (nodes & 1023) == 0 &&
+                   get_elapsed_seconds() * 1000.0 >= (double)m_limits.time_ms) {
+            m_stopped = true;
+        }
+
+        return m_stopped;
+    }
+
+    void searcher::update_pv(thread_state_t& thread, size_t ply, packed_move_t move) {
+        auto& pv = thread.pv[ply];
+        pv[0] = move;
+
+        size_t length = thread.pv_length[ply + 1];
+        std::copy(thread.pv[ply + 1].begin(), thread.pv[ply + 1].begin() + length, pv.begin() + 1);
+
+        thread.pv_length[ply] = length + 1;
+    }
+
+    void searcher::increment(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    uint64_t searcher::get_total_nodes() const {
+        uint64_t nodes = 0;
+        for (const auto& thread : m_threads) {
+            nodes += thread->nodes.load(std::memory_order_relaxed);
+        }
+
+        return nodes;
+    }
+
+    void searcher::get_cutoffs(search_info_t& info) const {
+        info.cutoffs = info.first_move_cutoffs = 0;
+        for (const auto& thread : m_threads) {
+            info.cutoffs += thread->cutoffs.load(std::memory_order_relaxed);
+            info.first_move_cutoffs += thread->first_move_cutoffs.load(std::memory_order_relaxed);
+        }
+    }
+
+    double searcher::get_elapsed_seconds() const {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double>(elapsed).count();
+    }
+} // namespace libchess
\ No newline at end of file
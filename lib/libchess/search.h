@@ -0,0 +1,196 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "engine.h"
+#include "move_picker.h"
+#include "nnue.h"
+#include "thread_pool.h"
+#include "transposition_table.h"
+
+namespace libchess {
+    // 0 means no limit. without any limit, the search runs until searcher::stop is called
+    struct search_limits_t {
+        uint32_t depth = 0;
+        uint64_t nodes = 0;
+        uint64_t time_ms = 0;
+    };
+
+    struct search_info_t {
+        // the deepest iteration that finished, and what it found
+        uint32_t depth = 0;
+        int32_t score = 0;
+        std::vector<packed_move_t> pv;
+
+        uint64_t nodes = 0;
+        double seconds = 0.0;
+
+        // beta cutoffs outside the quiescence search, and how many of them the first move
+        // searched caused - the closer the two, the better the moves were ordered
+        uint64_t cutoffs = 0;
+        uint64_t first_move_cutoffs = 0;
+
+        uint64_t get_nps() const { return seconds > 0.0 ? (uint64_t)(nodes / seconds) : 0; }
+
+        double get_first_move_cutoff_rate() const {
+            return cutoffs > 0 ? (double)first_move_cutoffs / (double)cutoffs : 0.0;
+        }
+    };
+
+    // called after every finished iteration
+    using search_callback_t = std::function<void(const search_info_t&)>;
+
+    // negamax alpha-beta with iterative deepening and a capture-only quiescence search, run on
+    // the engine's board in place with make_move and unmake_move. scores are in centipawns
+    // from the side to move's point of view.
+    //
+    // with more than one thread, the search is lazy smp: helper threads search the same root
+    // on copies of the board, at staggered depths and in a shuffled root order, and only share
+    // the transposition table. the caller's thread decides the result
+    class searcher {
+    public:
+        static constexpr size_t max_ply = move_history_t::max_ply;
+
+        // mate in n plies scores mate_score - n
+        static constexpr int32_t mate_score = 32000;
+        static constexpr int32_t infinite_score = mate_score + 1;
+
+        static bool is_mate_score(int32_t score) {
+            return std::abs(score) >= mate_score - (int32_t)max_ply;
+        }
+
+        // a tablebase win n plies from the root scores tablebase_score - n: below any mate the
+        // search finds itself, and above any evaluation. longer distances are cut short
+        static constexpr int32_t tablebase_score = mate_score - (int32_t)max_ply - 1;
+        static constexpr int32_t max_tablebase_distance = 512;
+
+        static bool is_tablebase_score(int32_t score) {
+            int32_t magnitude = std::abs(score);
+            return magnitude <= tablebase_score &&
+                   magnitude >= tablebase_score - max_tablebase_distance;
+        }
+
+        // static evaluations are clamped to this, so that they never read as mates or tablebase
+        // results
+        static constexpr int32_t max_eval_score = tablebase_score - max_tablebase_distance - 1;
+
+        // with a table of its own, of transposition_table::default_size_mb
+        searcher();
+        ~searcher();
+
+        searcher(const searcher&) = delete;
+        searcher& operator=(const searcher&) = delete;
+
+        // fails if the side to move has no legal moves. the board is left as it was found, and
+        // the engine's tablebases are probed if it has any
+        bool search(engine& instance, const search_limits_t& limits, search_info_t& info,
+                    const search_callback_t& callback = nullptr);
+
+        // tables can be shared between searchers. nullptr searches without one
+        void set_transposition_table(std::shared_ptr<transposition_table> table) {
+            m_table = table;
+        }
+
+        std::shared_ptr<transposition_table> get_transposition_table() const { return m_table; }
+
+        // positions are scored by the network if there is one, and by eval::evaluate otherwise.
+        // not safe while searching
+        void set_network(std::shared_ptr<nnue::network> network) { m_network = network; }
+        std::shared_ptr<nnue::network> get_network() const { return m_network; }
+
+        // 1 by default, the caller's own thread. 0 uses one thread per hardware thread. not
+        // safe while searching
+        void set_thread_count(size_t count);
+        size_t get_thread_count() const { return m_threads.size(); }
+
+        // safe to call from any thread. the search returns its last finished iteration
+        void stop() { m_stopped = true; }
+
+        // keys of the game's positions before the root, oldest first, so that lines repeating
+        // them are draws. kept for every search until replaced. not safe while searching
+        void set_game_history(const std::vector<uint64_t>& keys) { m_game_history = keys; }
+
+    private:
+        // everything a thread writes while searching, a cache line apart from other threads'
+        struct alignas(64) thread_state_t {
+            size_t index = 0;
+
+            // the caller's engine for the first thread. helpers search their own copy
+            engine* instance = nullptr;
+            std::unique_ptr<engine> own_engine;
+
+            // only written by the owning thread, read by any
+            std::atomic<uint64_t> nodes = 0;
+            std::atomic<uint64_t> cutoffs = 0;
+            std::atomic<uint64_t> first_move_cutoffs = 0;
+
+            // the iteration being searched, and the best move of the last one to finish
+            uint32_t depth = 0;
+            packed_move_t root_move;
+
+            // keys of the positions along the searched line
+            std::array<uint64_t, max_ply + 1> keys;
+
+            // the network's accumulators along the searched line, if there is a network
+            std::array<nnue::accumulator_t, max_ply + 1> accumulators;
+
+            // kept from one search to the next
+            move_history_t history;
+
+            // the principal variation found at each ply, starting at that ply
+            std::array<std::array<packed_move_t, max_ply>, max_ply> pv;
+            std::array<size_t, max_ply + 1> pv_length;
+        };
+
+        void run_helper(thread_state_t& thread, uint32_t max_depth);
+
+        int32_t negamax(thread_state_t& thread, int32_t alpha, int32_t beta, uint32_t depth,
+                        size_t ply);
+        int32_t quiesce(thread_state_t& thread, int32_t alpha, int32_t beta, size_t ply);
+
+        // makes the move and records the position it leads to at the next ply
+        void make_move(thread_state_t& thread, packed_move_t move, size_t ply);
+        int32_t evaluate(const thread_state_t& thread, size_t ply) const;
+
+        // fifty-move rule, or a repetition within the searched line or the game before it
+        bool is_draw(const thread_state_t& thread, size_t ply) const;
+        bool probe_tablebase(thread_state_t& thread, size_t ply, int32_t& score);
+        bool should_stop(thread_state_t& thread);
+
+        void update_pv(thread_state_t& thread, size_t ply, packed_move_t move);
+
+        // adds a relaxed counter without a locked instruction, as only its thread writes it
+        static void increment(std::atomic<uint64_t>& counter);
+
+        uint64_t get_total_nodes() const;
+
+        // sets the cutoff statistics of every thread
+        void get_cutoffs(search_info_t& info) const;
+        double get_elapsed_seconds() const;
+
+        std::shared_ptr<transposition_table> m_table;
+        std::shared_ptr<nnue::network> m_network;
+        std::vector<std::unique_ptr<thread_state_t>> m_threads;
+        std::vector<uint64_t> m_game_history;
+
+        // runs the helpers. none with a single thread
+        std::unique_ptr<thread_pool> m_pool;
+
+        search_limits_t m_limits;
+        std::chrono::steady_clock::time_point m_start;
+        std::atomic<bool> m_stopped = false;
+    };
+} // namespace libchess
\ No newline at end of file
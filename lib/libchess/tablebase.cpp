@@ -0,0 +1,942 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "tablebase.h"
+#include "attacks.h"
+#include "engine.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "util.h"
+#include "zobrist.h"
+#include "eval.h"
+
+namespace libchess {
+    // a byte per position: 0 for positions that can't occur, 1 for a draw, and 2 plus the
+    // distance to mate otherwise. odd distances are wins for the side to move
+    static constexpr uint8_t s_invalid = 0;
+    static constexpr uint8_t s_draw = 1;
+    static constexpr uint8_t s_distance_offset = 2;
+    static constexpr uint32_t s_max_distance = 252;
+
+    // only while generating
+    static constexpr uint8_t s_unresolved = 0xFF;
+    static constexpr uint8_t s_cannot_lose = 0xFF;
+
+    static constexpr char s_tablebase_magic[4] = { 'L', 'C', 'T', 'B' };
+    static constexpr size_t s_signature_size = 8;
+    static constexpr size_t s_tablebase_header_size = 8 + s_signature_size;
+
+    static constexpr char s_piece_letters[] = "KQRBNP";
+    static constexpr piece_type s_letter_types[] = { piece_type::king,   piece_type::queen,
+                                                     piece_type::rook,   piece_type::bishop,
+                                                     piece_type::knight, piece_type::pawn };
+
+    static size_t get_radix(piece_type type) {
+        // pawns never stand on the first or last rank
+        return type == piece_type::pawn ? board::size - board::width * 2 : board::size;
+    }
+
+    static player_color get_opposing(player_color color) {
+        return color != player_color::white ? player_color::white : player_color::black;
+    }
+
+    // both sides' pieces, king first. the rest is sorted, so that the result is canonical
+    static bool normalize_side(std::string_view text, std::string& result) {
+        if (text.empty() || text[0] != 'K') {
+            return false;
+        }
+
+        std::string pieces;
+        for (size_t i = 1; i < text.length(); i++) {
+            const char* letter = strchr(s_piece_letters + 1, text[i]);
+            if (text[i] == '\0' || letter == nullptr) {
+                return false;
+            }
+
+            pieces.push_back(text[i]);
+        }
+
+        std::sort(pieces.begin(), pieces.end(), [](char lhs, char rhs) {
+            return strchr(s_piece_letters, lhs) < strchr(s_piece_letters, rhs);
+        });
+
+        result += 'K';
+        result += pieces;
+
+        return true;
+    }
+
+    bool tablebase::parse_signature(std::string_view text, std::string& signature) {
+        size_t black_king = text.find('K', 1);
+        if (black_king == std::string_view::npos || text.length() > max_pieces ||
+            text.length() < 2) {
+            return false;
+        }
+
+        std::string result;
+        if (!normalize_side(text.substr(0, black_king), result) ||
+            !normalize_side(text.substr(black_king), result)) {
+            return false;
+        }
+
+        signature = result;
+        return true;
+    }
+
+    bool tablebase::get_signature(const board::data_t& data, std::string& signature) {
+        if (bitboard::popcount(data.occupancy) > max_pieces) {
+            return false;
+        }
+
+        std::string result;
+        for (auto color : { player_color::white, player_color::black }) {
+            const auto& masks = data.piece_masks[(size_t)color];
+            if (bitboard::popcount(masks[(size_t)piece_type::king]) != 1) {
+                return false;
+            }
+
+            for (size_t i = 0; i < std::size(s_letter_types); i++) {
+                uint32_t count = bitboard::popcount(masks[(size_t)s_letter_types[i]]);
+                result.append(count, s_piece_letters[i]);
+            }
+        }
+
+        signature = result;
+        return true;
+    }
+
+    bool tablebase::set_signature(const std::string& signature) {
+        std::string normalized;
+        if (!parse_signature(signature, normalized) || normalized != signature) {
+            return false;
+        }
+
+        m_signature = signature;
+        m_piece_count = signature.length();
+        m_entry_count = player_color_count;
+
+        player_color color = player_color::white;
+        for (size_t i = 0; i < m_piece_count; i++) {
+            if (i > 0 && signature[i] == 'K') {
+                color = player_color::black;
+            }
+
+            auto type = s_letter_types[strchr(s_piece_letters, signature[i]) - s_piece_letters];
+            m_pieces[i] = { type, color };
+            m_entry_count *= get_radix(type);
+        }
+
+        return true;
+    }
+
+    size_t tablebase::get_index(position_t position) const {
+        // identical pieces are adjacent in the signature - sort each run by square
+        for (size_t i = 1; i < m_piece_count; i++) {
+            for (size_t j = i; j > 0; j--) {
+                const auto& piece = m_pieces[j];
+                const auto& previous = m_pieces[j - 1];
+
+                if (piece.type != previous.type || piece.color != previous.color ||
+                    position.squares[j - 1] < position.squares[j]) {
+                    break;
+                }
+
+                std::swap(position.squares[j - 1], position.squares[j]);
+            }
+        }
+
+        size_t index = 0;
+        for (size_t i = 0; i < m_piece_count; i++) {
+            size_t square = position.squares[i];
+            if (m_pieces[i].type == piece_type::pawn) {
+                square -= board::width;
+            }
+
+            index = index * get_radix(m_pieces[i].type) + square;
+        }
+
+        return index * player_color_count + (size_t)position.current_turn;
+    }
+
+    void tablebase::get_position(size_t index, position_t& position) const {
+        position.current_turn = (player_color)(index % player_color_count);
+        index /= player_color_count;
+
+        for (size_t i = m_piece_count; i > 0; i--) {
+            const auto& piece = m_pieces[i - 1];
+            size_t radix = get_radix(piece.type);
+
+            size_t square = index % radix;
+            if (piece.type == piece_type::pawn) {
+                square += board::width;
+            }
+
+            position.squares[i - 1] = (uint8_t)square;
+            index /= radix;
+        }
+    }
+
+    bool tablebase::get_position(const board::data_t& data, position_t& position) const {
+        if (bitboard::popcount(data.occupancy) != m_piece_count) {
+            return false;
+        }
+
+        auto masks = data.piece_masks;
+        for (size_t i = 0; i < m_piece_count; i++) {
+            const auto& piece = m_pieces[i];
+            auto& mask = masks[(size_t)piece.color][(size_t)piece.type];
+
+            if (mask == 0) {
+                return false;
+            }
+
+            size_t square = bitboard::pop_lsb(mask);
+            if (piece.type == piece_type::pawn &&
+                (square < board::width || square >= board::size - board::width)) {
+                return false;
+            }
+
+            position.squares[i] = (uint8_t)square;
+        }
+
+        position.current_turn = data.current_turn;
+        return true;
+    }
+
+    bool tablebase::get_data(const position_t& position, board::data_t& data) const {
+        data.pieces.fill({ piece_type::none });
+        for (auto& masks : data.piece_masks) {
+            masks.fill(0);
+        }
+
+        data.color_masks.fill(0);
+        data.occupancy = 0;
+
+        for (size_t i = 0; i < m_piece_count; i++) {
+            size_t square = position.squares[i];
+            if ((data.occupancy & bitboard::square_mask(square)) != 0) {
+                return false;
+            }
+
+            board::place_piece(data, square, m_pieces[i]);
+        }
+
+        data.current_turn = position.current_turn;
+        data.player_castling_availability.flags.fill(castle_side_none);
+        data.en_passant_target.reset();
+        data.halfmove_clock = 0;
+        data.fullmove_count = 1;
+        data.key = zobrist::compute(data);
+        data.eval = eval::compute(data);
+
+        return true;
+    }
+
+    // true if a pawn of the side to move could take en passant
+    static bool is_en_passant_available(const board::data_t& data) {
+        if (!data.en_passant_target.has_value()) {
+            return false;
+        }
+
+        size_t target = bitboard::get_square(data.en_passant_target.value());
+        player_color color = data.current_turn;
+
+        bitboard_t pawns = data.piece_masks[(size_t)color][(size_t)piece_type::pawn];
+        return (attacks::pawn(get_opposing(color), target) & pawns) != 0;
+    }
+
+    static bool decode_value(uint8_t value, tablebase_result_t& result) {
+        if (value == s_invalid) {
+            return false;
+        }
+
+        if (value == s_draw) {
+            result.wdl = tablebase_wdl::draw;
+            result.distance = 0;
+        } else {
+            result.distance = value - s_distance_offset;
+            result.wdl = result.distance % 2 != 0 ? tablebase_wdl::win : tablebase_wdl::loss;
+        }
+
+        return true;
+    }
+
+    bool tablebase::probe(const board::data_t& data, tablebase_result_t& result) const {
+        position_t position;
+        if (!get_position(data, position) || is_en_passant_available(data)) {
+            return false;
+        }
+
+        for (auto availability : data.player_castling_availability.flags) {
+            if (availability != castle_side_none) {
+                return false;
+            }
+        }
+
+        return decode_value(m_values[get_index(position)], result);
+    }
+
+    std::shared_ptr<tablebase> tablebase::create(std::string_view bytes) {
+        const uint8_t* data = (const uint8_t*)bytes.data();
+        if (bytes.length() < s_tablebase_header_size ||
+            memcmp(data, s_tablebase_magic, sizeof(s_tablebase_magic)) != 0) {
+            return nullptr;
+        }
+
+        uint32_t file_version = 0;
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            file_version |= (uint32_t)data[4 + i] << (i * 8);
+        }
+
+        std::string_view signature = bytes.substr(8, s_signature_size);
+        signature = signature.substr(0, signature.find('\0'));
+
+        auto table = std::shared_ptr<tablebase>(new tablebase);
+        if (file_version != version || !table->set_signature(std::string(signature)) ||
+            bytes.length() != s_tablebase_header_size + table->m_entry_count) {
+            return nullptr;
+        }
+
+        table->m_values = data + s_tablebase_header_size;
+        return table;
+    }
+
+    std::shared_ptr<tablebase> tablebase::open(const std::string& path) {
+        auto file = mapped_file::open(path, file_access::random);
+        if (!file) {
+            return nullptr;
+        }
+
+        auto table = create(file->get_view());
+        if (table) {
+            table->m_storage = file;
+        }
+
+        return table;
+    }
+
+    bool tablebase::write(std::ostream& stream) const {
+        uint8_t header[s_tablebase_header_size] = {};
+        memcpy(header, s_tablebase_magic, sizeof(s_tablebase_magic));
+
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            header[4 + i] = (uint8_t)(version >> (i * 8));
+        }
+
+        memcpy(header + 8, m_signature.data(), m_signature.length());
+
+        stream.write((const char*)header, sizeof(header));
+        stream.write((const char*)m_values, (std::streamsize)m_entry_count);
+
+        return !stream.fail();
+    }
+
+    void tablebase_set::add(std::shared_ptr<tablebase> table) {
+        m_tables[table->get_signature()] = table;
+    }
+
+    std::shared_ptr<tablebase> tablebase_set::find(std::string_view signature) const {
+        auto it = m_tables.find(std::string(signature));
+        return it != m_tables.end() ? it->second : nullptr;
+    }
+
+    // the same position with the colors swapped and the board flipped top to bottom, which has
+    // the same result for the side to move. the clocks, key and eval aren't carried over
+    static void get_mirrored_data(const board::data_t& data, board::data_t& mirrored) {
+        mirrored.pieces.fill({ piece_type::none });
+        for (auto& masks : mirrored.piece_masks) {
+            masks.fill(0);
+        }
+
+        mirrored.color_masks.fill(0);
+        mirrored.occupancy = 0;
+
+        bitboard_t occupancy = data.occupancy;
+        while (occupancy != 0) {
+            size_t square = bitboard::pop_lsb(occupancy);
+
+            piece_info_t piece = data.pieces[square ^ 56];
+            piece.color = piece.color == player_color::white ? player_color::black
+                                                             : player_color::white;
+
+            board::place_piece(mirrored, square ^ 56, piece);
+        }
+
+        mirrored.current_turn = data.current_turn == player_color::white ? player_color::black
+                                                                         : player_color::white;
+
+        mirrored.player_castling_availability[player_color::white] =
+            data.player_castling_availability[player_color::black];
+        mirrored.player_castling_availability[player_color::black] =
+            data.player_castling_availability[player_color::white];
+
+        mirrored.en_passant_target.reset();
+        if (data.en_passant_target.has_value()) {
+            const auto& target = data.en_passant_target.value();
+            mirrored.en_passant_target = coord(target.x, (int32_t)board::width - 1 - target.y);
+        }
+    }
+
+    bool tablebase_set::probe(const board::data_t& data, tablebase_result_t& result) const {
+        std::string signature;
+        if (!tablebase::get_signature(data, signature)) {
+            return false;
+        }
+
+        if (signature == "KK") {
+            result.wdl = tablebase_wdl::draw;
+            result.distance = 0;
+
+            return true;
+        }
+
+        auto table = find(signature);
+        if (table) {
+            return table->probe(data, result);
+        }
+
+        // tables are generated for one side's material only, e.g. "KQK" but not "KKQ"
+        size_t black_king = signature.find('K', 1);
+        table = find(signature.substr(black_king) + signature.substr(0, black_king));
+        if (!table) {
+            return false;
+        }
+
+        board::data_t mirrored;
+        get_mirrored_data(data, mirrored);
+
+        return table->probe(mirrored, result);
+    }
+
+    // every signature a capture, a promotion, or a capturing promotion leads to
+    static void get_dependencies(const std::string& signature,
+                                 std::vector<std::string>& dependencies) {
+        size_t black_king = signature.find('K', 1);
+        std::array<std::string, player_color_count> sides = { signature.substr(0, black_king),
+                                                               signature.substr(black_king) };
+
+        auto add = [&](const std::string& white, const std::string& black) {
+            std::string dependency;
+            if (tablebase::parse_signature(white + black, dependency)) {
+                dependencies.push_back(dependency);
+            }
+        };
+
+        for (size_t color = 0; color < player_color_count; color++) {
+            const auto& side = sides[color];
+            const auto& other = sides[color ^ 1];
+
+            // one of this side's pieces captured
+            for (size_t i = 1; i < side.length(); i++) {
+                std::string reduced = side.substr(0, i) + side.substr(i + 1);
+                color == 0 ? add(reduced, other) : add(other, reduced);
+            }
+
+            size_t pawn = side.find('P');
+            if (pawn == std::string::npos) {
+                continue;
+            }
+
+            for (char promotion : { 'Q', 'R', 'B', 'N' }) {
+                std::string promoted = side;
+                promoted[pawn] = promotion;
+                color == 0 ? add(promoted, other) : add(other, promoted);
+
+                for (size_t i = 1; i < other.length(); i++) {
+                    std::string reduced = other.substr(0, i) + other.substr(i + 1);
+                    color == 0 ? add(promoted, reduced) : add(reduced, promoted);
+                }
+            }
+        }
+    }
+
+    bool tablebase_set::generate(std::string_view text, thread_pool* pool) {
+        std::string signature;
+        if (!tablebase::parse_signature(text, signature)) {
+            return false;
+        }
+
+        if (signature == "KK" || m_tables.find(signature) != m_tables.end()) {
+            return true;
+        }
+
+        std::vector<std::string> dependencies;
+        get_dependencies(signature, dependencies);
+
+        for (const auto& dependency : dependencies) {
+            if (!generate(dependency, pool)) {
+                return false;
+            }
+        }
+
+        auto table = build(signature, pool);
+        if (!table) {
+            return false;
+        }
+
+        add(table);
+        return true;
+    }
+
+    // the side to move's best en passant capture, from its point of view - nothing if it has
+    // none. fails if a capture leads somewhere that can't be probed
+    static bool probe_en_passant(const tablebase_set& set, engine& instance, move_list& moves,
+                                 std::optional<tablebase_result_t>& best) {
+        best.reset();
+
+        auto& data = instance.get_board()->get_data();
+        if (!is_en_passant_available(data)) {
+            return true;
+        }
+
+        instance.generate_legal_moves(moves);
+        for (auto move : moves) {
+            if (move.get_flag() != packed_move_t::flag_en_passant) {
+                continue;
+            }
+
+            tablebase_result_t result;
+            instance.make_move(move);
+            bool found = set.probe(data, result);
+            instance.unmake_move();
+
+            if (!found) {
+                return false;
+            }
+
+            // a win for the opponent is a loss a ply longer, and the other way around
+            if (result.wdl != tablebase_wdl::draw) {
+                result.wdl = result.wdl == tablebase_wdl::win ? tablebase_wdl::loss
+                                                              : tablebase_wdl::win;
+                result.distance++;
+            }
+
+            // the quickest win, or the slowest loss
+            bool better = !best.has_value() || result.wdl > best->wdl;
+            if (!better && result.wdl == best->wdl) {
+                better = result.wdl == tablebase_wdl::win ? result.distance < best->distance
+                                                          : result.distance > best->distance;
+            }
+
+            if (better) {
+                best = result;
+            }
+        }
+
+        return true;
+    }
+
+    // runs task(begin, end, worker) over slices of [0, count), on the pool if there is one
+    template <typename T>
+    static void run_slices(size_t count, thread_pool* pool, const T& task) {
+        if (pool == nullptr) {
+            task(0, count, 0);
+            return;
+        }
+
+        size_t slice_count = pool->get_thread_count() * 16;
+        size_t slice_size = std::max((count + slice_count - 1) / slice_count, (size_t)1024);
+
+        for (size_t begin = 0; begin < count; begin += slice_size) {
+            size_t end = std::min(begin + slice_size, count);
+            pool->submit([&task, begin, end](size_t worker) { task(begin, end, worker); });
+        }
+
+        pool->wait();
+    }
+
+    std::shared_ptr<tablebase> tablebase_set::build(const std::string& signature,
+                                                    thread_pool* pool) const {
+        auto table = std::shared_ptr<tablebase>(new tablebase);
+        if (!table->set_signature(signature)) {
+            return nullptr;
+        }
+
+        size_t count = table->m_entry_count;
+        if (count > std::numeric_limits<uint32_t>::max()) {
+            return nullptr;
+        }
+
+        auto values = std::make_unique<std::atomic<uint8_t>[]>(count);
+        auto counters = std::make_unique<std::atomic<uint8_t>[]>(count);
+
+        // positions to resolve as wins, and counters to decrement, once the level of the
+        // distance they're filed under is reached
+        static constexpr size_t level_count = s_max_distance + 1;
+        std::vector<std::vector<uint32_t>> win_events(level_count), loss_events(level_count);
+        std::vector<uint32_t> mated;
+
+        // a double push the opponent can take en passant leads to a position the table doesn't
+        // index. its capture is looked up ahead of time, and the move resolves by whichever of
+        // that and the pushed position (indexed without the en passant right) is better for the
+        // opponent. push events are checked against the pushed position's value at the time
+        struct push_t {
+            uint32_t index, pushed;
+        };
+
+        std::vector<std::vector<push_t>> push_win_events(level_count),
+            push_loss_events(level_count);
+
+        // the best capture, from the opponent's point of view, by index and pawn destination
+        std::unordered_map<uint64_t, tablebase_result_t> en_passant;
+        auto get_push_key = [](uint32_t index, size_t destination) {
+            return (uint64_t)index * board::size + destination;
+        };
+
+        std::mutex mutex;
+        std::atomic<bool> failed = false;
+
+        size_t worker_count = pool != nullptr ? pool->get_thread_count() : 1;
+        std::vector<std::unique_ptr<engine>> engines;
+
+        for (size_t i = 0; i < worker_count; i++) {
+            engines.push_back(std::make_unique<engine>(board::create()));
+        }
+
+        // every legal position gets its moves counted, and the ones leaving the table probed
+        run_slices(count, pool, [&](size_t begin, size_t end, size_t worker) {
+            auto& instance = *engines[worker];
+            auto& data = instance.get_board()->get_data();
+
+            std::vector<std::vector<uint32_t>> wins(level_count), losses(level_count);
+            std::vector<std::vector<push_t>> push_wins(level_count), push_losses(level_count);
+            std::vector<std::pair<uint64_t, tablebase_result_t>> captures;
+            std::vector<uint32_t> local_mated;
+
+            tablebase::position_t position, pushed;
+            move_list moves, replies;
+
+            for (size_t index = begin; index < end; index++) {
+                values[index] = s_invalid;
+
+                table->get_position(index, position);
+                if (table->get_index(position) != index || !table->get_data(position, data)) {
+                    continue;
+                }
+
+                // the side that just moved can't be in check
+                player_color opposing = get_opposing(data.current_turn);
+                bitboard_t king = data.piece_masks[(size_t)opposing][(size_t)piece_type::king];
+
+                if (attacks::get_attackers(data, bitboard::lsb(king), data.current_turn,
+                                           data.occupancy) != 0) {
+                    continue;
+                }
+
+                instance.generate_legal_moves(moves);
+                if (moves.empty()) {
+                    if (instance.compute_checkers() != 0) {
+                        values[index] = s_distance_offset;
+                        local_mated.push_back((uint32_t)index);
+                    } else {
+                        values[index] = s_draw;
+                    }
+
+                    continue;
+                }
+
+                uint32_t remaining = 0;
+                uint32_t best_win = std::numeric_limits<uint32_t>::max();
+                bool can_lose = true;
+
+                for (auto move : moves) {
+                    bool capture = (data.occupancy &
+                                    bitboard::square_mask(move.get_destination())) != 0;
+
+                    if (!capture && move.get_flag() != packed_move_t::flag_promotion) {
+                        remaining++;
+
+                        size_t origin = move.get_position();
+                        size_t destination = move.get_destination();
+                        bitboard_t pawns =
+                            data.piece_masks[(size_t)data.current_turn][(size_t)piece_type::pawn];
+
+                        if ((pawns & bitboard::square_mask(origin)) == 0 ||
+                            std::max(origin, destination) - std::min(origin, destination) !=
+                                board::width * 2) {
+                            continue;
+                        }
+
+                        std::optional<tablebase_result_t> reply;
+                        instance.make_move(move);
+
+                        bool probed = probe_en_passant(*this, instance, replies, reply);
+                        table->get_position(data, pushed);
+                        instance.unmake_move();
+
+                        if (!probed) {
+                            failed = true;
+                            return;
+                        } else if (!reply.has_value()) {
+                            continue;
+                        }
+
+                        push_t push = { (uint32_t)index, (uint32_t)table->get_index(pushed) };
+                        captures.push_back({ get_push_key(push.index, destination), *reply });
+
+                        if (reply->wdl == tablebase_wdl::win) {
+                            push_losses[reply->distance].push_back(push);
+                        } else if (reply->wdl == tablebase_wdl::loss &&
+                                   reply->distance + 1 <= s_max_distance) {
+                            push_wins[reply->distance + 1].push_back(push);
+                        }
+
+                        continue;
+                    }
+
+                    tablebase_result_t result;
+                    instance.make_move(move);
+                    bool found = probe(data, result);
+                    instance.unmake_move();
+
+                    if (!found) {
+                        failed = true;
+                        return;
+                    }
+
+                    // results are from the opponent's point of view
+                    switch (result.wdl) {
+                    case tablebase_wdl::draw:
+                        can_lose = false;
+                        break;
+                    case tablebase_wdl::loss:
+                        can_lose = false;
+                        best_win = std::min(best_win, result.distance + 1);
+                        break;
+                    case tablebase_wdl::win:
+                        remaining++;
+                        losses[result.distance].push_back((uint32_t)index);
+                        break;
+                    }
+                }
+
+                if (best_win <= s_max_distance) {
+                    wins[best_win].push_back((uint32_t)index);
+                }
+
+                values[index] = s_unresolved;
+                counters[index] = can_lose ? (uint8_t)remaining : s_cannot_lose;
+            }
+
+            util::mutex_lock lock(mutex);
+            mated.insert(mated.end(), local_mated.begin(), local_mated.end());
+            en_passant.insert(captures.begin(), captures.end());
+
+            for (size_t i = 0; i < level_count; i++) {
+                win_events[i].insert(win_events[i].end(), wins[i].begin(), wins[i].end());
+                loss_events[i].insert(loss_events[i].end(), losses[i].begin(), losses[i].end());
+
+                push_win_events[i].insert(push_win_events[i].end(), push_wins[i].begin(),
+                                          push_wins[i].end());
+                push_loss_events[i].insert(push_loss_events[i].end(), push_losses[i].begin(),
+                                           push_losses[i].end());
+            }
+        });
+
+        if (failed) {
+            return nullptr;
+        }
+
+        size_t last_event_level = 0;
+        for (size_t i = 0; i < level_count; i++) {
+            if (!win_events[i].empty() || !loss_events[i].empty() ||
+                !push_win_events[i].empty() || !push_loss_events[i].empty()) {
+                last_event_level = i;
+            }
+        }
+
+        auto resolve = [&](uint32_t index, uint32_t distance) {
+            uint8_t expected = s_unresolved;
+            return values[index].compare_exchange_strong(expected,
+                                                         (uint8_t)(s_distance_offset + distance));
+        };
+
+        // only final once resolved. wins are odd distances, losses even ones
+        auto is_resolved = [&](uint32_t index, bool win) {
+            uint8_t value = values[index].load();
+            return value >= s_distance_offset && value != s_unresolved &&
+                   (value - s_distance_offset) % 2 == (win ? 1 : 0);
+        };
+
+        // one fewer move left that doesn't lose. a loss once none are left
+        auto decrement = [&](uint32_t index, uint32_t distance) {
+            if (values[index].load() != s_unresolved || counters[index].load() == s_cannot_lose) {
+                return false;
+            }
+
+            return counters[index].fetch_sub(1) == 1 && resolve(index, distance);
+        };
+
+        // positions are resolved a level at a time, in order of distance, so that a win is as
+        // short as possible and a loss as long as possible
+        std::vector<uint32_t> current = std::move(mated), next;
+        for (uint32_t level = 0; level <= last_event_level || !current.empty(); level++) {
+            if (level >= s_max_distance) {
+                return nullptr;
+            }
+
+            for (uint32_t index : win_events[level]) {
+                if (resolve(index, level)) {
+                    current.push_back(index);
+                }
+            }
+
+            // the capture loses, but the opponent can only pass it up if the pushed position
+            // loses as well. if it loses slower than the capture, the walk below resolves it
+            for (const auto& push : push_win_events[level]) {
+                if (is_resolved(push.pushed, false) && resolve(push.index, level)) {
+                    current.push_back(push.index);
+                }
+            }
+
+            next.clear();
+            for (uint32_t index : loss_events[level]) {
+                if (decrement(index, level + 1)) {
+                    next.push_back(index);
+                }
+            }
+
+            // the capture wins - unless the pushed position was already found to win at least
+            // as fast, in which case the walk has counted the move
+            for (const auto& push : push_loss_events[level]) {
+                if (!is_resolved(push.pushed, true) && decrement(push.index, level + 1)) {
+                    next.push_back(push.index);
+                }
+            }
+
+            run_slices(current.size(), pool, [&](size_t begin, size_t end, size_t) {
+                std::vector<uint32_t> found;
+                tablebase::position_t position, previous;
+
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t index = current[i];
+                    bool lost = (values[index].load() - s_distance_offset) % 2 == 0;
+
+                    table->get_position(index, position);
+                    player_color mover = get_opposing(position.current_turn);
+
+                    bitboard_t occupancy = 0;
+                    for (size_t j = 0; j < table->m_piece_count; j++) {
+                        occupancy |= bitboard::square_mask(position.squares[j]);
+                    }
+
+                    // every non-capturing move that could have led here
+                    for (size_t j = 0; j < table->m_piece_count; j++) {
+                        const auto& piece = table->m_pieces[j];
+                        if (piece.color != mover) {
+                            continue;
+                        }
+
+                        size_t square = position.squares[j];
+                        bitboard_t origins = 0;
+
+                        switch (piece.type) {
+                        case piece_type::king:
+                            origins = attacks::king(square);
+                            break;
+                        case piece_type::queen:
+                            origins = attacks::queen(square, occupancy);
+                            break;
+                        case piece_type::rook:
+                            origins = attacks::rook(square, occupancy);
+                            break;
+                        case piece_type::bishop:
+                            origins = attacks::bishop(square, occupancy);
+                            break;
+                        case piece_type::knight:
+                            origins = attacks::knight(square);
+                            break;
+                        case piece_type::pawn: {
+                            bitboard_t pawn = bitboard::square_mask(square);
+                            bitboard_t empty = ~occupancy;
+
+                            // back one rank, or two from the fourth (fifth for black) rank
+                            if (mover == player_color::white) {
+                                origins = bitboard::shift_south(pawn) & ~bitboard::rank_1;
+                                origins |= bitboard::shift_south(
+                                    bitboard::shift_south(pawn & bitboard::rank_mask(3)) & empty);
+                            } else {
+                                origins = bitboard::shift_north(pawn) & ~bitboard::rank_8;
+                                origins |= bitboard::shift_north(
+                                    bitboard::shift_north(pawn & bitboard::rank_mask(4)) & empty);
+                            }
+                        } break;
+                        default:
+                            break;
+                        }
+
+                        origins &= ~occupancy;
+                        while (origins != 0) {
+                            size_t origin = bitboard::pop_lsb(origins);
+
+                            previous = position;
+                            previous.squares[j] = (uint8_t)origin;
+                            previous.current_turn = mover;
+
+                            auto previous_index = (uint32_t)table->get_index(previous);
+
+                            // a double push the opponent could have taken en passant only
+                            // counts if this position is better for the opponent than the
+                            // capture. the push events above cover the rest
+                            if (piece.type == piece_type::pawn &&
+                                std::max(origin, square) - std::min(origin, square) ==
+                                    board::width * 2) {
+                                auto it = en_passant.find(get_push_key(previous_index, square));
+                                if (it != en_passant.end()) {
+                                    const auto& capture = it->second;
+                                    bool passed_up =
+                                        lost ? capture.wdl == tablebase_wdl::loss &&
+                                                   level >= capture.distance
+                                             : capture.wdl != tablebase_wdl::win ||
+                                                   level <= capture.distance;
+
+                                    if (!passed_up) {
+                                        continue;
+                                    }
+                                }
+                            }
+
+                            bool resolved = lost ? resolve(previous_index, level + 1)
+                                                 : decrement(previous_index, level + 1);
+
+                            if (resolved) {
+                                found.push_back(previous_index);
+                            }
+                        }
+                    }
+                }
+
+                util::mutex_lock lock(mutex);
+                next.insert(next.end(), found.begin(), found.end());
+            });
+
+            std::swap(current, next);
+        }
+
+        // anything left unresolved can't be forced either way
+        auto storage = std::make_shared<std::vector<uint8_t>>(count);
+        for (size_t i = 0; i < count; i++) {
+            uint8_t value = values[i].load();
+            (*storage)[i] = value == s_unresolved ? s_draw : value;
+        }
+
+        table->m_values = storage->data();
+        table->m_storage = storage;
+
+        return table;
+    }
+} // namespace libchess
\ No newline at end of file
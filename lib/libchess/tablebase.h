@@ -0,0 +1,127 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "board.h"
+
+namespace libchess {
+    class thread_pool;
+
+    enum class tablebase_wdl : uint8_t { loss = 0, draw, win };
+
+    struct tablebase_result_t {
+        // from the point of view of the side to move
+        tablebase_wdl wdl;
+
+        // plies until mate with best play from both sides. 0 for a draw, or if already mated
+        uint32_t distance;
+    };
+
+    // win, draw or loss and distance to mate for every position with one material signature,
+    // a byte per position in a dense index. en passant rights aren't part of the index, and the
+    // fifty-move rule is ignored
+    class tablebase {
+    public:
+        static constexpr size_t max_pieces = 4;
+        static constexpr uint32_t version = 1;
+
+        // white's pieces, then black's, each starting with the king. the rest is sorted into
+        // queen, rook, bishop, knight and pawn order - e.g. "KQK", "KRKP" or "KBNK"
+        static bool parse_signature(std::string_view text, std::string& signature);
+
+        // fails if a side doesn't have exactly one king, or there are too many pieces
+        static bool get_signature(const board::data_t& data, std::string& signature);
+
+        // maps the file instead of reading it. nullptr if it can't be opened or isn't a table
+        static std::shared_ptr<tablebase> open(const std::string& path);
+
+        // does not copy - the bytes have to outlive the table
+        static std::shared_ptr<tablebase> create(std::string_view bytes);
+
+        ~tablebase() = default;
+
+        tablebase(const tablebase&) = delete;
+        tablebase& operator=(const tablebase&) = delete;
+
+        bool write(std::ostream& stream) const;
+
+        const std::string& get_signature() const { return m_signature; }
+        size_t get_entry_count() const { return m_entry_count; }
+
+        // fails if the material doesn't match, either side can castle, an en passant capture
+        // is available, or the position is illegal
+        bool probe(const board::data_t& data, tablebase_result_t& result) const;
+
+    private:
+        friend class tablebase_set;
+
+        // squares of every piece in signature order, and the side to move
+        struct position_t {
+            std::array<uint8_t, max_pieces> squares;
+            player_color current_turn;
+        };
+
+        tablebase() = default;
+
+        bool set_signature(const std::string& signature);
+
+        // pieces of the same kind are indexed in ascending square order, so that every position
+        // has exactly one index. only the canonical index of a position is ever valid
+        size_t get_index(position_t position) const;
+        void get_position(size_t index, position_t& position) const;
+
+        bool get_position(const board::data_t& data, position_t& position) const;
+
+        // false if two pieces share a square
+        bool get_data(const position_t& position, board::data_t& data) const;
+
+        std::string m_signature;
+        std::array<piece_info_t, max_pieces> m_pieces;
+        size_t m_piece_count = 0;
+        size_t m_entry_count = 0;
+
+        // the mapping or buffer m_values points into, if the table owns it
+        std::shared_ptr<const void> m_storage;
+        const uint8_t* m_values = nullptr;
+    };
+
+    // tables by signature, so that any position with few enough pieces can be probed
+    class tablebase_set {
+    public:
+        tablebase_set() = default;
+        ~tablebase_set() = default;
+
+        tablebase_set(const tablebase_set&) = delete;
+        tablebase_set& operator=(const tablebase_set&) = delete;
+
+        void add(std::shared_ptr<tablebase> table);
+        std::shared_ptr<tablebase> find(std::string_view signature) const;
+
+        // builds the table by retrograde analysis, along with every table its captures and
+        // promotions lead into, and adds them all. tables already in the set are reused. a
+        // double push that allows en passant is scored with the capture looked up in advance
+        bool generate(std::string_view signature, thread_pool* pool = nullptr);
+
+        // positions with bare kings are always a draw, table or not. a position with only the
+        // colors reversed from a table's signature is looked up with colors and ranks mirrored
+        bool probe(const board::data_t& data, tablebase_result_t& result) const;
+
+    private:
+        std::shared_ptr<tablebase> build(const std::string& signature, thread_pool* pool) const;
+
+        std::unordered_map<std::string, std::shared_ptr<tablebase>> m_tables;
+    };
+} // namespace libchess
\ No newline at end of file
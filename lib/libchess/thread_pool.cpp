@@ -0,0 +1,136 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "thread_pool.h"
+#include "util.h"
+
+namespace libchess {
+    thread_pool::thread_pool(size_t thread_count) {
+        if (thread_count == 0) {
+            thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        for (size_t i = 0; i < thread_count; i++) {
+            m_queues.push_back(std::make_unique<worker_queue_t>());
+        }
+
+        for (size_t i = 0; i < thread_count; i++) {
+            m_threads.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            util::mutex_lock lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_task_available.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void thread_pool::submit(const task_t& task) {
+        size_t index;
+        {
+            util::mutex_lock lock(m_mutex);
+
+            index = m_next_queue;
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            m_pending++;
+        }
+
+        auto& queue = *m_queues[index];
+        {
+            util::mutex_lock lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+
+        {
+            // under the lock so that a worker can't miss the wakeup between its check and wait
+            util::mutex_lock lock(m_mutex);
+            m_queued++;
+        }
+
+        m_task_available.notify_one();
+    }
+
+    void thread_pool::wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_tasks_finished.wait(lock, [this]() { return m_pending == 0; });
+    }
+
+    void thread_pool::worker_loop(size_t index) {
+        while (true) {
+            {
+                // claiming a queued task up front means a woken worker always has one to find,
+                // instead of waking again and again while another worker takes the last one
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_task_available.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+
+                if (m_queued == 0) {
+                    break;
+                }
+
+                m_queued--;
+            }
+
+            // another worker can take the task this scan was about to find, but every claim
+            // leaves one in some queue, so the next scan finds one
+            task_t task;
+            while (!pop_task(index, task)) {
+                std::this_thread::yield();
+            }
+
+            task(index);
+
+            util::mutex_lock lock(m_mutex);
+            if (--m_pending == 0) {
+                m_tasks_finished.notify_all();
+            }
+        }
+    }
+
+    bool thread_pool::pop_task(size_t index, task_t& task) {
+        {
+            auto& queue = *m_queues[index];
+            util::mutex_lock lock(queue.mutex);
+
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < m_queues.size(); i++) {
+            auto& queue = *m_queues[(index + i) % m_queues.size()];
+            util::mutex_lock lock(queue.mutex);
+
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+} // namespace libchess
\ No newline at end of file
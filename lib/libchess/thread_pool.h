@@ -0,0 +1,65 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+namespace libchess {
+    // a fixed set of workers, each with its own task queue. an idle worker steals from the
+    // front of another worker's queue, so uneven tasks still spread across every thread
+    class thread_pool {
+    public:
+        // the index of the worker running the task, for indexing per-worker state
+        using task_t = std::function<void(size_t)>;
+
+        // 0 uses one thread per hardware thread
+        thread_pool(size_t thread_count = 0);
+        ~thread_pool();
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        size_t get_thread_count() const { return m_threads.size(); }
+
+        void submit(const task_t& task);
+
+        // blocks until every submitted task has finished
+        void wait();
+
+    private:
+        struct worker_queue_t {
+            std::mutex mutex;
+            std::deque<task_t> tasks;
+        };
+
+        void worker_loop(size_t index);
+
+        // own queue from the back, other queues from the front
+        bool pop_task(size_t index, task_t& task);
+
+        std::vector<std::unique_ptr<worker_queue_t>> m_queues;
+        std::vector<std::thread> m_threads;
+        size_t m_next_queue = 0;
+
+        // tasks in a queue that no worker has claimed, and tasks that haven't finished yet.
+        // both are guarded by m_mutex
+        size_t m_queued = 0;
+        size_t m_pending = 0;
+
+        bool m_stopping = false;
+        std::mutex m_mutex;
+        std::condition_variable m_task_available, m_tasks_finished;
+    };
+} // namespace libchess
\ No newline at end of file
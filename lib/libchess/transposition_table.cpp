@@ -0,0 +1,176 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "transposition_table.h"
+#include "thread_pool.h"
+
+namespace libchess {
+    // from the least significant bit up: move16, score16, depth8, bound2, age6. a stored bound
+    // is never tt_bound::none, so no entry's data is 0
+    static constexpr uint32_t s_score_shift = 16;
+    static constexpr uint32_t s_depth_shift = 32;
+    static constexpr uint32_t s_bound_shift = 40;
+    static constexpr uint32_t s_age_shift = 42;
+    static constexpr uint8_t s_age_mask = 0x3F;
+
+    static uint8_t get_age(uint64_t data) { return (uint8_t)(data >> s_age_shift) & s_age_mask; }
+    static uint32_t get_depth(uint64_t data) { return (uint32_t)(data >> s_depth_shift) & 0xFF; }
+
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t));
+
+    transposition_table::transposition_table(size_t size_mb, thread_pool* pool) {
+        resize(size_mb, pool);
+    }
+
+    void transposition_table::resize(size_t size_mb, thread_pool* pool) {
+        size_t bucket_count = std::max<size_t>(size_mb * 1024 * 1024 / sizeof(bucket_t), 1);
+
+        // round down to a power of two so that indexing is a mask
+        size_t power = 1;
+        while (power * 2 <= bucket_count) {
+            power *= 2;
+        }
+
+        if (!m_buckets || power != m_mask + 1) {
+            m_buckets.reset();
+            m_buckets = std::make_unique<bucket_t[]>(power);
+            m_mask = power - 1;
+        }
+
+        clear(pool);
+    }
+
+    void transposition_table::clear(thread_pool* pool) {
+        size_t count = m_mask + 1;
+        auto clear_range = [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                for (auto& slot : m_buckets[i].entries) {
+                    slot.check.store(0, std::memory_order_relaxed);
+                    slot.data.store(0, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        // not worth handing out below a few megabytes
+        size_t slice_size = 1 << 16;
+        if (pool == nullptr || count <= slice_size) {
+            clear_range(0, count);
+        } else {
+            for (size_t begin = 0; begin < count; begin += slice_size) {
+                size_t end = std::min(begin + slice_size, count);
+                pool->submit([&clear_range, begin, end](size_t) { clear_range(begin, end); });
+            }
+
+            pool->wait();
+        }
+
+        m_age = 0;
+    }
+
+    void transposition_table::new_search() { m_age = (m_age + 1) & s_age_mask; }
+
+    bool transposition_table::probe(uint64_t key, tt_entry_t& entry) const {
+        const auto& bucket = m_buckets[key & m_mask];
+
+        for (const auto& slot : bucket.entries) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (data == 0 || (slot.check.load(std::memory_order_relaxed) ^ data) != key) {
+                continue;
+            }
+
+            entry.move.value = (uint16_t)data;
+            entry.score = (int16_t)(uint16_t)(data >> s_score_shift);
+            entry.depth = (uint8_t)get_depth(data);
+            entry.bound = (tt_bound)((data >> s_bound_shift) & 3);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void transposition_table::store(uint64_t key, packed_move_t move, int32_t score,
+                                    uint32_t depth, tt_bound bound) {
+        auto& bucket = m_buckets[key & m_mask];
+
+        // the same position, an empty slot, or whichever entry is shallowest and oldest
+        entry_t* target = nullptr;
+        uint64_t previous = 0;
+        bool same_key = false;
+        int32_t lowest_worth = std::numeric_limits<int32_t>::max();
+
+        for (auto& slot : bucket.entries) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            same_key = data != 0 && (slot.check.load(std::memory_order_relaxed) ^ data) == key;
+
+            if (data == 0 || same_key) {
+                target = &slot;
+                previous = data;
+                break;
+            }
+
+            int32_t age = (int32_t)((m_age - get_age(data)) & s_age_mask);
+            int32_t worth = (int32_t)get_depth(data) - age * 8;
+
+            if (worth < lowest_worth) {
+                target = &slot;
+                previous = data;
+                lowest_worth = worth;
+            }
+        }
+
+        if (same_key) {
+            // a shallower bound from the same search isn't worth losing a deeper one for
+            if (bound != tt_bound::exact && get_age(previous) == m_age &&
+                depth + 2 < get_depth(previous)) {
+                return;
+            }
+
+            if (move.value == 0) {
+                move.value = (uint16_t)previous;
+            }
+        }
+
+        uint64_t data = (uint64_t)move.value |
+                        ((uint64_t)(uint16_t)(int16_t)score << s_score_shift) |
+                        ((uint64_t)std::min<uint32_t>(depth, 0xFF) << s_depth_shift) |
+                        ((uint64_t)bound << s_bound_shift) | ((uint64_t)m_age << s_age_shift);
+
+        target->data.store(data, std::memory_order_relaxed);
+        target->check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    size_t transposition_table::get_size_mb() const {
+        return (m_mask + 1) * sizeof(bucket_t) / (1024 * 1024);
+    }
+
+    uint32_t transposition_table::get_hashfull() const {
+        size_t bucket_count = std::min<size_t>(1000 / entries_per_bucket, m_mask + 1);
+        uint32_t used = 0;
+
+        for (size_t i = 0; i < bucket_count; i++) {
+            for (const auto& slot : m_buckets[i].entries) {
+                uint64_t data = slot.data.load(std::memory_order_relaxed);
+                if (data != 0 && get_age(data) == m_age) {
+                    used++;
+                }
+            }
+        }
+
+        return (uint32_t)(used * 1000 / (bucket_count * entries_per_bucket));
+    }
+} // namespace libchess
\ No newline at end of file
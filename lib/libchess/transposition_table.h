@@ -0,0 +1,93 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "move_list.h"
+
+namespace libchess {
+    class thread_pool;
+
+    enum class tt_bound : uint8_t { none = 0, upper, lower, exact };
+
+    struct tt_entry_t {
+        // packed_move_t() with a value of 0 (a1a1) if no move was stored
+        packed_move_t move;
+        int16_t score;
+        uint8_t depth;
+        tt_bound bound;
+    };
+
+    // search results keyed by position, shared between threads without locks. an entry is a
+    // 64-bit data word - move16, score16, depth8, then the bound and age - and a check word
+    // holding the full key xored with the data. a read only matches if both words come from
+    // the same write of the same key, so neither a torn write nor another position that shares
+    // the bucket is ever returned. four entries make a bucket, and a bucket is one cache line
+    class transposition_table {
+    public:
+        static constexpr size_t entries_per_bucket = 4;
+        static constexpr size_t default_size_mb = 16;
+
+        // rounded down to a power of two buckets. the pool, if any, clears the table in slices
+        transposition_table(size_t size_mb = default_size_mb, thread_pool* pool = nullptr);
+        ~transposition_table() = default;
+
+        transposition_table(const transposition_table&) = delete;
+        transposition_table& operator=(const transposition_table&) = delete;
+
+        // not safe while a search is using the table
+        void resize(size_t size_mb, thread_pool* pool = nullptr);
+        void clear(thread_pool* pool = nullptr);
+
+        // entries from earlier searches are replaced first
+        void new_search();
+
+        // pulls a key's bucket into cache ahead of probe or store
+        void prefetch(uint64_t key) const {
+            const void* bucket = &m_buckets[key & m_mask];
+#ifdef _MSC_VER
+            _mm_prefetch((const char*)bucket, _MM_HINT_T0);
+#else
+            __builtin_prefetch(bucket);
+#endif
+        }
+
+        bool probe(uint64_t key, tt_entry_t& entry) const;
+
+        // keeps the stored move if the new one is empty and the key is the same
+        void store(uint64_t key, packed_move_t move, int32_t score, uint32_t depth, tt_bound bound);
+
+        size_t get_bucket_count() const { return m_mask + 1; }
+        size_t get_size_mb() const;
+
+        // entries from the current search per thousand, estimated from the first buckets
+        uint32_t get_hashfull() const;
+
+    private:
+        struct entry_t {
+            std::atomic<uint64_t> check, data;
+        };
+
+        struct alignas(64) bucket_t {
+            std::array<entry_t, entries_per_bucket> entries;
+        };
+
+        static_assert(sizeof(bucket_t) == 64);
+
+        std::unique_ptr<bucket_t[]> m_buckets;
+        size_t m_mask = 0;
+        uint8_t m_age = 0;
+    };
+} // namespace libchess
\ No newline at end of file
@@ -0,0 +1,101 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "uci.h"
+
+namespace libchess::uci {
+    // bits 12 and up of the packed move for every promotion character. the terminator stands
+    // for no promotion, and anything else sets the invalid bit
+    static constexpr uint32_t s_invalid_promotion = 1 << 16;
+    static constexpr std::array<uint32_t, 256> s_promotion_bits = []() {
+        std::array<uint32_t, 256> bits{};
+        for (auto& entry : bits) {
+            entry = s_invalid_promotion;
+        }
+
+        bits['\0'] = 0;
+        const char* characters[] = { "qQ", "rR", "nN", "bB" };
+
+        for (uint32_t i = 0; i < 4; i++) {
+            uint32_t value = (i << 12) | ((uint32_t)packed_move_t::flag_promotion << 14);
+            bits[(uint8_t)characters[i][0]] = value;
+            bits[(uint8_t)characters[i][1]] = value;
+        }
+
+        return bits;
+    }();
+
+    static constexpr char s_promotion_characters[] = { 'q', 'r', 'n', 'b' };
+
+    bool parse(std::string_view uci, packed_move_t& move) {
+        size_t length = uci.length();
+        if (length < 4 || length > max_length) {
+            return false;
+        }
+
+        // characters below 'a' or '1' wrap around and fail the range check too
+        uint32_t from_file = (uint8_t)uci[0] - (uint32_t)'a';
+        uint32_t from_rank = (uint8_t)uci[1] - (uint32_t)'1';
+        uint32_t to_file = (uint8_t)uci[2] - (uint32_t)'a';
+        uint32_t to_rank = (uint8_t)uci[3] - (uint32_t)'1';
+
+        // the last character masked off unless there are five
+        uint8_t promotion = (uint8_t)uci[length - 1] & (uint8_t)-(int32_t)(length == 5);
+        uint32_t promotion_bits = s_promotion_bits[promotion];
+
+        bool valid = ((from_file | from_rank | to_file | to_rank) < 8) &
+                     ((promotion_bits & s_invalid_promotion) == 0);
+
+        uint32_t value = (from_rank << 3 | from_file) | (to_rank << 3 | to_file) << 6;
+        value |= promotion_bits;
+
+        move.value = valid ? (uint16_t)value : move.value;
+        return valid;
+    }
+
+    size_t serialize(packed_move_t move, char* buffer, size_t buffer_size) {
+        if (buffer_size < max_length + 1) {
+            if (buffer_size > 0) {
+                buffer[0] = '\0';
+            }
+
+            return 0;
+        }
+
+        size_t position = move.get_position();
+        size_t destination = move.get_destination();
+        size_t promoting = move.get_flag() == packed_move_t::flag_promotion;
+
+        buffer[0] = (char)('a' + (position & 7));
+        buffer[1] = (char)('1' + (position >> 3));
+        buffer[2] = (char)('a' + (destination & 7));
+        buffer[3] = (char)('1' + (destination >> 3));
+
+        // always written, and overwritten by the terminator if there's no promotion
+        buffer[4] = s_promotion_characters[(move.value >> 12) & 3];
+        buffer[4 + promoting] = '\0';
+
+        return 4 + promoting;
+    }
+
+    std::string serialize(packed_move_t move) {
+        buffer_t buffer;
+        size_t length = serialize(move, buffer.data(), buffer.size());
+
+        return std::string(buffer.data(), length);
+    }
+} // namespace libchess::uci
\ No newline at end of file
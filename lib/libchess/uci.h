@@ -0,0 +1,34 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "move_list.h"
+
+// long algebraic notation as used by the uci protocol, e.g. "e2e4" or "e7e8q"
+namespace libchess::uci {
+    static constexpr size_t max_length = 5;
+    using buffer_t = std::array<char, max_length + 1>;
+
+    // squares and promotion only - the position isn't known, so en passant and castling aren't
+    // flagged. compare against generated moves with packed_move_t::matches. does not branch on
+    // the contents of the string
+    bool parse(std::string_view uci, packed_move_t& move);
+
+    // writes the null-terminated move into a buffer of at least buffer_t's size. returns its
+    // length, or 0 if the buffer is too small
+    size_t serialize(packed_move_t move, char* buffer, size_t buffer_size);
+    std::string serialize(packed_move_t move);
+} // namespace libchess::uci
\ No newline at end of file
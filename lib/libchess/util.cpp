@@ -44,17 +44,20 @@ namespace libchess::util {
         }
     }
 
-    bool parse_coordinate(const std::string& coordinate, coord& result) {
-        static const std::regex filter("[a-hA-H][1-8]");
-        if (!std::regex_match(coordinate, filter)) {
+    bool parse_coordinate(std::string_view coordinate, coord& result) {
+        if (coordinate.length() != 2) {
             return false;
         }
 
         char x_char = (char)std::tolower((int)coordinate[0]);
-        result.x = (int32_t)x_char - (int32_t)'a';
+        char y_char = coordinate[1];
 
-        std::string y_string = coordinate.substr(1);
-        result.y = (int32_t)std::atoi(y_string.c_str()) - 1;
+        if (x_char < 'a' || x_char > 'h' || y_char < '1' || y_char > '8') {
+            return false;
+        }
+
+        result.x = (int32_t)x_char - (int32_t)'a';
+        result.y = (int32_t)y_char - (int32_t)'1';
 
         return true;
     }
@@ -33,7 +33,7 @@ namespace libchess::util {
                       std::vector<std::string>& result,
                       uint32_t options = string_split_options_none);
 
-    bool parse_coordinate(const std::string& coordinate, coord& result);
+    bool parse_coordinate(std::string_view coordinate, coord& result);
     std::string serialize_coordinate(const coord& position);
 
     bool parse_piece(char character, piece_info_t& piece, bool parse_color = true);
@@ -0,0 +1,77 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "libchesspch.h"
+#include "zobrist.h"
+
+namespace libchess::zobrist {
+    // splitmix64
+    static uint64_t next_random(uint64_t& state) {
+        uint64_t result = (state += 0x9E3779B97F4A7C15ull);
+        result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ull;
+        result = (result ^ (result >> 27)) * 0x94D049BB133111EBull;
+        return result ^ (result >> 31);
+    }
+
+    static keys_t generate_keys() {
+        uint64_t state = 0x6C69626368657373ull; // "libchess"
+        keys_t result;
+
+        for (auto& color_keys : result.pieces) {
+            for (auto& type_keys : color_keys) {
+                for (auto& key : type_keys) {
+                    key = next_random(state);
+                }
+            }
+        }
+
+        // no piece means no key
+        for (auto& color_keys : result.pieces) {
+            color_keys[(size_t)piece_type::none].fill(0);
+        }
+
+        // no castling availability means no key, so that an empty board has a key of 0
+        result.castling[0] = 0;
+        for (size_t i = 1; i < result.castling.size(); i++) {
+            result.castling[i] = next_random(state);
+        }
+
+        for (auto& key : result.en_passant) {
+            key = next_random(state);
+        }
+
+        result.turn = next_random(state);
+        return result;
+    }
+
+    const keys_t keys = generate_keys();
+
+    uint64_t compute(const board::data_t& data) {
+        uint64_t key = 0;
+
+        bitboard_t occupancy = data.occupancy;
+        while (occupancy != 0) {
+            size_t square = bitboard::pop_lsb(occupancy);
+            key ^= piece(data.pieces[square ^ 56], square);
+        }
+
+        key ^= castling(data.player_castling_availability);
+        key ^= en_passant(data.en_passant_target);
+        key ^= turn(data.current_turn);
+
+        return key;
+    }
+} // namespace libchess::zobrist
\ No newline at end of file
@@ -0,0 +1,61 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include "board.h"
+
+namespace libchess::zobrist {
+    struct keys_t {
+        // indexed by color, piece type, and then square (see bitboard.h)
+        std::array<std::array<std::array<uint64_t, board::size>, piece_type_count>,
+                   player_color_count>
+            pieces;
+
+        // indexed by white's castling flags, plus black's shifted up by 2
+        std::array<uint64_t, 16> castling;
+
+        // indexed by the file of the en passant target
+        std::array<uint64_t, board::width> en_passant;
+
+        // toggled when it is black's turn
+        uint64_t turn;
+    };
+
+    // generated from a fixed seed at startup, so keys are stable between runs
+    extern const keys_t keys;
+
+    inline uint64_t piece(const piece_info_t& piece, size_t square) {
+        return keys.pieces[(size_t)piece.color][(size_t)piece.type][square];
+    }
+
+    inline uint64_t castling(const castling_availability_t& availability) {
+        size_t index = (size_t)(availability[player_color::white] & 3) |
+                       ((size_t)(availability[player_color::black] & 3) << 2);
+
+        return keys.castling[index];
+    }
+
+    inline uint64_t en_passant(const std::optional<coord>& target) {
+        return target.has_value() ? keys.en_passant[(size_t)target->x & 7] : 0;
+    }
+
+    inline uint64_t turn(player_color color) {
+        return color == player_color::black ? keys.turn : 0;
+    }
+
+    // computes the key of a position from scratch
+    uint64_t compute(const board::data_t& data);
+} // namespace libchess::zobrist
\ No newline at end of file
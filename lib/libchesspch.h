@@ -17,19 +17,34 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <stddef.h>
 
 #include <string>
+#include <string_view>
+#include <limits>
 #include <vector>
 #include <memory>
 #include <unordered_map>
-#include <regex>
 #include <array>
 #include <optional>
 #include <algorithm>
 #include <sstream>
+#include <istream>
+#include <fstream>
+#include <iterator>
 #include <list>
 #include <stdexcept>
 #include <utility>
 #include <tuple>
-#include <mutex>
\ No newline at end of file
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <chrono>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
\ No newline at end of file
@@ -114,6 +114,7 @@ namespace libchess::console {
 
         m_engine.set_board(_board);
         m_promotable_pawn.reset();
+        m_history.clear();
 
         return true;
     }
@@ -150,7 +151,14 @@ namespace libchess::console {
         factory.add_alias("move");
         factory.set_as_fallback(); // add shorthand
         factory.set_callback(BIND_CLIENT_COMMAND(client::command_move));
-        factory.set_description("Moves a piece. Cannot move if a pawn is ready to promote.");
+        factory.set_description(
+            "Moves a piece, by SAN or coordinates. Cannot move if a pawn is ready to promote.");
+
+        // go
+        factory.new_command();
+        factory.add_alias("go");
+        factory.set_callback(BIND_CLIENT_COMMAND(client::command_go));
+        factory.set_description("Plays the engine's move, after N seconds of thought (default 1).");
 
         // promote
         factory.new_command();
@@ -366,8 +374,8 @@ namespace libchess::console {
 
     void client::command_move(command_context& context) {
         const auto& args = context.get_args();
-        if (args.size() != 2) {
-            context.submit_line("Only 2 arguments are accepted!");
+        if (args.empty() || args.size() > 2) {
+            context.submit_line("Expected a SAN move or 2 coordinates!");
             return;
         }
 
@@ -382,31 +390,42 @@ namespace libchess::console {
         move_t move;
         piece_info_t piece;
 
-        if (!util::parse_coordinate(args[0], move.position) ||
-            board::is_out_of_bounds(move.position) || !m_engine.get_piece(move.position, &piece)) {
-            context.submit_line("Invalid initial position!");
-            return;
-        }
+        if (args.size() == 1) {
+            // san already checks legality, and may carry the promotion with it
+            if (!san::parse(m_engine, args[0], move)) {
+                context.submit_line("Invalid or illegal move!");
+                return;
+            }
 
-        if (!util::parse_coordinate(args[1], move.destination) ||
-            board::is_out_of_bounds(move.destination)) {
-            context.submit_line("Invalid destination position!");
-            return;
-        }
+            m_engine.get_piece(move.position, &piece);
+        } else {
+            if (!util::parse_coordinate(args[0], move.position) ||
+                board::is_out_of_bounds(move.position) ||
+                !m_engine.get_piece(move.position, &piece)) {
+                context.submit_line("Invalid initial position!");
+                return;
+            }
 
-        if (piece.color != m_engine.get_current_turn() || !m_engine.is_move_legal(move)) {
-            context.submit_line("Illegal move!");
-            return;
+            if (!util::parse_coordinate(args[1], move.destination) ||
+                board::is_out_of_bounds(move.destination)) {
+                context.submit_line("Invalid destination position!");
+                return;
+            }
+
+            if (piece.color != m_engine.get_current_turn() || !m_engine.is_move_legal(move)) {
+                context.submit_line("Illegal move!");
+                return;
+            }
         }
 
-        if (!m_engine.commit_move(move)) {
+        if (!commit_move(move)) {
             context.submit_line("Failed to commit move!");
             return;
         } else {
             context.submit_line(m_engine.serialize_board());
         }
 
-        if (piece.type == piece_type::pawn) {
+        if (piece.type == piece_type::pawn && move.promotion == piece_type::none) {
             int32_t dest_y = (piece.color == player_color::white) ? ((int32_t)board::width - 1) : 0;
             if (move.destination.y == dest_y) {
                 m_promotable_pawn = move.destination;
@@ -419,16 +438,90 @@ namespace libchess::console {
         player_color other_player =
             (piece.color == player_color::white) ? player_color::black : player_color::white;
 
-        if (m_engine.compute_checkmate(other_player)) {
+        announce_check(context, other_player);
+    }
+
+    void client::command_go(command_context& context) {
+        const auto& args = context.get_args();
+        if (args.size() > 1) {
+            context.submit_line("Only 1 argument is accepted!");
+            return;
+        }
+
+        if (m_promotable_pawn.has_value()) {
+            context.submit_line("A pawn must be promoted first!");
+            return;
+        }
+
+        double seconds = 1.0;
+        if (!args.empty()) {
+            try {
+                seconds = std::stod(args[0]);
+            } catch (const std::exception&) {
+                seconds = 0.0;
+            }
+
+            if (seconds <= 0.0) {
+                context.submit_line("Invalid time!");
+                return;
+            }
+        }
+
+        search_limits_t limits;
+        limits.time_ms = (uint64_t)(seconds * 1000.0);
+
+        search_info_t info;
+        m_searcher.set_game_history(m_history);
+
+        if (!m_searcher.search(m_engine, limits, info)) {
+            context.submit_line("There are no legal moves!");
+            return;
+        }
+
+        auto move = info.pv[0].unpack();
+        std::string san = san::serialize(m_engine, move);
+        player_color other_player = m_engine.get_current_turn() == player_color::white
+                                        ? player_color::black
+                                        : player_color::white;
+
+        if (!commit_move(move)) {
+            context.submit_line("Failed to commit move!");
+            return;
+        }
+
+        context.submit_line(san + " (depth " + std::to_string(info.depth) + ", " +
+                            std::to_string(info.get_nps() / 1000) + " knps)");
+
+        context.submit_line(m_engine.serialize_board());
+        announce_check(context, other_player);
+    }
+
+    void client::announce_check(command_context& context, player_color player) {
+        if (m_engine.compute_checkmate(player)) {
             context.submit_line("Checkmate!");
         } else {
             std::vector<coord> checking_pieces;
-            if (m_engine.compute_check(other_player, checking_pieces)) {
+            if (m_engine.compute_check(player, checking_pieces)) {
                 context.submit_line("Check!");
             }
         }
     }
 
+    bool client::commit_move(const move_t& move) {
+        uint64_t key = m_engine.get_key();
+        if (!m_engine.commit_move(move)) {
+            return false;
+        }
+
+        if (m_engine.get_board()->get_data().halfmove_clock == 0) {
+            m_history.clear();
+        } else {
+            m_history.push_back(key);
+        }
+
+        return true;
+    }
+
     void client::command_promote(command_context& context) {
         if (!m_promotable_pawn.has_value()) {
             context.submit_line("There is no pawn on the board that's ready to promote!");
@@ -52,6 +52,12 @@ namespace libchess::console {
 
         void command_move(command_context& context);
         void command_promote(command_context& context);
+        void command_go(command_context& context);
+
+        void announce_check(command_context& context, player_color player);
+
+        // commits the move, and keeps the history the searcher checks for repetitions
+        bool commit_move(const move_t& move);
 
         std::shared_ptr<game_console> m_console;
         size_t m_console_update_callback, m_console_scroll_callback,
@@ -59,6 +65,12 @@ namespace libchess::console {
 
         engine m_engine;
         std::optional<coord> m_promotable_pawn;
+
+        // kept between moves, along with its transposition table
+        searcher m_searcher;
+
+        // keys of the positions since the last capture or pawn move, not counting this one
+        std::vector<uint64_t> m_history;
         std::mutex m_mutex;
 
         size_t m_key_callback;
@@ -0,0 +1,104 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+using namespace libchess;
+
+static bitboard_t compute_rays(size_t square, bitboard_t occupancy,
+                               const std::vector<size_t>& directions) {
+    bitboard_t result = 0;
+    for (size_t direction : directions) {
+        result |= attacks::ray(direction, square, occupancy);
+    }
+
+    return result;
+}
+
+class magic_attacks : public test_fact {
+protected:
+    virtual void invoke() override {
+        static const std::vector<size_t> rook_directions = {
+            attacks::ray_direction_north, attacks::ray_direction_east,
+            attacks::ray_direction_south, attacks::ray_direction_west
+        };
+
+        static const std::vector<size_t> bishop_directions = {
+            attacks::ray_direction_north_east, attacks::ray_direction_north_west,
+            attacks::ray_direction_south_west, attacks::ray_direction_south_east
+        };
+
+        // deterministic, sparse-ish occupancies
+        uint64_t state = 0x1234567890ABCDEFull;
+        for (size_t i = 0; i < 4096; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            bitboard_t occupancy = state & (state >> 3);
+            for (size_t square = 0; square < board::size; square++) {
+                assert::is_equal(attacks::rook(square, occupancy),
+                                 compute_rays(square, occupancy, rook_directions));
+
+                assert::is_equal(attacks::bishop(square, occupancy),
+                                 compute_rays(square, occupancy, bishop_directions));
+            }
+        }
+    }
+
+    virtual std::string get_check_name() override { return "magic_attacks"; }
+};
+
+class leaper_attacks : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "a1", "knight", "2" });
+        inline_data({ "d4", "knight", "8" });
+        inline_data({ "h8", "king", "3" });
+        inline_data({ "e4", "king", "8" });
+        inline_data({ "a2", "white_pawn", "1" });
+        inline_data({ "e4", "black_pawn", "2" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        coord position;
+        assert::is_true(util::parse_coordinate(data[0], position));
+
+        size_t square = bitboard::get_square(position);
+        bitboard_t mask;
+
+        const auto& type = data[1];
+        if (type == "knight") {
+            mask = attacks::knight(square);
+        } else if (type == "king") {
+            mask = attacks::king(square);
+        } else if (type == "white_pawn") {
+            mask = attacks::pawn(player_color::white, square);
+        } else {
+            mask = attacks::pawn(player_color::black, square);
+        }
+
+        assert::is_equal(bitboard::popcount(mask), (uint32_t)std::stoul(data[2]));
+    }
+
+    virtual std::string get_check_name() override { return "leaper_attacks"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<magic_attacks>();
+    invoke_check<leaper_attacks>();
+}
\ No newline at end of file
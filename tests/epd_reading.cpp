@@ -0,0 +1,164 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+#include <filesystem>
+#include <fstream>
+
+static const std::string s_epd_text =
+    "# comment lines and blank lines are skipped\n"
+    "\n"
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4; id \"start; position\";\r\n"
+    "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - hmvc 12; fmvn 30; c0 \"castling\";\n"
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ;D1 14 ;D2 191\n"
+    "8/8/8/8/8/8/8 w - - am Kd1;\n"
+    "4k3/8/8/8/8/8/8/4K3 b - -";
+
+class epd_records : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto reader = libchess::epd_reader::create(s_epd_text);
+        assert::is_not_nullptr(reader);
+
+        libchess::epd_record_t record;
+        libchess::board::fen_buffer_t fen;
+
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::none);
+        assert::is_equal(record.line_number, 3);
+        assert::is_equal(record.operation_count, 2);
+        assert::is_equal(record.find_operation("bm").value_or(""), std::string_view("e4"));
+        assert::is_equal(record.find_operation("id").value_or(""),
+                         std::string_view("\"start; position\""));
+
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::none);
+        assert::is_equal(record.data.halfmove_clock, 12);
+        assert::is_equal(record.data.fullmove_count, 30);
+        assert::is_equal(record.find_operation("c0").value_or(""),
+                         std::string_view("\"castling\""));
+        assert::is_false(record.find_operation("bm").has_value());
+
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::none);
+        assert::is_equal(record.operation_count, 2);
+        assert::is_equal(record.operations[1].opcode, std::string_view("D2"));
+        assert::is_equal(record.operations[1].operands, std::string_view("191"));
+
+        libchess::board::serialize(record.data, fen.data(), fen.size());
+        assert::is_equal(std::string(fen.data()), "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+
+        // bad lines are still handed back, marked as such
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::piece_placement);
+
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::none);
+        assert::is_equal(record.operation_count, 0);
+        assert::is_equal(record.data.fullmove_count, 1);
+
+        assert::is_false(reader->next(record));
+
+        reader->rewind();
+        assert::is_true(reader->next(record));
+        assert::is_equal(record.line_number, 3);
+
+        // clocks that don't parse or don't fit are errors, not silently dropped
+        reader = libchess::epd_reader::create(
+            "4k3/8/8/8/8/8/8/4K3 w - - hmvc 99999999999999999999;\n"
+            "4k3/8/8/8/8/8/8/4K3 w - - fmvn 1x;\n");
+
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::halfmove_clock);
+        assert::is_true(reader->next(record));
+        assert::is_true(record.error == libchess::fen_error::fullmove_count);
+    }
+
+    virtual std::string get_check_name() override { return "epd_records"; }
+};
+
+class epd_chunks : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "1" });
+        inline_data({ "2" });
+        inline_data({ "3" });
+        inline_data({ "16" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto reader = libchess::epd_reader::create(s_epd_text);
+        size_t count = (size_t)std::stoull(data[0]);
+
+        std::vector<std::shared_ptr<libchess::epd_reader>> chunks;
+        reader->split(count, chunks);
+        assert::is_true(!chunks.empty() && chunks.size() <= count);
+
+        // the chunks have to tile the input exactly, and each one has to end on a line
+        std::string joined;
+        size_t records = 0;
+
+        libchess::epd_record_t record;
+        for (const auto& chunk : chunks) {
+            auto text = chunk->get_text();
+            assert::is_true(chunk == chunks.back() || text.back() == '\n');
+
+            joined += text;
+            while (chunk->next(record)) {
+                records++;
+            }
+        }
+
+        assert::is_equal(joined, s_epd_text);
+        assert::is_equal(records, 5);
+    }
+
+    virtual std::string get_check_name() override { return "epd_chunks"; }
+};
+
+class epd_sources : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto path = std::filesystem::temp_directory_path() / "libchess_test_epd_sources.epd";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << s_epd_text;
+        }
+
+        std::stringstream stream(s_epd_text);
+        auto mapped = libchess::epd_reader::open(path.string());
+        auto streamed = libchess::epd_reader::create(stream);
+
+        assert::is_not_nullptr(mapped);
+        assert::is_not_nullptr(streamed);
+        assert::is_equal(mapped->get_text(), std::string_view(s_epd_text));
+        assert::is_equal(streamed->get_text(), std::string_view(s_epd_text));
+
+        mapped.reset();
+        std::filesystem::remove(path);
+
+        assert::is_nullptr(libchess::epd_reader::open(path.string()));
+    }
+
+    virtual std::string get_check_name() override { return "epd_sources"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<epd_records>();
+    invoke_check<epd_chunks>();
+    invoke_check<epd_sources>();
+}
\ No newline at end of file
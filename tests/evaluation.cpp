@@ -0,0 +1,167 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static void assert_in_sync(const libchess::board::data_t& data) {
+    auto computed = libchess::eval::compute(data);
+    assert::is_equal(data.eval.midgame, computed.midgame);
+    assert::is_equal(data.eval.endgame, computed.endgame);
+    assert::is_equal(data.eval.phase, computed.phase);
+}
+
+// makes and unmakes every line to the given depth, checking the running terms at each node
+static void walk(libchess::engine& engine, uint32_t depth) {
+    const auto& data = engine.get_board()->get_data();
+    assert_in_sync(data);
+
+    if (depth == 0) {
+        return;
+    }
+
+    libchess::move_list moves;
+    engine.generate_legal_moves(moves);
+
+    for (size_t i = 0; i < moves.size(); i++) {
+        auto original = data.eval;
+
+        assert::is_true(engine.make_move(moves[i]));
+        walk(engine, depth - 1);
+        assert::is_true(engine.unmake_move());
+
+        assert::is_equal(data.eval.midgame, original.midgame);
+        assert::is_equal(data.eval.endgame, original.endgame);
+        assert::is_equal(data.eval.phase, original.phase);
+    }
+}
+
+class incremental_evaluation : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+        inline_data({ "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        walk(engine, 3);
+    }
+
+    virtual std::string get_check_name() override { return "incremental_evaluation"; }
+};
+
+class committed_evaluation : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create("r3k2r/1P6/8/3Pp3/8/8/8/R3K2R w KQkq e6 0 1");
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        static const std::vector<std::string> moves = { "d5 e6", "e8 g8", "e1 c1",
+                                                        "g8 g7", "b7 a8" };
+
+        for (const auto& desc : moves) {
+            std::vector<std::string> squares;
+            libchess::util::split_string(desc, ' ', squares);
+            assert::is_equal(squares.size(), 2);
+
+            libchess::move_t move;
+            assert::is_true(libchess::util::parse_coordinate(squares[0], move.position));
+            assert::is_true(libchess::util::parse_coordinate(squares[1], move.destination));
+            if (desc == moves.back()) {
+                move.promotion = libchess::piece_type::queen;
+            }
+
+            assert::is_true(engine.commit_move(move));
+            assert_in_sync(board->get_data());
+        }
+
+        // three rooks and the promoted queen
+        assert::is_equal(board->get_data().eval.phase, 3 * 2 + 4);
+    }
+
+    virtual std::string get_check_name() override { return "committed_evaluation"; }
+};
+
+class placed_evaluation : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create_default();
+        const auto& data = board->get_data();
+
+        libchess::piece_info_t queen;
+        queen.type = libchess::piece_type::queen;
+        queen.color = libchess::player_color::white;
+
+        // replacing a pawn, filling an empty square, and clearing a piece
+        assert::is_true(board->set_piece(libchess::coord(4, 1), queen));
+        assert_in_sync(data);
+
+        assert::is_true(board->set_piece(libchess::coord(4, 4), queen));
+        assert_in_sync(data);
+
+        libchess::piece_info_t empty;
+        empty.type = libchess::piece_type::none;
+        empty.color = libchess::player_color::white;
+
+        assert::is_true(board->set_piece(libchess::coord(3, 7), empty));
+        assert_in_sync(data);
+        assert::is_true(libchess::eval::evaluate(data) > 0);
+    }
+
+    virtual std::string get_check_name() override { return "placed_evaluation"; }
+};
+
+class symmetric_evaluation : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        // each position next to its mirror, with the colors swapped
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1" });
+
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                      "r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq - 0 1" });
+
+        inline_data({ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                      "8/4p1p1/8/1r3P1K/kp5R/3P4/2P5/8 b - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        auto mirrored = libchess::board::create(data[1]);
+
+        assert::is_not_nullptr(board);
+        assert::is_not_nullptr(mirrored);
+
+        assert::is_equal(libchess::eval::evaluate(board->get_data()),
+                         libchess::eval::evaluate(mirrored->get_data()));
+    }
+
+    virtual std::string get_check_name() override { return "symmetric_evaluation"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<incremental_evaluation>();
+    invoke_check<committed_evaluation>();
+    invoke_check<placed_evaluation>();
+    invoke_check<symmetric_evaluation>();
+}
\ No newline at end of file
@@ -55,6 +55,9 @@ protected:
         inline_data({ "8/8/8/8/8/8/8/8 w - i1 0 1" });
         inline_data({ "8/8/8/8/8/8/8/8 w - a9 0 1" });
         inline_data({ "8/8/8/8/8/8/8/8 w - abc 0 1" });
+        inline_data({ "8/8/8/8/8/8/8/8 w - - 0 1x" });
+        inline_data({ "8/8/8/8/8/8/8/8 w -- - 0 1" });
+        inline_data({ "8/8/8/8/8/8/8/8 w - - 0 -1" });
     }
 
     virtual void invoke(const std::vector<std::string>& data) override {
@@ -65,7 +68,197 @@ protected:
     virtual std::string get_check_name() override { return "invalid_fen_strings"; }
 };
 
+class fen_errors : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "field_count", "" });
+        inline_data({ "field_count", "8/8/8/8/8/8/8/8 w - - 0" });
+        inline_data({ "field_count", "8/8/8/8/8/8/8/8 w - - 0 1 0" });
+        inline_data({ "piece_placement", "8/8/8/8/8/8/8 w - - 0 1" });
+        inline_data({ "piece_placement", "8/8/8/8/8/8/8/9 w - - 0 1" });
+        inline_data({ "piece_placement", "8/8/8/8/8/8/8/7kk w - - 0 1" });
+        inline_data({ "piece_placement", "8/8/8/8/8/8/8/8/8 w - - 0 1" });
+        inline_data({ "current_turn", "8/8/8/8/8/8/8/8 f - - 0 1" });
+        inline_data({ "castling_availability", "8/8/8/8/8/8/8/8 w ABab - 0 1" });
+        inline_data({ "en_passant_target", "8/8/8/8/8/8/8/8 w - a9 0 1" });
+        inline_data({ "halfmove_clock", "8/8/8/8/8/8/8/8 w - - x 1" });
+        inline_data({ "fullmove_count", "8/8/8/8/8/8/8/8 w - - 0 99999999999999999999999" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        static const std::unordered_map<std::string, libchess::fen_error> errors = {
+            { "field_count", libchess::fen_error::field_count },
+            { "piece_placement", libchess::fen_error::piece_placement },
+            { "current_turn", libchess::fen_error::current_turn },
+            { "castling_availability", libchess::fen_error::castling_availability },
+            { "en_passant_target", libchess::fen_error::en_passant_target },
+            { "halfmove_clock", libchess::fen_error::halfmove_clock },
+            { "fullmove_count", libchess::fen_error::fullmove_count }
+        };
+
+        libchess::fen_error error;
+        auto board = libchess::board::create(data[1], &error);
+
+        assert::is_nullptr(board);
+        assert::is_true(error == errors.at(data[0]));
+    }
+
+    virtual std::string get_check_name() override { return "fen_errors"; }
+};
+
+class in_place_parsing : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" });
+        inline_data({ "rnbqkbnr/pp1p1ppp/8/2pPp3/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        // parse over a board holding some other position, so nothing can be left over
+        auto other = libchess::board::create("8/8/8/8/8/8/8/8 b - - 5 9");
+        auto& other_data = other->get_data();
+
+        libchess::fen_error error = libchess::board::parse_fen(data[0], other_data);
+        assert::is_true(error == libchess::fen_error::none);
+        assert::is_equal(other->serialize(), data[0]);
+
+        const auto& expected = board->get_data();
+        assert::is_equal(other_data.key, expected.key);
+        assert::is_equal(other_data.occupancy, expected.occupancy);
+        assert::is_true(other_data.piece_masks == expected.piece_masks);
+    }
+
+    virtual std::string get_check_name() override { return "in_place_parsing"; }
+};
+
+class buffer_serialization : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "8/8/8/8/8/8/8/8 b - - 0 1" });
+        inline_data({ "rnbqkbnr/pp1p1ppp/8/2pPp3/8/8/PPP1PPPP/RNBQKBNR w Kq e6 12 40" });
+        inline_data({ "rnbqkbnr/pppppppp/rnbqkbnr/pppppppp/PPPPPPPP/RNBQKBNR/PPPPPPPP/RNBQKBNR w "
+                      "KQkq e3 18446744073709551615 18446744073709551615" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        const auto& fen = data[0];
+        assert::is_true(fen.length() <= libchess::board::max_fen_length);
+
+        auto board = libchess::board::create(fen);
+        assert::is_not_nullptr(board);
+
+        libchess::board::fen_buffer_t buffer;
+        const auto& board_data = board->get_data();
+
+        size_t length = libchess::board::serialize(board_data, buffer.data(), buffer.size());
+        assert::is_equal(length, fen.length());
+        assert::is_equal(std::string(buffer.data()), fen);
+
+        // exactly enough room for the terminator, and one byte short
+        std::vector<char> exact(fen.length() + 1, 'x');
+        assert::is_equal(libchess::board::serialize(board_data, exact.data(), exact.size()),
+                         fen.length());
+        assert::is_equal(std::string(exact.data()), fen);
+
+        std::vector<char> short_buffer(fen.length(), 'x');
+        assert::is_equal(
+            libchess::board::serialize(board_data, short_buffer.data(), short_buffer.size()), 0);
+        assert::is_equal(short_buffer[0], '\0');
+    }
+
+    virtual std::string get_check_name() override { return "buffer_serialization"; }
+};
+
+class bulk_serialization : public test_fact {
+protected:
+    virtual void invoke() override {
+        std::vector<std::string> fens = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+        };
+
+        std::vector<libchess::board::data_t> positions(fens.size());
+        std::string expected = "header\n";
+
+        for (size_t i = 0; i < fens.size(); i++) {
+            auto error = libchess::board::parse_fen(fens[i], positions[i]);
+            assert::is_true(error == libchess::fen_error::none);
+
+            expected += fens[i] + "\n";
+        }
+
+        std::string output = "header\n";
+        assert::is_true(libchess::board::serialize(positions.data(), positions.size(), output));
+        assert::is_equal(output, expected);
+
+        // an invalid position leaves the output untouched
+        positions[1].current_turn = (libchess::player_color)2;
+        assert::is_false(libchess::board::serialize(positions.data(), positions.size(), output));
+        assert::is_equal(output, expected);
+    }
+
+    virtual std::string get_check_name() override { return "bulk_serialization"; }
+};
+
+class synced_bitboards : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" });
+        inline_data({ "8/8/8/8/8/8/8/8 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        // move a piece around to make sure set_piece keeps the masks up to date
+        libchess::piece_info_t piece;
+        piece.type = libchess::piece_type::queen;
+        piece.color = libchess::player_color::white;
+
+        assert::is_true(board->set_piece(libchess::coord(4, 3), piece));
+        assert::is_true(board->set_piece(libchess::coord(0, 0), { libchess::piece_type::none }));
+
+        const auto& board_data = board->get_data();
+        libchess::bitboard_t occupancy = 0;
+
+        for (int32_t y = 0; y < libchess::board::width; y++) {
+            for (int32_t x = 0; x < libchess::board::width; x++) {
+                auto pos = libchess::coord(x, y);
+                auto mask = libchess::bitboard::square_mask(libchess::bitboard::get_square(pos));
+
+                libchess::piece_info_t current;
+                if (!board->get_piece(pos, &current)) {
+                    continue;
+                }
+
+                occupancy |= mask;
+                const auto& masks = board_data.piece_masks[(size_t)current.color];
+                assert::is_not_equal(masks[(size_t)current.type] & mask, 0);
+            }
+        }
+
+        assert::is_equal(board_data.occupancy, occupancy);
+        assert::is_equal(board_data.color_masks[0] | board_data.color_masks[1], occupancy);
+        assert::is_equal(board_data.color_masks[0] & board_data.color_masks[1], 0);
+    }
+
+    virtual std::string get_check_name() override { return "synced_bitboards"; }
+};
+
 DEFINE_ENTRYPOINT() {
     invoke_check<valid_fen_strings>();
     invoke_check<invalid_fen_strings>();
+    invoke_check<fen_errors>();
+    invoke_check<in_place_parsing>();
+    invoke_check<buffer_serialization>();
+    invoke_check<bulk_serialization>();
+    invoke_check<synced_bitboards>();
 }
\ No newline at end of file
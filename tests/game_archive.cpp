@@ -0,0 +1,254 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+#include <filesystem>
+#include <fstream>
+
+static const std::string s_pgn_text = R"([Result "1-0"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 6. Re1 b5 7. Bb3 d6 8. c3 O-O 1-0
+
+[Result "1/2-1/2"]
+[FEN "4k3/P7/8/8/8/8/8/R3K2R w KQ - 0 1"]
+
+1. a8=N Kd7 2. O-O-O+ Ke6 3. Nc7+ Kf5 1/2-1/2
+
+[Result "0-1"]
+[FEN "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3"]
+
+1... dxe3 2. Bc4 exf2+ 3. Ke2 fxg1=N+ 0-1
+)";
+
+struct source_game_t {
+    libchess::board::data_t initial_position;
+    std::vector<libchess::packed_move_t> moves;
+    libchess::game_result result;
+};
+
+static std::vector<source_game_t> load_games() {
+    auto reader = libchess::pgn_reader::create(s_pgn_text);
+    reader->find_games();
+
+    std::vector<source_game_t> games;
+    libchess::engine engine;
+    libchess::pgn_game_t game;
+
+    for (const auto& text : reader->get_games()) {
+        assert::is_true(libchess::pgn_reader::decode(text, engine, game));
+
+        auto& source = games.emplace_back();
+        source.initial_position = game.initial_position;
+        source.moves = game.moves;
+        source.result = libchess::game_archive::parse_result(game.result);
+    }
+
+    return games;
+}
+
+static void check_game(const libchess::archive_game_t& game, const source_game_t& source) {
+    assert::is_true(game.result == source.result);
+    assert::is_equal(game.initial_position.key, source.initial_position.key);
+    assert::is_equal(game.moves.size(), source.moves.size());
+
+    for (size_t i = 0; i < game.moves.size(); i++) {
+        assert::is_true(game.moves[i].matches(source.moves[i]));
+    }
+}
+
+class archive_round_trip : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto games = load_games();
+        assert::is_equal(games.size(), 3);
+        assert::is_true(games[2].moves[0].get_flag() == libchess::packed_move_t::flag_none);
+
+        auto path = std::filesystem::temp_directory_path() / "libchess_test_archive.lcga";
+        auto writer = libchess::game_archive_writer::create(path.string());
+        assert::is_not_nullptr(writer);
+
+        // many threads appending at once, each game remembering its id
+        static constexpr size_t copies = 50;
+        std::vector<size_t> ids(games.size() * copies);
+        std::atomic<size_t> failures = 0;
+
+        {
+            libchess::thread_pool pool(4);
+            for (size_t i = 0; i < ids.size(); i++) {
+                pool.submit([&, i](size_t) {
+                    const auto& game = games[i % games.size()];
+                    if (!writer->add(game.initial_position, game.moves.data(), game.moves.size(),
+                                     game.result, &ids[i])) {
+                        failures++;
+                    }
+                });
+            }
+
+            pool.wait();
+        }
+
+        assert::is_equal(failures.load(), 0);
+        assert::is_equal(writer->get_count(), ids.size());
+        assert::is_true(writer->close());
+
+        // an illegal move is refused, and nothing is added once closed
+        auto broken = games[0];
+        std::swap(broken.moves[0], broken.moves[1]);
+        assert::is_false(writer->add(broken.initial_position, broken.moves.data(),
+                                     broken.moves.size(), broken.result));
+
+        auto archive = libchess::game_archive::open(path.string());
+        assert::is_not_nullptr(archive);
+        assert::is_equal(archive->get_count(), ids.size());
+
+        libchess::archive_game_t game;
+        for (size_t i = 0; i < ids.size(); i++) {
+            assert::is_true(archive->read(ids[i], game));
+            check_game(game, games[i % games.size()]);
+        }
+
+        assert::is_false(archive->read(ids.size(), game));
+
+        // decoded moves carry the flags the generator gives them
+        assert::is_true(archive->read(ids[2], game));
+        assert::is_true(game.moves[0].get_flag() == libchess::packed_move_t::flag_en_passant);
+
+        archive.reset();
+        writer.reset();
+
+        // appending keeps the old ids valid
+        writer = libchess::game_archive_writer::append(path.string());
+        assert::is_not_nullptr(writer);
+        assert::is_equal(writer->get_count(), ids.size());
+
+        size_t id;
+        assert::is_true(writer->add(games[1].initial_position, games[1].moves.data(),
+                                    games[1].moves.size(), games[1].result, &id));
+        assert::is_equal(id, ids.size());
+        assert::is_true(writer->close());
+
+        archive = libchess::game_archive::open(path.string());
+        assert::is_equal(archive->get_count(), ids.size() + 1);
+        assert::is_true(archive->read(id, game));
+        check_game(game, games[1]);
+        assert::is_true(archive->read(ids[0], game));
+        check_game(game, games[0]);
+
+        archive.reset();
+        writer.reset();
+
+        // games appended without a close, as after a crash, leave the archive as it was. there
+        // are enough of them that they can't all still be sitting in the stream's buffer
+        writer = libchess::game_archive_writer::append(path.string());
+        assert::is_not_nullptr(writer);
+
+        for (size_t i = 0; i < 500; i++) {
+            assert::is_true(writer->add(games[0].initial_position, games[0].moves.data(),
+                                        games[0].moves.size(), games[0].result));
+        }
+
+        archive = libchess::game_archive::open(path.string());
+        assert::is_not_nullptr(archive);
+        assert::is_equal(archive->get_count(), ids.size() + 1);
+        assert::is_true(archive->read(id, game));
+        check_game(game, games[1]);
+
+        archive.reset();
+        assert::is_true(writer->close());
+
+        archive = libchess::game_archive::open(path.string());
+        assert::is_not_nullptr(archive);
+        assert::is_equal(archive->get_count(), ids.size() + 501);
+        assert::is_true(archive->read(ids.size() + 500, game));
+        check_game(game, games[0]);
+
+        archive.reset();
+        writer.reset();
+        std::filesystem::remove(path);
+    }
+
+    virtual std::string get_check_name() override { return "archive_round_trip"; }
+};
+
+class bad_archives : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto games = load_games();
+        auto path = std::filesystem::temp_directory_path() / "libchess_test_bad_archive.lcga";
+
+        {
+            auto writer = libchess::game_archive_writer::create(path.string());
+            assert::is_not_nullptr(writer);
+
+            const auto& game = games[0];
+            assert::is_true(writer->add(game.initial_position, game.moves.data(),
+                                        game.moves.size(), game.result));
+        }
+
+        std::string bytes;
+        {
+            std::ifstream file(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // a 16-byte header, 40 bytes of game header and a byte per ply, the index and footer
+        assert::is_equal(bytes.length(), 16 + 40 + games[0].moves.size() + 8 + 24);
+        assert::is_not_nullptr(libchess::game_archive::create(bytes));
+
+        std::string truncated = bytes.substr(0, bytes.length() - 1);
+        assert::is_nullptr(libchess::game_archive::create(truncated));
+
+        std::string wrong_magic = bytes;
+        wrong_magic[0] = 'X';
+        assert::is_nullptr(libchess::game_archive::create(wrong_magic));
+
+        // a move index past the end of the legal move list
+        std::string corrupt = bytes;
+        corrupt[16 + 40] = (char)250;
+
+        auto archive = libchess::game_archive::create(corrupt);
+        assert::is_not_nullptr(archive);
+
+        libchess::archive_game_t game;
+        assert::is_false(archive->read(0, game));
+
+        // a file that isn't an archive can't be appended to
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << "not an archive at all, but long enough to have a footer";
+        }
+
+        assert::is_nullptr(libchess::game_archive_writer::append(path.string()));
+
+        std::string contents;
+        {
+            std::ifstream file(path, std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>());
+        }
+
+        assert::is_equal(contents, "not an archive at all, but long enough to have a footer");
+        std::filesystem::remove(path);
+    }
+
+    virtual std::string get_check_name() override { return "bad_archives"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<archive_round_trip>();
+    invoke_check<bad_archives>();
+}
\ No newline at end of file
@@ -99,6 +99,7 @@ protected:
         inline_data({ "e1 g1", "castling" });
         inline_data({ "f1 g1", "check" });
         inline_data({ "b2 a1", "king_move" });
+        inline_data({ "e2 e7", "pinned_rook" });
     }
 
     virtual void invoke(const std::vector<std::string>& data) override {
@@ -126,6 +127,10 @@ protected:
         inline_data({ "e1 g1", "castling_intercepted" });
         inline_data({ "f1 g2", "check" });
         inline_data({ "f2 f4", "check" });
+        inline_data({ "e2 c3", "pinned_knight" });
+        inline_data({ "e2 d2", "pinned_rook" });
+        inline_data({ "d5 e6", "en_passant_pinned" });
+        inline_data({ "e1 f1", "king_x_ray" });
     }
 
     virtual void invoke(const std::vector<std::string>& data) override {
@@ -248,6 +253,88 @@ protected:
     virtual std::string get_check_name() override { return "en_passant"; }
 };
 
+class make_unmake : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "e1 g1", "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1" });
+        inline_data({ "a1 a8", "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1" });
+        inline_data({ "d5 e6", "k7/8/8/3Pp3/8/8/8/K7 w - e6 0 1" });
+        inline_data({ "b7 a8", "r3k3/1P6/8/8/8/8/8/4K3 w q - 0 1", "q" });
+        inline_data({ "e2 e4", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+
+        // unchecked, so a king can "castle" with no rook to move
+        inline_data({ "e1 g1", "4k3/8/8/8/8/8/8/4K3 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[1]);
+        assert::is_not_nullptr(board);
+
+        libchess::move_t move;
+        assert::is_true(parse_move(data[0], move));
+
+        if (data.size() > 2) {
+            libchess::piece_info_t promotion;
+            assert::is_true(libchess::util::parse_piece(data[2][0], promotion, false));
+            move.promotion = promotion.type;
+        }
+
+        auto original_data = board->get_data();
+        libchess::engine engine(board);
+
+        assert::is_true(engine.make_move(move));
+        assert::is_not_equal(board->serialize(), data[1]);
+        assert::is_equal(engine.get_undo_depth(), 1);
+
+        // the bitboards have to match the pieces after the move too
+        auto refreshed_data = board->get_data();
+        libchess::board::refresh(refreshed_data);
+        assert::is_true(board->get_data().piece_masks == refreshed_data.piece_masks);
+        assert::is_true(board->get_data().color_masks == refreshed_data.color_masks);
+        assert::is_equal(board->get_data().occupancy, refreshed_data.occupancy);
+
+        assert::is_true(engine.unmake_move());
+        assert::is_false(engine.unmake_move());
+        assert::is_equal(board->serialize(), data[1]);
+
+        const auto& restored_data = board->get_data();
+        assert::is_true(restored_data.piece_masks == original_data.piece_masks);
+        assert::is_equal(restored_data.occupancy, original_data.occupancy);
+    }
+
+    virtual std::string get_check_name() override { return "make_unmake"; }
+};
+
+class move_count : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "20", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data(
+            { "48", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "14", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+        inline_data({ "6", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" });
+        inline_data({ "44", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" });
+        inline_data({ "9", "4k3/1P6/8/8/8/8/8/4K3 w - - 0 1" });
+        inline_data({ "0", "k4r2/8/8/8/8/8/3PPq2/3QK3 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[1]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        libchess::move_list moves;
+        engine.generate_legal_moves(moves);
+
+        assert::is_equal(moves.size(), (size_t)std::stoull(data[0]));
+        for (const auto& move : moves) {
+            assert::is_true(engine.is_move_legal(move));
+        }
+    }
+
+    virtual std::string get_check_name() override { return "move_count"; }
+};
+
 DEFINE_ENTRYPOINT() {
     board_position_set positions;
 
@@ -269,6 +356,10 @@ DEFINE_ENTRYPOINT() {
                       "rnbqkbnr/pppppppp/8/8/8/5NP1/PPPPPPBP/RNBQK2R w kq - 0 1");
 
     positions.set_fen("king_move", "6k1/7p/7P/5p2/8/8/pK5r/8 w - - 4 46");
+    positions.set_fen("pinned_knight", "4k3/4r3/8/8/8/8/4N3/4K3 w - - 0 1");
+    positions.set_fen("pinned_rook", "4k3/4r3/8/8/8/8/4R3/4K3 w - - 0 1");
+    positions.set_fen("en_passant_pinned", "8/8/8/K2Pp2r/8/8/8/7k w - e6 0 1");
+    positions.set_fen("king_x_ray", "4k3/8/8/8/8/8/8/r3K3 w - - 0 1");
 
     invoke_check<legal_moves>(positions);
     invoke_check<illegal_moves>(positions);
@@ -276,4 +367,6 @@ DEFINE_ENTRYPOINT() {
     invoke_check<voided_castling_availability>();
     invoke_check<checkmate>();
     invoke_check<en_passant>();
+    invoke_check<make_unmake>();
+    invoke_check<move_count>();
 }
\ No newline at end of file
@@ -0,0 +1,226 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+// the generated move matching a move given as two squares, e.g. "e2 e4"
+static libchess::packed_move_t find_move(const libchess::move_list& moves,
+                                         const std::string& desc) {
+    std::vector<std::string> squares;
+    libchess::util::split_string(desc, ' ', squares);
+    assert::is_equal(squares.size(), 2);
+
+    libchess::move_t move;
+    assert::is_true(libchess::util::parse_coordinate(squares[0], move.position));
+    assert::is_true(libchess::util::parse_coordinate(squares[1], move.destination));
+
+    auto packed = libchess::packed_move_t::pack(move);
+    auto found = std::find_if(moves.begin(), moves.end(), [&](libchess::packed_move_t other) {
+        return other.matches(packed);
+    });
+
+    assert::is_true(found != moves.end());
+    return *found;
+}
+
+static std::vector<libchess::packed_move_t> pick_all(libchess::move_picker& picker) {
+    std::vector<libchess::packed_move_t> picked;
+
+    libchess::packed_move_t move;
+    while (picker.next(move)) {
+        picked.push_back(move);
+    }
+
+    return picked;
+}
+
+static std::unique_ptr<libchess::move_history_t> create_history() {
+    auto history = std::make_unique<libchess::move_history_t>();
+    history->clear();
+
+    return history;
+}
+
+class picked_moves : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        libchess::move_list generated, moves;
+        engine.generate_legal_moves(generated);
+        engine.generate_legal_moves(moves);
+
+        auto history = create_history();
+        libchess::move_picker picker(board->get_data(), moves, libchess::packed_move_t(),
+                                     *history, 0, nullptr);
+
+        // every move exactly once, with tactical moves before any quiet one
+        auto picked = pick_all(picker);
+        assert::is_equal(picked.size(), generated.size());
+
+        bool quiet = false;
+        for (auto move : picked) {
+            bool tactical = libchess::move_picker::is_tactical(board->get_data(), move);
+            assert::is_false(quiet && tactical);
+            quiet = !tactical;
+        }
+
+        auto value = [](libchess::packed_move_t move) { return move.value; };
+        std::vector<uint16_t> expected, actual;
+        std::transform(generated.begin(), generated.end(), std::back_inserter(expected), value);
+        std::transform(picked.begin(), picked.end(), std::back_inserter(actual), value);
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        assert::is_true(expected == actual);
+
+        // the generator's own order is left alone
+        libchess::move_list regenerated;
+        engine.generate_legal_moves(regenerated);
+        assert::is_true(std::equal(generated.begin(), generated.end(), regenerated.begin(),
+                                   regenerated.end()));
+    }
+
+    virtual std::string get_check_name() override { return "picked_moves"; }
+};
+
+class capture_order : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create("4k3/8/8/3q1r2/4P3/2N5/8/4K3 w - - 0 1");
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        libchess::move_list moves;
+        engine.generate_legal_moves(moves);
+
+        auto history = create_history();
+        libchess::move_picker picker(board->get_data(), moves, libchess::packed_move_t(),
+                                     *history, 0, nullptr);
+
+        // the queen before the rook, and the pawn taking it before the knight
+        auto picked = pick_all(picker);
+        assert::is_true(picked[0] == find_move(moves, "e4 d5"));
+        assert::is_true(picked[1] == find_move(moves, "c3 d5"));
+        assert::is_true(picked[2] == find_move(moves, "e4 f5"));
+
+        // except that the table's move comes first of all
+        auto table_move = find_move(moves, "c3 b1");
+        libchess::move_picker table_picker(board->get_data(), moves, table_move, *history, 0,
+                                           nullptr);
+
+        picked = pick_all(table_picker);
+        assert::is_true(picked[0] == table_move);
+        assert::is_true(picked[1] == find_move(moves, "e4 d5"));
+    }
+
+    virtual std::string get_check_name() override { return "capture_order"; }
+};
+
+class quiet_order : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create_default();
+        const auto& data = board->get_data();
+
+        libchess::engine engine(board);
+        libchess::move_list moves;
+        engine.generate_legal_moves(moves);
+
+        auto cutoff = find_move(moves, "g1 f3");
+        auto tried = find_move(moves, "a2 a3");
+
+        auto history = create_history();
+        history->update(data, nullptr, 2, 4, cutoff, &tried, 1);
+
+        // a killer at its own ply
+        libchess::move_picker killer_picker(data, moves, libchess::packed_move_t(), *history, 2,
+                                            nullptr);
+
+        auto picked = pick_all(killer_picker);
+        assert::is_true(picked.front() == cutoff);
+        assert::is_true(picked.back() == tried);
+
+        // and by history score everywhere else
+        history->killers[2].fill(libchess::packed_move_t());
+        libchess::move_picker history_picker(data, moves, libchess::packed_move_t(), *history, 5,
+                                             nullptr);
+
+        picked = pick_all(history_picker);
+        assert::is_true(picked.front() == cutoff);
+        assert::is_true(picked.back() == tried);
+
+        // the counter to a move is tried right after the killers
+        assert::is_true(engine.make_move(find_move(moves, "e2 e4")));
+        const auto* previous = engine.get_last_undo();
+
+        libchess::move_list replies;
+        engine.generate_legal_moves(replies);
+
+        auto counter = find_move(replies, "c7 c5");
+        history->update(data, previous, 1, 4, counter, nullptr, 0);
+        history->killers[1].fill(libchess::packed_move_t());
+
+        libchess::move_picker counter_picker(data, replies, libchess::packed_move_t(), *history,
+                                             3, previous);
+
+        picked = pick_all(counter_picker);
+        assert::is_true(picked.front() == counter);
+    }
+
+    virtual std::string get_check_name() override { return "quiet_order"; }
+};
+
+class cutoff_statistics : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create(
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+        assert::is_not_nullptr(board);
+        libchess::engine engine(board);
+
+        libchess::searcher searcher;
+        libchess::search_limits_t limits;
+        limits.depth = 4;
+
+        libchess::search_info_t info;
+        assert::is_true(searcher.search(engine, limits, info));
+
+        // most cutoffs should come from the first move when moves are well ordered
+        assert::is_true(info.cutoffs > 0);
+        assert::is_true(info.first_move_cutoffs <= info.cutoffs);
+        assert::is_true(info.get_first_move_cutoff_rate() > 0.75);
+    }
+
+    virtual std::string get_check_name() override { return "cutoff_statistics"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<picked_moves>();
+    invoke_check<capture_order>();
+    invoke_check<quiet_order>();
+    invoke_check<cutoff_statistics>();
+}
\ No newline at end of file
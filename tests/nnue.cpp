@@ -0,0 +1,277 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+#include <random>
+
+// small enough random weights that the accumulators never wrap
+static const std::string& get_network_bytes() {
+    static std::string bytes;
+    if (bytes.empty()) {
+        std::mt19937 generator(1234);
+        std::uniform_int_distribution<int32_t> distribution(-64, 64);
+        auto fill = [&](std::vector<int16_t>& values, size_t count) {
+            values.resize(count);
+            for (auto& value : values) {
+                value = (int16_t)distribution(generator);
+            }
+        };
+
+        libchess::nnue::network_weights_t weights;
+        fill(weights.feature_weights, libchess::nnue::feature_count * libchess::nnue::hidden_size);
+        fill(weights.feature_biases, libchess::nnue::hidden_size);
+        fill(weights.output_weights, libchess::nnue::hidden_size * 2);
+        weights.output_bias = 1000;
+
+        std::stringstream stream;
+        assert::is_true(libchess::nnue::network::write(stream, weights));
+        bytes = stream.str();
+    }
+
+    return bytes;
+}
+
+static std::shared_ptr<libchess::nnue::network> get_network() {
+    auto network = libchess::nnue::network::create(get_network_bytes());
+    assert::is_not_nullptr(network);
+
+    return network;
+}
+
+static void assert_equal(const libchess::nnue::accumulator_t& lhs,
+                         const libchess::nnue::accumulator_t& rhs) {
+    assert::is_true(lhs.values == rhs.values);
+}
+
+class network_files : public test_fact {
+protected:
+    virtual void invoke() override {
+        const auto& bytes = get_network_bytes();
+        assert::is_not_nullptr(libchess::nnue::network::create(bytes));
+
+        assert::is_nullptr(libchess::nnue::network::create(bytes.substr(0, bytes.length() - 2)));
+        assert::is_nullptr(libchess::nnue::network::create(std::string_view()));
+
+        std::string corrupt = bytes;
+        corrupt[0] = 'X';
+        assert::is_nullptr(libchess::nnue::network::create(corrupt));
+
+        // an output layer that could overflow 32 bits is refused
+        libchess::nnue::network_weights_t weights;
+        weights.feature_weights.resize(libchess::nnue::feature_count *
+                                       libchess::nnue::hidden_size);
+        weights.feature_biases.resize(libchess::nnue::hidden_size);
+        weights.output_weights.resize(libchess::nnue::hidden_size * 2, 32767);
+
+        std::stringstream stream;
+        assert::is_true(libchess::nnue::network::write(stream, weights));
+        assert::is_nullptr(libchess::nnue::network::create(stream.str()));
+
+        weights.output_weights.pop_back();
+        assert::is_false(libchess::nnue::network::write(stream, weights));
+    }
+
+    virtual std::string get_check_name() override { return "network_files"; }
+};
+
+// makes and unmakes every line to the given depth, comparing the updated accumulator with one
+// computed from scratch at each node
+static void walk(libchess::engine& engine, const libchess::nnue::network& network,
+                 std::vector<libchess::nnue::accumulator_t>& stack, size_t ply, uint32_t depth) {
+    const auto& data = engine.get_board()->get_data();
+
+    libchess::nnue::accumulator_t refreshed;
+    network.refresh(refreshed, data);
+    assert_equal(stack[ply], refreshed);
+
+    if (depth == 0) {
+        return;
+    }
+
+    libchess::move_list moves;
+    engine.generate_legal_moves(moves);
+
+    for (size_t i = 0; i < moves.size(); i++) {
+        assert::is_true(engine.make_move(moves[i]));
+        network.update(stack[ply], stack[ply + 1], *engine.get_last_undo(), data);
+
+        walk(engine, network, stack, ply + 1, depth - 1);
+        assert::is_true(engine.unmake_move());
+    }
+}
+
+class incremental_accumulators : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+        inline_data({ "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto network = get_network();
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        std::vector<libchess::nnue::accumulator_t> stack(4);
+
+        network->refresh(stack[0], board->get_data());
+        walk(engine, *network, stack, 0, 3);
+    }
+
+    virtual std::string get_check_name() override { return "incremental_accumulators"; }
+};
+
+class simd_kernels : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1" });
+        inline_data({ "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        auto network = get_network();
+        network->set_simd_level(libchess::nnue::simd_level::scalar);
+        assert::is_true(network->get_simd_level() == libchess::nnue::simd_level::scalar);
+
+        libchess::nnue::accumulator_t expected;
+        network->refresh(expected, board->get_data());
+        int32_t expected_score = network->evaluate(expected, board->get_data().current_turn);
+
+        // every level the cpu has must agree with the scalar kernels exactly
+        for (auto level : { libchess::nnue::simd_level::sse41, libchess::nnue::simd_level::avx2 }) {
+            network->set_simd_level(level);
+            assert::is_true(network->get_simd_level() <= libchess::nnue::detect_simd_level());
+
+            libchess::nnue::accumulator_t accumulator;
+            network->refresh(accumulator, board->get_data());
+
+            assert_equal(accumulator, expected);
+            assert::is_equal(network->evaluate(accumulator, board->get_data().current_turn),
+                             expected_score);
+        }
+    }
+
+    virtual std::string get_check_name() override { return "simd_kernels"; }
+};
+
+class mirrored_networks : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                      "r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq - 0 1" });
+
+        inline_data({ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                      "8/4p1p1/8/1r3P1K/kp5R/3P4/2P5/8 b - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto network = get_network();
+        auto board = libchess::board::create(data[0]);
+        auto mirrored = libchess::board::create(data[1]);
+
+        assert::is_not_nullptr(board);
+        assert::is_not_nullptr(mirrored);
+
+        // each side sees the board from its own end, so a mirrored position is the same to it
+        libchess::nnue::accumulator_t accumulator, mirrored_accumulator;
+        network->refresh(accumulator, board->get_data());
+        network->refresh(mirrored_accumulator, mirrored->get_data());
+
+        assert::is_equal(network->evaluate(accumulator, board->get_data().current_turn),
+                         network->evaluate(mirrored_accumulator,
+                                           mirrored->get_data().current_turn));
+    }
+
+    virtual std::string get_check_name() override { return "mirrored_networks"; }
+};
+
+class network_search : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::engine engine(libchess::board::create_default());
+        std::string fen = engine.get_board()->serialize();
+
+        libchess::searcher searcher;
+        searcher.set_network(get_network());
+
+        libchess::search_limits_t limits;
+        limits.depth = 3;
+
+        libchess::search_info_t info;
+        assert::is_true(searcher.search(engine, limits, info));
+        assert::is_true(engine.is_move_legal(info.pv[0]));
+        assert::is_equal(engine.get_board()->serialize(), fen);
+    }
+
+    virtual std::string get_check_name() override { return "network_search"; }
+};
+
+class network_score_bounds : public test_fact {
+protected:
+    virtual void invoke() override {
+        // every hidden neuron saturates, and the output is nearly as large as create allows
+        libchess::nnue::network_weights_t weights;
+        weights.feature_weights.resize(libchess::nnue::feature_count *
+                                       libchess::nnue::hidden_size);
+        weights.feature_biases.resize(libchess::nnue::hidden_size, 255);
+        weights.output_weights.resize(libchess::nnue::hidden_size * 2, 16000);
+
+        std::stringstream stream;
+        assert::is_true(libchess::nnue::network::write(stream, weights));
+
+        std::string bytes = stream.str();
+        auto network = libchess::nnue::network::create(bytes);
+        assert::is_not_nullptr(network);
+
+        libchess::engine engine(libchess::board::create_default());
+        libchess::nnue::accumulator_t accumulator;
+        network->refresh(accumulator, engine.get_board()->get_data());
+        assert::is_true(network->evaluate(accumulator, libchess::player_color::white) >
+                        libchess::searcher::mate_score);
+
+        libchess::searcher searcher;
+        searcher.set_network(network);
+
+        libchess::search_limits_t limits;
+        libchess::search_info_t info;
+
+        // the later searches read scores back out of the table
+        for (uint32_t depth : { 2, 3, 2 }) {
+            limits.depth = depth;
+            assert::is_true(searcher.search(engine, limits, info));
+            assert::is_false(libchess::searcher::is_mate_score(info.score));
+            assert::is_true(std::abs(info.score) <= libchess::searcher::max_eval_score);
+        }
+    }
+
+    virtual std::string get_check_name() override { return "network_score_bounds"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<network_files>();
+    invoke_check<incremental_accumulators>();
+    invoke_check<simd_kernels>();
+    invoke_check<mirrored_networks>();
+    invoke_check<network_search>();
+    invoke_check<network_score_bounds>();
+}
\ No newline at end of file
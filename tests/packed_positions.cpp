@@ -0,0 +1,172 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static libchess::board::data_t parse_position(const std::string& fen) {
+    libchess::board::data_t data;
+    assert::is_true(libchess::board::parse_fen(fen, data) == libchess::fen_error::none);
+
+    return data;
+}
+
+static std::string serialize_position(const libchess::board::data_t& data) {
+    libchess::board::fen_buffer_t buffer;
+    libchess::board::serialize(data, buffer.data(), buffer.size());
+
+    return buffer.data();
+}
+
+// fen
+class packed_round_trip : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w Kq d6 0 3" });
+        inline_data({ "r3k2r/8/8/8/8/8/8/R3K2R b Qk - 99 65535" });
+        inline_data({ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 65535 4294967295" });
+        inline_data({ "8/8/8/8/8/8/8/8 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto position = parse_position(data[0]);
+
+        libchess::packed_position_t packed;
+        assert::is_true(libchess::board::pack(position, packed));
+
+        libchess::board::data_t unpacked;
+        assert::is_true(libchess::board::unpack(packed, unpacked));
+
+        assert::is_equal(serialize_position(unpacked), data[0]);
+        assert::is_equal(unpacked.key, position.key);
+        assert::is_equal(unpacked.occupancy, position.occupancy);
+        assert::is_true(unpacked.piece_masks == position.piece_masks);
+    }
+
+    virtual std::string get_check_name() override { return "packed_round_trip"; }
+};
+
+class packed_layout : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto position = parse_position("4k3/8/8/8/8/8/8/R3K3 b Q e3 7 300");
+
+        libchess::packed_position_t packed;
+        assert::is_true(libchess::board::pack(position, packed));
+
+        // a1, e1 and e8, little-endian
+        const std::array<uint8_t, libchess::packed_position_t::size> expected = {
+            0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, // occupancy
+            0x13, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // white rook, white king, black king
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //
+            0x05, 20,   7,    0,    0x2C, 0x01, 0x00, 0x00, // flags, e3, clocks
+        };
+
+        assert::is_true(packed.bytes == expected);
+    }
+
+    virtual std::string get_check_name() override { return "packed_layout"; }
+};
+
+class bad_packed_positions : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::packed_position_t packed;
+        libchess::board::data_t data;
+
+        // 33 pieces don't fit
+        auto crowded = parse_position("rnbqkbnr/pppppppp/8/8/8/7P/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        assert::is_false(libchess::board::pack(crowded, packed));
+
+        auto position = parse_position("4k3/8/8/8/8/8/8/4K3 w - - 70000 1");
+        assert::is_false(libchess::board::pack(position, packed));
+
+        position.halfmove_clock = 0;
+        assert::is_true(libchess::board::pack(position, packed));
+        assert::is_true(libchess::board::unpack(packed, data));
+
+        auto broken = packed;
+        broken.bytes[8] = 0x07; // no such piece type
+        assert::is_false(libchess::board::unpack(broken, data));
+
+        broken = packed;
+        broken.bytes[9] = 0x10; // a third piece that isn't in the occupancy
+        assert::is_false(libchess::board::unpack(broken, data));
+
+        broken = packed;
+        broken.bytes[24] = 0x20; // unused flag bits
+        assert::is_false(libchess::board::unpack(broken, data));
+
+        broken = packed;
+        broken.bytes[25] = 64; // en passant off the board
+        assert::is_false(libchess::board::unpack(broken, data));
+    }
+
+    virtual std::string get_check_name() override { return "bad_packed_positions"; }
+};
+
+class position_files : public test_fact {
+protected:
+    virtual void invoke() override {
+        static const std::vector<std::string> fens = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        };
+
+        // enough positions to span several write chunks
+        std::vector<libchess::board::data_t> positions;
+        for (size_t i = 0; i < 3000; i++) {
+            auto& position = positions.emplace_back(parse_position(fens[i % fens.size()]));
+            position.fullmove_count = i + 1;
+        }
+
+        std::stringstream stream;
+        assert::is_true(libchess::position_file::write(stream, positions.data(), positions.size()));
+        assert::is_equal(stream.str().length(),
+                         positions.size() * libchess::packed_position_t::size);
+
+        auto file = libchess::position_file::create(stream);
+        assert::is_not_nullptr(file);
+        assert::is_equal(file->get_count(), positions.size());
+
+        libchess::board::data_t data;
+        assert::is_true(file->read(1234, data));
+        assert::is_equal(data.fullmove_count, 1235);
+        assert::is_equal(data.key, positions[1234].key);
+        assert::is_false(file->read(positions.size(), data));
+
+        std::vector<libchess::board::data_t> read(10);
+        assert::is_equal(file->read(positions.size() - 4, read.size(), read.data()), 4);
+        assert::is_equal(serialize_position(read[3]), serialize_position(positions.back()));
+
+        // a partial record means the file is truncated or not a position file at all
+        auto truncated = stream.str();
+        truncated.pop_back();
+        assert::is_nullptr(libchess::position_file::create(std::string_view(truncated)));
+    }
+
+    virtual std::string get_check_name() override { return "position_files"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<packed_round_trip>();
+    invoke_check<packed_layout>();
+    invoke_check<bad_packed_positions>();
+    invoke_check<position_files>();
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+class perft_counts : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "4", "197281", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "3", "97862",
+                      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "4", "43238", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+        inline_data(
+            { "3", "9467", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" });
+        inline_data({ "3", "62379", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" });
+        inline_data(
+            { "3", "89890",
+              "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[2]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        uint64_t nodes = libchess::perft(engine, (uint32_t)std::stoul(data[0]));
+
+        assert::is_equal(nodes, (uint64_t)std::stoull(data[1]));
+        assert::is_equal(board->serialize(), data[2]);
+        assert::is_equal(engine.get_undo_depth(), 0);
+    }
+
+    virtual std::string get_check_name() override { return "perft_counts"; }
+};
+
+class perft_divide : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create_default();
+        libchess::engine engine(board);
+
+        std::vector<libchess::perft_divide_entry_t> entries;
+        uint64_t nodes = libchess::perft_divide(engine, 3, entries);
+
+        assert::is_equal(nodes, 8902);
+        assert::is_equal(entries.size(), 20);
+
+        uint64_t sum = 0;
+        for (const auto& entry : entries) {
+            sum += entry.nodes;
+        }
+
+        assert::is_equal(sum, nodes);
+    }
+
+    virtual std::string get_check_name() override { return "perft_divide"; }
+};
+
+class parallel_perft : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "4", "1", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "4", "2",
+                      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "5", "3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+        inline_data({ "2", "2", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[2]);
+        assert::is_not_nullptr(board);
+
+        auto depth = (uint32_t)std::stoul(data[0]);
+        auto split_depth = (uint32_t)std::stoul(data[1]);
+
+        libchess::engine engine(board);
+        uint64_t expected = libchess::perft(engine, depth);
+
+        libchess::thread_pool pool(3);
+        uint64_t nodes = libchess::perft_parallel(engine, depth, pool, split_depth);
+
+        assert::is_equal(nodes, expected);
+        assert::is_equal(board->serialize(), data[2]);
+    }
+
+    virtual std::string get_check_name() override { return "parallel_perft"; }
+};
+
+class hashed_perft : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "5", "4865609", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "4", "4085603",
+                      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "5", "674624", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[2]);
+        assert::is_not_nullptr(board);
+
+        auto depth = (uint32_t)std::stoul(data[0]);
+        auto expected = (uint64_t)std::stoull(data[1]);
+
+        libchess::engine engine(board);
+        libchess::perft_table table(1);
+
+        assert::is_equal(libchess::perft(engine, depth, &table), expected);
+        assert::is_true(table.get_stats().hits > 0);
+
+        // a warm table shared between workers has to give the same answer
+        libchess::thread_pool pool(3);
+        assert::is_equal(libchess::perft_parallel(engine, depth, pool, 2, &table), expected);
+        assert::is_equal(board->serialize(), data[2]);
+    }
+
+    virtual std::string get_check_name() override { return "hashed_perft"; }
+};
+
+class perft_table_entries : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::perft_table table(1);
+        assert::is_true(table.get_entry_count() > 0);
+
+        uint64_t key = 0x123456789ABCDEF0;
+        uint64_t nodes = 0;
+
+        assert::is_false(table.probe(key, 3, nodes));
+        table.store(key, 3, 8902);
+
+        assert::is_true(table.probe(key, 3, nodes));
+        assert::is_equal(nodes, 8902);
+
+        // same slot, but a different depth or key must miss
+        assert::is_false(table.probe(key, 4, nodes));
+        assert::is_false(table.probe(key + table.get_entry_count(), 3, nodes));
+
+        table.clear();
+        assert::is_false(table.probe(key, 3, nodes));
+    }
+
+    virtual std::string get_check_name() override { return "perft_table_entries"; }
+};
+
+class thread_pool_tasks : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::thread_pool pool(4);
+        assert::is_equal(pool.get_thread_count(), 4);
+
+        std::atomic<uint64_t> sum;
+        sum = 0;
+
+        for (uint64_t i = 1; i <= 1000; i++) {
+            pool.submit([&sum, i](size_t worker) { sum += i; });
+        }
+
+        pool.wait();
+        assert::is_equal(sum.load(), 500500);
+
+        // the pool has to be reusable after a wait
+        pool.submit([&sum](size_t worker) { sum = 0; });
+        pool.wait();
+
+        assert::is_equal(sum.load(), 0);
+    }
+
+    virtual std::string get_check_name() override { return "thread_pool_tasks"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<perft_counts>();
+    invoke_check<perft_divide>();
+    invoke_check<parallel_perft>();
+    invoke_check<hashed_perft>();
+    invoke_check<perft_table_entries>();
+    invoke_check<thread_pool_tasks>();
+}
\ No newline at end of file
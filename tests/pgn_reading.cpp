@@ -0,0 +1,138 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static const std::string s_pgn_text = R"([Event "Test \"quoted\""]
+[Site "?"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 {a comment with [brackets]
+[Event "not a tag"]} Nc6 3. Bb5 $1 a6 (3... Nf6 4. O-O (4. d3) Nxe4) 4. Ba4 Nf6
+5. O-O Be7 ; a rest-of-line comment {
+6. Re1 b5 7.Bb3 d6 8. c3 O-O 1-0
+
+[Event "promotion"]
+[SetUp "1"]
+[FEN "4k3/P7/8/8/8/8/8/R3K2R w KQ - 0 1"]
+
+1. a8=Q+ Kd7 2. Rad1+! Ke6 3. Qe8+ Kf5 *
+
+[Event "broken"]
+
+1. e4 e5 2. Ke3 *
+)";
+
+class pgn_games : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "0", "r1bq1rk1/2p1bppp/p1np1n2/1p2p3/4P3/1BP2N2/PP1P1PPP/RNBQR1K1 w - - 1 9",
+                      "1-0" });
+        inline_data({ "1", "4Q3/8/8/5k2/8/8/8/3RK2R w K - 5 4", "*" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto reader = libchess::pgn_reader::create(s_pgn_text);
+        assert::is_equal(reader->find_games(), 3);
+
+        libchess::engine engine;
+        libchess::pgn_game_t game;
+
+        size_t index = (size_t)std::stoull(data[0]);
+        assert::is_true(libchess::pgn_reader::decode(reader->get_games()[index], engine, game));
+        assert::is_true(game.error == libchess::pgn_error::none);
+
+        assert::is_equal(engine.serialize_board(), data[1]);
+        assert::is_equal(game.result, std::string_view(data[2]));
+
+        // replaying the decoded moves from the initial position has to land in the same place
+        auto board = libchess::board::create(game.initial_position);
+        libchess::engine replay(board);
+
+        for (const auto& move : game.moves) {
+            assert::is_true(replay.commit_move(move));
+        }
+
+        assert::is_equal(board->serialize(), data[1]);
+    }
+
+    virtual std::string get_check_name() override { return "pgn_games"; }
+};
+
+class pgn_tags_and_errors : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto reader = libchess::pgn_reader::create(s_pgn_text);
+        reader->find_games();
+
+        libchess::engine engine;
+        libchess::pgn_game_t game;
+
+        assert::is_true(libchess::pgn_reader::decode(reader->get_games()[0], engine, game));
+        assert::is_equal(game.tag_count, 3);
+        assert::is_equal(game.find_tag("Event").value_or(""),
+                         std::string_view("Test \\\"quoted\\\""));
+        assert::is_equal(game.moves.size(), 16);
+
+        assert::is_false(libchess::pgn_reader::decode(reader->get_games()[2], engine, game));
+        assert::is_true(game.error == libchess::pgn_error::move);
+        assert::is_equal(game.error_token, std::string_view("Ke3"));
+        assert::is_equal(game.moves.size(), 2);
+
+        assert::is_false(libchess::pgn_reader::decode("[Event \"unterminated]", engine, game));
+        assert::is_true(game.error == libchess::pgn_error::tag);
+    }
+
+    virtual std::string get_check_name() override { return "pgn_tags_and_errors"; }
+};
+
+class parallel_pgn : public test_fact {
+protected:
+    virtual void invoke() override {
+        // enough copies that every worker gets several batches
+        std::string text;
+        for (size_t i = 0; i < 200; i++) {
+            text += s_pgn_text + "\n";
+        }
+
+        auto reader = libchess::pgn_reader::create(text);
+        assert::is_equal(reader->find_games(), 600);
+
+        std::vector<size_t> move_counts(600, 0);
+        auto callback = [&](const libchess::pgn_game_t& game, size_t worker) {
+            move_counts[game.index] = game.moves.size();
+        };
+
+        libchess::thread_pool pool(4);
+        assert::is_equal(reader->read(callback, &pool), 400);
+
+        for (size_t i = 0; i < move_counts.size(); i++) {
+            static const size_t expected[] = { 16, 6, 2 };
+            assert::is_equal(move_counts[i], expected[i % 3]);
+        }
+
+        assert::is_equal(reader->read(callback), 400);
+    }
+
+    virtual std::string get_check_name() override { return "parallel_pgn"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<pgn_games>();
+    invoke_check<pgn_tags_and_errors>();
+    invoke_check<parallel_pgn>();
+}
\ No newline at end of file
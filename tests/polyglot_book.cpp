@@ -0,0 +1,339 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+// stands in for polyglot's own numbers - the layout and lookups are the same for any table
+static std::string generate_random_table() {
+    std::stringstream stream;
+    uint64_t state = 0x0123456789ABCDEFull;
+
+    for (size_t i = 0; i < libchess::polyglot::random_count; i++) {
+        // splitmix64
+        uint64_t value = (state += 0x9E3779B97F4A7C15ull);
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        value ^= value >> 31;
+
+        stream << "0x" << std::hex << std::uppercase << value << (i % 4 == 3 ? ",\n" : ", ");
+    }
+
+    return stream.str();
+}
+
+static std::shared_ptr<const libchess::polyglot::random_table_t> load_table() {
+    auto table = std::make_shared<libchess::polyglot::random_table_t>();
+
+    std::stringstream stream(generate_random_table());
+    assert::is_true(libchess::polyglot::load_random_table(stream, *table));
+
+    return table;
+}
+
+static libchess::board::data_t parse_position(const std::string& fen) {
+    libchess::board::data_t data;
+    assert::is_true(libchess::board::parse_fen(fen, data) == libchess::fen_error::none);
+
+    return data;
+}
+
+static uint16_t encode_book_move(const std::string& uci) {
+    libchess::packed_move_t move;
+    assert::is_true(libchess::uci::parse(uci.substr(0, 4), move));
+
+    // polyglot numbers promotions knight, bishop, rook, queen from 1
+    uint16_t promotion = 0;
+    if (uci.length() == 5) {
+        promotion = (uint16_t)(std::string("nbrq").find(uci[4]) + 1);
+    }
+
+    return (uint16_t)(move.get_destination() | (move.get_position() << 6) | (promotion << 12));
+}
+
+struct book_entry_t {
+    std::string fen, move;
+    uint16_t weight;
+};
+
+static std::string build_book(const std::vector<book_entry_t>& entries,
+                              const libchess::polyglot::random_table_t& table) {
+    std::vector<libchess::polyglot::entry_t> packed;
+    for (const auto& entry : entries) {
+        auto& result = packed.emplace_back();
+        result.key = libchess::polyglot::compute_key(parse_position(entry.fen), table);
+        result.move = encode_book_move(entry.move);
+        result.weight = entry.weight;
+        result.learn = 0;
+    }
+
+    std::stable_sort(packed.begin(), packed.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.key < rhs.key; });
+
+    std::string bytes;
+    for (const auto& entry : packed) {
+        uint64_t fields[] = { entry.key, entry.move, entry.weight, entry.learn };
+        size_t sizes[] = { 8, 2, 2, 4 };
+
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t j = sizes[i]; j > 0; j--) {
+                bytes.push_back((char)(uint8_t)(fields[i] >> ((j - 1) * 8)));
+            }
+        }
+    }
+
+    return bytes;
+}
+
+static const std::string s_start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static const std::string s_castling = "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1";
+static const std::string s_promotion = "3k4/4P3/8/8/8/8/8/4K3 w - - 0 1";
+
+// the key as the specification spells it out, square by square
+static uint64_t reference_key(const libchess::board::data_t& data,
+                              const libchess::polyglot::random_table_t& table) {
+    uint64_t key = 0;
+
+    // black pawn, white pawn, black knight and so on up to the white king
+    for (size_t square = 0; square < libchess::board::size; square++) {
+        const auto& piece = data.pieces[square ^ 56];
+        if (piece.type == libchess::piece_type::none) {
+            continue;
+        }
+
+        static const size_t kinds[] = { 0, 10, 8, 6, 2, 4, 0 };
+        size_t kind = kinds[(size_t)piece.type];
+        if (piece.color == libchess::player_color::white) {
+            kind++;
+        }
+
+        key ^= table[kind * 64 + square];
+    }
+
+    static const libchess::castle_side sides[] = { libchess::castle_side_king,
+                                                   libchess::castle_side_queen };
+
+    size_t index = 768;
+    for (auto color : { libchess::player_color::white, libchess::player_color::black }) {
+        for (auto side : sides) {
+            if ((data.player_castling_availability[color] & side) != libchess::castle_side_none) {
+                key ^= table[index];
+            }
+
+            index++;
+        }
+    }
+
+    bool white = data.current_turn == libchess::player_color::white;
+    if (data.en_passant_target.has_value()) {
+        auto target = data.en_passant_target.value();
+        int32_t y = target.y + (white ? -1 : 1);
+
+        for (int32_t x : { target.x - 1, target.x + 1 }) {
+            if (x < 0 || x >= 8) {
+                continue;
+            }
+
+            const auto& piece = data.pieces[libchess::bitboard::get_square(x, y) ^ 56];
+            if (piece.type == libchess::piece_type::pawn && piece.color == data.current_turn) {
+                key ^= table[772 + target.x];
+                break;
+            }
+        }
+    }
+
+    if (white) {
+        key ^= table[780];
+    }
+
+    return key;
+}
+
+class polyglot_keys : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto table = load_table();
+
+        auto start = parse_position(s_start);
+        assert::is_equal(libchess::polyglot::compute_key(start, *table),
+                         reference_key(start, *table));
+
+        // en passant only counts if it can be taken
+        auto no_capture = parse_position(
+            "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+        auto no_target = parse_position(
+            "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+        assert::is_equal(libchess::polyglot::compute_key(no_capture, *table),
+                         libchess::polyglot::compute_key(no_target, *table));
+
+        auto capture = parse_position(
+            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+        auto capture_removed = parse_position(
+            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 3");
+        assert::is_equal(libchess::polyglot::compute_key(capture, *table),
+                         libchess::polyglot::compute_key(capture_removed, *table) ^
+                             (*table)[772 + 5]);
+    }
+
+    virtual std::string get_check_name() override { return "polyglot_keys"; }
+};
+
+// the specification's worked examples. its keys only come out with polyglot's own array, so
+// without one built in, the positions are checked against reference_key instead
+class reference_keys : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "463b96181691fc9c" });
+        inline_data({ "823c9b50fd114196", "e2 e4" });
+        inline_data({ "0756b94461c50fb0", "e2 e4", "d7 d5" });
+        inline_data({ "662fafb965db29d4", "e2 e4", "d7 d5", "e4 e5" });
+        inline_data({ "22a48b5a8e47ff78", "e2 e4", "d7 d5", "e4 e5", "f7 f5" });
+        inline_data({ "652a607ca3f242c1", "e2 e4", "d7 d5", "e4 e5", "f7 f5", "e1 e2" });
+        inline_data(
+            { "00fdd303c946bdd9", "e2 e4", "d7 d5", "e4 e5", "f7 f5", "e1 e2", "e8 f7" });
+
+        inline_data({ "3c8123ea7b067637", "a2 a4", "b7 b5", "h2 h4", "b5 b4", "c2 c4" });
+        inline_data({ "5c3f9b829b279560", "a2 a4", "b7 b5", "h2 h4", "b5 b4", "c2 c4", "b4 c3",
+                      "a1 a2" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::engine engine(libchess::board::create_default());
+        for (size_t i = 1; i < data.size(); i++) {
+            std::vector<std::string> squares;
+            libchess::util::split_string(data[i], ' ', squares);
+            assert::is_equal(squares.size(), 2);
+
+            libchess::move_t move;
+            assert::is_true(libchess::util::parse_coordinate(squares[0], move.position));
+            assert::is_true(libchess::util::parse_coordinate(squares[1], move.destination));
+            assert::is_true(engine.commit_move(move));
+        }
+
+        const auto& position = engine.get_board()->get_data();
+        auto generated = load_table();
+        assert::is_equal(libchess::polyglot::compute_key(position, *generated),
+                         reference_key(position, *generated));
+
+        auto published = libchess::polyglot::get_random_table();
+#ifdef LIBCHESS_POLYGLOT_RANDOM
+        assert::is_not_nullptr(published);
+#endif
+
+        if (published) {
+            assert::is_equal(libchess::polyglot::compute_key(position, *published),
+                             std::stoull(data[0], nullptr, 16));
+        }
+    }
+
+    virtual std::string get_check_name() override { return "reference_keys"; }
+};
+
+class bad_random_tables : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::polyglot::random_table_t table;
+
+        auto text = generate_random_table();
+        std::stringstream too_short(text.substr(0, text.rfind("0x")));
+        assert::is_false(libchess::polyglot::load_random_table(too_short, table));
+
+        std::stringstream too_long(text + " 0x1");
+        assert::is_false(libchess::polyglot::load_random_table(too_long, table));
+
+        std::stringstream bad_digit("0x12G4" + text.substr(text.find(',')));
+        assert::is_false(libchess::polyglot::load_random_table(bad_digit, table));
+
+        // suffixes and bare hex are fine
+        std::stringstream suffixed("123ULL, " + text.substr(text.find(',') + 1));
+        assert::is_true(libchess::polyglot::load_random_table(suffixed, table));
+        assert::is_equal(table[0], 0x123);
+    }
+
+    virtual std::string get_check_name() override { return "bad_random_tables"; }
+};
+
+class book_moves : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto table = load_table();
+        auto bytes = build_book({ { s_start, "e2e4", 3 },
+                                  { s_castling, "e1h1", 5 },
+                                  { s_start, "e2e5", 10 }, // not legal - skipped
+                                  { s_start, "d2d4", 1 },
+                                  { s_castling, "e1a1", 0 },
+                                  { s_promotion, "e7e8q", 1 } },
+                                *table);
+
+        auto book = libchess::polyglot_book::create(bytes, table);
+        assert::is_not_nullptr(book);
+        assert::is_equal(book->get_entry_count(), 6);
+
+        size_t first;
+        auto start = parse_position(s_start);
+        assert::is_equal(book->find(book->compute_key(start), first), 3);
+        assert::is_equal(book->get_entry(first).weight, 3);
+
+        libchess::engine engine(libchess::board::create(start));
+        libchess::move_list moves;
+        std::array<uint16_t, libchess::move_list::capacity> weights;
+
+        assert::is_equal(book->probe(engine, moves, weights.data()), 2);
+        assert::is_equal(libchess::uci::serialize(moves[0]), "e2e4");
+        assert::is_equal(libchess::uci::serialize(moves[1]), "d2d4");
+        assert::is_equal(weights[1], 1);
+
+        // weights 3 and 1 split the range of random numbers 3 to 1
+        libchess::packed_move_t move;
+        for (uint64_t random = 0; random < 8; random++) {
+            assert::is_true(book->pick(engine, random, move));
+            assert::is_equal(libchess::uci::serialize(move), random % 4 < 3 ? "e2e4" : "d2d4");
+        }
+
+        // polyglot's king-takes-rook castling comes back as a normal castling move
+        libchess::engine castling(libchess::board::create(s_castling));
+        assert::is_equal(book->probe(castling, moves, nullptr), 2);
+        assert::is_equal(libchess::uci::serialize(moves[0]), "e1g1");
+        assert::is_true(moves[0].get_flag() == libchess::packed_move_t::flag_castling);
+        assert::is_equal(libchess::uci::serialize(moves[1]), "e1c1");
+
+        for (uint64_t random = 0; random < 4; random++) {
+            assert::is_true(book->pick(castling, random, move));
+            assert::is_equal(libchess::uci::serialize(move), "e1g1");
+        }
+
+        libchess::engine promotion(libchess::board::create(s_promotion));
+        assert::is_true(book->pick(promotion, 0, move));
+        assert::is_equal(libchess::uci::serialize(move), "e7e8q");
+
+        // out of book
+        libchess::engine unknown(libchess::board::create("4k3/8/8/8/8/8/8/4K3 w - - 0 1"));
+        assert::is_equal(book->probe(unknown, moves, nullptr), 0);
+        assert::is_false(book->pick(unknown, 0, move));
+
+        assert::is_nullptr(libchess::polyglot_book::create(bytes.substr(1), table));
+        assert::is_nullptr(libchess::polyglot_book::create(bytes, nullptr));
+    }
+
+    virtual std::string get_check_name() override { return "book_moves"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<polyglot_keys>();
+    invoke_check<reference_keys>();
+    invoke_check<bad_random_tables>();
+    invoke_check<book_moves>();
+}
\ No newline at end of file
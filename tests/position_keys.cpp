@@ -0,0 +1,122 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static void commit_moves(libchess::engine& engine, const std::vector<std::string>& moves) {
+    for (const auto& desc : moves) {
+        std::vector<std::string> squares;
+        libchess::util::split_string(desc, ' ', squares);
+        assert::is_equal(squares.size(), 2);
+
+        libchess::move_t move;
+        assert::is_true(libchess::util::parse_coordinate(squares[0], move.position));
+        assert::is_true(libchess::util::parse_coordinate(squares[1], move.destination));
+        assert::is_true(engine.commit_move(move));
+
+        // the incremental key must always match a key computed from scratch
+        auto board = engine.get_board();
+        assert::is_equal(engine.get_key(), libchess::zobrist::compute(board->get_data()));
+    }
+}
+
+class incremental_keys : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", "e2 e4",
+                      "d7 d5", "e4 d5", "d8 d5", "b1 c3", "d5 a5" });
+
+        inline_data({ "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1 g1", "e8 c8", "a1 a8",
+                      "c8 b7", "a8 d8" });
+
+        inline_data({ "k7/8/8/3Pp3/8/8/8/K7 w - e6 0 1", "d5 e6", "a8 b8" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        commit_moves(engine, std::vector<std::string>(data.begin() + 1, data.end()));
+    }
+
+    virtual std::string get_check_name() override { return "incremental_keys"; }
+};
+
+class transposed_keys : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto first = libchess::board::create_default();
+        auto second = libchess::board::create_default();
+
+        libchess::engine first_engine(first);
+        libchess::engine second_engine(second);
+
+        commit_moves(first_engine, { "g1 f3", "g8 f6", "b1 c3" });
+        commit_moves(second_engine, { "b1 c3", "g8 f6", "g1 f3" });
+        assert::is_equal(first_engine.get_key(), second_engine.get_key());
+
+        // same pieces, different side to move
+        commit_moves(first_engine, { "f6 g8", "f3 g1", "g8 f6" });
+        assert::is_not_equal(first_engine.get_key(), second_engine.get_key());
+    }
+
+    virtual std::string get_check_name() override { return "transposed_keys"; }
+};
+
+class make_unmake_keys : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto board = libchess::board::create(
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+        assert::is_not_nullptr(board);
+        libchess::engine engine(board);
+
+        uint64_t original_key = engine.get_key();
+        std::vector<libchess::coord> pieces;
+
+        libchess::piece_query_t query;
+        query.color = engine.get_current_turn();
+        engine.find_pieces(query, pieces);
+
+        for (const auto& position : pieces) {
+            std::list<libchess::coord> destinations;
+            engine.compute_legal_moves(position, destinations);
+
+            for (const auto& destination : destinations) {
+                libchess::move_t move;
+                move.position = position;
+                move.destination = destination;
+
+                assert::is_true(engine.make_move(move));
+                assert::is_equal(engine.get_key(), libchess::zobrist::compute(board->get_data()));
+
+                assert::is_true(engine.unmake_move());
+                assert::is_equal(engine.get_key(), original_key);
+            }
+        }
+    }
+
+    virtual std::string get_check_name() override { return "make_unmake_keys"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<incremental_keys>();
+    invoke_check<transposed_keys>();
+    invoke_check<make_unmake_keys>();
+}
\ No newline at end of file
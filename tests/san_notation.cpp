@@ -0,0 +1,160 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static bool parse_move(const std::string& desc, libchess::move_t& move) {
+    std::vector<std::string> segments;
+    libchess::util::split_string(desc, ' ', segments,
+                                 libchess::util::string_split_options_omit_empty);
+
+    if (segments.size() < 2 || segments.size() > 3) {
+        return false;
+    }
+
+    move.promotion = libchess::piece_type::none;
+    if (segments.size() == 3) {
+        libchess::piece_info_t promotion;
+        if (!libchess::util::parse_piece(segments[2][0], promotion, false)) {
+            return false;
+        }
+
+        move.promotion = promotion.type;
+    }
+
+    return libchess::util::parse_coordinate(segments[0], move.position) &&
+           libchess::util::parse_coordinate(segments[1], move.destination);
+}
+
+static bool moves_equal(const libchess::move_t& lhs, const libchess::move_t& rhs) {
+    return lhs.position == rhs.position && lhs.destination == rhs.destination &&
+           lhs.promotion == rhs.promotion;
+}
+
+// san, move, position
+class san_moves : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "e4", "e2 e4", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "Nf3", "g1 f3", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "Nbd7", "b8 d7",
+                      "rnbqkb1r/ppp1pppp/5n2/3p4/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1" });
+        inline_data({ "exd6", "e5 d6",
+                      "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 1" });
+        inline_data({ "O-O-O", "e1 c1", "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1" });
+        inline_data({ "O-O", "e8 g8", "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1" });
+        inline_data({ "e8=Q+", "e7 e8 q", "3k4/4P3/8/8/8/8/8/4K3 w - - 0 1" });
+        inline_data({ "exd8=N", "e7 d8 n", "3r4/4P3/8/8/8/8/8/k3K3 w - - 0 1" });
+        inline_data({ "R1a3", "a1 a3", "7k/8/8/8/R7/8/8/R3K3 w - - 0 1" });
+        inline_data({ "Qh4e1", "h4 e1", "2k5/8/8/8/4Q2Q/8/8/K6Q w - - 0 1" });
+        inline_data({ "Ra8#", "a1 a8", "7k/8/6K1/8/8/8/8/R7 w - - 0 1" });
+        inline_data({ "Nxe5", "f3 e5",
+                      "rnbqkbnr/pppp1ppp/8/4p3/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[2]);
+        assert::is_not_nullptr(board);
+
+        libchess::move_t expected;
+        assert::is_true(parse_move(data[1], expected));
+
+        libchess::engine engine(board);
+        libchess::move_t parsed;
+
+        assert::is_true(libchess::san::parse(engine, data[0], parsed));
+        assert::is_true(moves_equal(parsed, expected));
+        assert::is_equal(libchess::san::serialize(engine, expected), data[0]);
+    }
+
+    virtual std::string get_check_name() override { return "san_moves"; }
+};
+
+// san, position
+class bad_san : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        // ambiguous, illegal, missing promotion, garbage
+        inline_data({ "Ra3", "7k/8/8/8/R7/8/8/R3K3 w - - 0 1" });
+        inline_data({ "Ke3", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "e8", "3k4/4P3/8/8/8/8/8/4K3 w - - 0 1" });
+        inline_data({ "e5=Q", "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "O-O", "r3k2r/8/8/8/8/8/8/R3K2R w Qkq - 0 1" });
+        inline_data({ "Zz9", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+
+        // capture markers have to match what the move takes
+        inline_data({ "Nxf3", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "Ne5", "rnbqkbnr/pppp1ppp/8/4p3/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 0 1" });
+        inline_data({ "ed6", "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 1" });
+        inline_data({ "xd6", "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[1]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        libchess::move_t move;
+
+        assert::is_false(libchess::san::parse(engine, data[0], move));
+    }
+
+    virtual std::string get_check_name() override { return "bad_san"; }
+};
+
+// every legal move has to survive a round trip through its san
+class san_round_trip : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data({ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" });
+        inline_data({ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" });
+        inline_data({ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" });
+        inline_data({ "4k3/8/8/8/2N1N3/8/2N1N3/4K3 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[0]);
+        assert::is_not_nullptr(board);
+
+        libchess::engine engine(board);
+        libchess::move_list moves;
+        engine.generate_legal_moves(moves);
+
+        for (auto packed : moves) {
+            auto move = packed.unpack();
+            auto san = libchess::san::serialize(engine, move);
+            assert::is_false(san.empty());
+
+            libchess::move_t parsed;
+            assert::is_true(libchess::san::parse(engine, san, parsed));
+            assert::is_true(moves_equal(parsed, move));
+        }
+
+        assert::is_equal(board->serialize(), data[0]);
+    }
+
+    virtual std::string get_check_name() override { return "san_round_trip"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<san_moves>();
+    invoke_check<bad_san>();
+    invoke_check<san_round_trip>();
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static libchess::search_info_t run_search(libchess::engine& engine, uint32_t depth,
+                                          bool expect_moves = true) {
+    libchess::search_limits_t limits;
+    limits.depth = depth;
+
+    libchess::searcher searcher;
+    libchess::search_info_t info;
+
+    assert::is_equal(searcher.search(engine, limits, info), expect_moves);
+    return info;
+}
+
+class search_best_moves : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        // fen, depth, best move if there's only one, and the mate distance in plies if any
+        inline_data({ "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1", "2", "d1d8", "1" });
+        inline_data({ "7k/8/8/8/8/8/8/1RR3K1 w - - 0 1", "4", "", "3" });
+        inline_data({ "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", "3",
+                      "h5f7", "1" });
+
+        // a loose queen
+        inline_data({ "k7/8/8/3q4/8/8/3R4/K7 w - - 0 1", "3", "d2d5", "" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::engine engine(libchess::board::create(data[0]));
+        auto info = run_search(engine, (uint32_t)std::stoul(data[1]));
+
+        assert::is_false(info.pv.empty());
+        if (!data[2].empty()) {
+            assert::is_equal(libchess::uci::serialize(info.pv[0]), data[2]);
+        }
+
+        if (data[3].empty()) {
+            assert::is_false(libchess::searcher::is_mate_score(info.score));
+        } else {
+            auto distance = (int32_t)std::stol(data[3]);
+            assert::is_equal(info.score, libchess::searcher::mate_score - distance);
+        }
+
+        // searched in place, and put back
+        assert::is_equal(engine.serialize_board(), data[0]);
+        assert::is_equal(engine.get_undo_depth(), 0);
+    }
+
+    virtual std::string get_check_name() override { return "search_best_moves"; }
+};
+
+class search_without_moves : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", "0" });
+        inline_data({ "R6k/8/6K1/8/8/8/8/8 b - - 0 1", "-32000" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::engine engine(libchess::board::create(data[0]));
+        auto info = run_search(engine, 3, false);
+
+        assert::is_true(info.pv.empty());
+        assert::is_equal(info.score, (int32_t)std::stol(data[1]));
+    }
+
+    virtual std::string get_check_name() override { return "search_without_moves"; }
+};
+
+class search_limits : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::engine engine(libchess::board::create_default());
+        libchess::searcher searcher;
+
+        libchess::search_limits_t limits;
+        limits.nodes = 5000;
+
+        std::vector<uint32_t> depths;
+        libchess::search_info_t info;
+
+        assert::is_true(searcher.search(engine, limits, info, [&](const auto& iteration) {
+            depths.push_back(iteration.depth);
+        }));
+
+        // every finished iteration is reported, in order, and the last one is returned
+        assert::is_false(depths.empty());
+        for (size_t i = 0; i < depths.size(); i++) {
+            assert::is_equal(depths[i], (uint32_t)(i + 1));
+        }
+
+        assert::is_equal(info.depth, depths.back());
+        assert::is_true(info.nodes <= limits.nodes);
+        assert::is_false(info.pv.empty());
+
+        limits.nodes = 0;
+        limits.time_ms = 50;
+
+        auto start = std::chrono::steady_clock::now();
+        assert::is_true(searcher.search(engine, limits, info));
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        assert::is_true(elapsed < std::chrono::milliseconds(1000));
+        assert::is_true(info.depth > 0);
+        assert::is_equal(engine.get_undo_depth(), 0);
+    }
+
+    virtual std::string get_check_name() override { return "search_limits"; }
+};
+
+class search_threads : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::searcher searcher;
+        searcher.set_thread_count(4);
+        assert::is_equal(searcher.get_thread_count(), 4);
+
+        std::string fen = "7k/8/8/8/8/8/8/1RR3K1 w - - 0 1";
+        libchess::engine engine(libchess::board::create(fen));
+
+        libchess::search_limits_t limits;
+        limits.depth = 4;
+
+        libchess::search_info_t info;
+        assert::is_true(searcher.search(engine, limits, info));
+        assert::is_equal(info.score, libchess::searcher::mate_score - 3);
+        assert::is_equal(engine.serialize_board(), fen);
+
+        // the helpers stop with the main thread, and their nodes are counted with its own
+        limits.depth = 0;
+        limits.nodes = 20000;
+
+        engine.set_board(libchess::board::create_default());
+        assert::is_true(searcher.search(engine, limits, info));
+        assert::is_true(info.nodes >= limits.nodes);
+        assert::is_true(info.nodes < limits.nodes + 4 * 1024 + 1024);
+        assert::is_equal(engine.get_undo_depth(), 0);
+    }
+
+    virtual std::string get_check_name() override { return "search_threads"; }
+};
+
+class search_tablebases : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto tablebases = std::make_shared<libchess::tablebase_set>();
+        assert::is_true(tablebases->generate("KQK"));
+
+        // mate in 10 moves is far past a depth of 2 without the table
+        libchess::engine engine(libchess::board::create("8/8/8/3k4/8/8/8/Q5K1 w - - 0 1"));
+        engine.set_tablebases(tablebases);
+
+        libchess::tablebase_result_t expected;
+        assert::is_true(engine.probe_tablebase(expected));
+
+        // in a band of its own, between mates the search finds and evaluations
+        auto info = run_search(engine, 2);
+        assert::is_false(libchess::searcher::is_mate_score(info.score));
+        assert::is_true(libchess::searcher::is_tablebase_score(info.score));
+        assert::is_true(info.score > libchess::searcher::max_eval_score);
+        assert::is_equal(info.score,
+                         libchess::searcher::tablebase_score - (int32_t)expected.distance);
+
+        // the pawn keeps the table out until it's taken, at the third ply at the earliest.
+        // results stored while searching from two plies in have to read back two plies longer
+        libchess::engine root(libchess::board::create("8/8/8/3k4/8/7p/8/Q5K1 w - - 0 1"));
+        root.set_tablebases(tablebases);
+
+        auto fresh = run_search(root, 5);
+        assert::is_true(libchess::searcher::is_tablebase_score(fresh.score));
+
+        libchess::search_limits_t limits;
+        libchess::searcher searcher;
+        libchess::move_list moves, replies;
+
+        limits.depth = 3;
+        root.generate_legal_moves(moves);
+
+        for (auto move : moves) {
+            root.make_move(move);
+            root.generate_legal_moves(replies);
+
+            for (auto reply : replies) {
+                root.make_move(reply);
+
+                libchess::engine inner(libchess::board::create(root.serialize_board()));
+                inner.set_tablebases(tablebases);
+                assert::is_true(searcher.search(inner, limits, info));
+
+                root.unmake_move();
+            }
+
+            root.unmake_move();
+        }
+
+        limits.depth = 5;
+        assert::is_true(searcher.search(root, limits, info));
+        assert::is_equal(info.score, fresh.score);
+    }
+
+    virtual std::string get_check_name() override { return "search_tablebases"; }
+};
+
+class search_game_history : public test_fact {
+protected:
+    virtual void invoke() override {
+        // down a queen, white can only hope to repeat a position from earlier in the game
+        libchess::engine engine(libchess::board::create("3qk3/8/8/8/8/8/8/4K1N1 w - - 0 1"));
+        std::vector<uint64_t> keys;
+
+        for (auto uci : { "g1f3", "d8d7", "f3g1", "d7d8" }) {
+            libchess::packed_move_t move;
+            assert::is_true(libchess::uci::parse(uci, move));
+
+            keys.push_back(engine.get_key());
+            assert::is_true(engine.commit_move(move));
+        }
+
+        auto info = run_search(engine, 3);
+        assert::is_true(info.score < -500);
+
+        libchess::search_limits_t limits;
+        limits.depth = 3;
+
+        libchess::searcher searcher;
+        searcher.set_game_history(keys);
+
+        assert::is_true(searcher.search(engine, limits, info));
+        assert::is_equal(info.score, 0);
+        assert::is_equal(libchess::uci::serialize(info.pv[0]), "g1f3");
+    }
+
+    virtual std::string get_check_name() override { return "search_game_history"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<search_best_moves>();
+    invoke_check<search_without_moves>();
+    invoke_check<search_limits>();
+    invoke_check<search_threads>();
+    invoke_check<search_tablebases>();
+    invoke_check<search_game_history>();
+}
\ No newline at end of file
@@ -0,0 +1,426 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+// generated once - every table here takes well under a second
+static std::shared_ptr<libchess::tablebase_set> get_tablebases() {
+    static std::shared_ptr<libchess::tablebase_set> tablebases;
+
+    if (!tablebases) {
+        tablebases = std::make_shared<libchess::tablebase_set>();
+        for (auto signature : { "KQK", "KRK", "KPK" }) {
+            assert::is_true(tablebases->generate(signature));
+        }
+    }
+
+    return tablebases;
+}
+
+// kpkp, with every table a promotion leads into filled with draws - generating those for real
+// would take far longer than kpkp itself, which still takes a while. it's kept apart
+static std::shared_ptr<libchess::tablebase_set> get_pawn_tablebases() {
+    static std::vector<std::string> storage;
+    static std::shared_ptr<libchess::tablebase_set> tablebases;
+
+    if (!tablebases) {
+        tablebases = std::make_shared<libchess::tablebase_set>();
+        for (auto signature : { "KPK", "KKP" }) {
+            assert::is_true(tablebases->generate(signature));
+        }
+
+        static const char* promotions[] = { "KQKP", "KRKP", "KBKP", "KNKP",
+                                            "KPKQ", "KPKR", "KPKB", "KPKN" };
+
+        // a 16-byte header - magic, version and signature - then 1 for a draw per position
+        storage.reserve(std::size(promotions));
+        for (std::string signature : promotions) {
+            auto& bytes = storage.emplace_back(16 + 64 * 64 * 64 * 48 * 2, '\1');
+            bytes.replace(0, 8, std::string("LCTB\1\0\0\0", 8));
+            bytes.replace(8, 8, signature + std::string(8 - signature.length(), '\0'));
+
+            auto table = libchess::tablebase::create(bytes);
+            assert::is_not_nullptr(table);
+            tablebases->add(table);
+        }
+
+        libchess::thread_pool pool;
+        assert::is_true(tablebases->generate("KPKP", &pool));
+    }
+
+    return tablebases;
+}
+
+static bool probe(const std::string& fen, libchess::tablebase_result_t& result) {
+    libchess::board::data_t data;
+    assert::is_true(libchess::board::parse_fen(fen, data) == libchess::fen_error::none);
+
+    return get_tablebases()->probe(data, result);
+}
+
+class tablebase_signatures : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "KQK", "KQK" });
+        inline_data({ "KPKR", "KPKR" });
+        inline_data({ "KNQK", "KQNK" });
+        inline_data({ "KPBK", "KBPK" });
+        inline_data({ "KK", "KK" });
+        inline_data({ "KQRKR", "" });
+        inline_data({ "QKK", "" });
+        inline_data({ "KQ", "" });
+        inline_data({ "KXK", "" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        std::string signature;
+        bool valid = libchess::tablebase::parse_signature(data[0], signature);
+
+        assert::is_equal(valid, !data[1].empty());
+        if (valid) {
+            assert::is_equal(signature, data[1]);
+        }
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_signatures"; }
+};
+
+class tablebase_results : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        // fen, then "w", "d" or "l" and the distance in plies
+        inline_data({ "7k/8/6K1/8/8/8/8/R7 w - - 0 1", "w", "1" });
+        inline_data({ "R6k/8/6K1/8/8/8/8/8 b - - 0 1", "l", "0" });
+        inline_data({ "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", "d", "0" }); // stalemate
+        inline_data({ "8/8/8/8/8/k7/1Q6/3K4 b - - 0 1", "d", "0" }); // the queen falls
+        inline_data({ "8/8/8/8/8/8/8/K6k w - - 0 1", "d", "0" });
+
+        // a king in front of its pawn on the sixth rank wins either way. a rook pawn can't
+        // get past a king in the corner
+        inline_data({ "4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", "w", "21" });
+        inline_data({ "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", "l", "24" });
+        inline_data({ "k7/8/8/8/8/8/P7/4K3 w - - 0 1", "d", "0" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::tablebase_result_t result;
+        assert::is_true(probe(data[0], result));
+
+        static const std::string results = "ldw";
+        assert::is_equal((size_t)result.wdl, results.find(data[1]));
+        assert::is_equal(result.distance, (uint32_t)std::stoul(data[2]));
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_results"; }
+};
+
+class tablebase_misses : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "4k3/8/8/8/8/8/8/R3K3 w Q - 0 1" }); // castling
+        inline_data({ "4k3/8/8/8/8/8/8/2QQK3 w - - 0 1" }); // no table
+        inline_data({ "8/8/8/8/8/8/1k6/KQ6 w - - 0 1" });   // black is in check
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::tablebase_result_t result;
+        assert::is_false(probe(data[0], result));
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_misses"; }
+};
+
+class tablebase_mirrors : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        // a position, then the same one with colors swapped and ranks flipped
+        inline_data({ "8/8/8/3k4/8/8/8/Q5K1 w - - 0 1", "q5k1/8/8/8/3K4/8/8/8 b - - 0 1" });
+        inline_data({ "7k/8/6K1/8/8/8/8/R7 w - - 0 1", "r7/8/8/8/8/6k1/8/7K b - - 0 1" });
+        inline_data({ "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", "8/8/8/8/4p3/4k3/8/4K3 w - - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::board::data_t mirrored;
+        assert::is_true(libchess::board::parse_fen(data[1], mirrored) ==
+                        libchess::fen_error::none);
+
+        std::string signature;
+        assert::is_true(libchess::tablebase::get_signature(mirrored, signature));
+        assert::is_nullptr(get_tablebases()->find(signature));
+
+        libchess::tablebase_result_t expected, result;
+        assert::is_true(probe(data[0], expected));
+        assert::is_true(probe(data[1], result));
+
+        assert::is_equal((size_t)result.wdl, (size_t)expected.wdl);
+        assert::is_equal(result.distance, expected.distance);
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_mirrors"; }
+};
+
+class tablebase_longest_mates : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        // known maximums, in plies: mate in 10 with a queen, in 16 with a rook, and in 28 with
+        // a pawn
+        inline_data({ "KQK", "19" });
+        inline_data({ "KRK", "31" });
+        inline_data({ "KPK", "55" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto table = get_tablebases()->find(data[0]);
+        assert::is_not_nullptr(table);
+
+        std::stringstream stream;
+        assert::is_true(table->write(stream));
+
+        // a 16-byte header, then a byte per position - 2 plus the distance, if there is one
+        auto bytes = stream.str();
+        uint32_t longest = 0;
+
+        for (size_t i = 16; i < bytes.length(); i++) {
+            uint32_t value = (uint8_t)bytes[i];
+            if (value >= 2 && (value - 2) % 2 != 0) {
+                longest = std::max(longest, value - 2);
+            }
+        }
+
+        assert::is_equal(longest, (uint32_t)std::stoul(data[1]));
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_longest_mates"; }
+};
+
+class tablebase_consistency : public test_fact {
+protected:
+    virtual void invoke() override {
+        // playing the best move every ply should take exactly as long as promised
+        libchess::engine engine(libchess::board::create("8/8/8/8/3k4/8/8/R6K w - - 0 1"));
+        engine.set_tablebases(get_tablebases());
+
+        libchess::tablebase_result_t result;
+        assert::is_true(engine.probe_tablebase(result));
+
+        libchess::move_list moves;
+        while (result.distance > 0) {
+            engine.generate_legal_moves(moves);
+            assert::is_false(moves.empty());
+
+            bool found = false;
+            for (auto move : moves) {
+                libchess::tablebase_result_t next;
+                engine.make_move(move);
+                assert::is_true(engine.probe_tablebase(next));
+
+                // the loser can't do better than the table says, and the winner does no better
+                if (result.wdl == libchess::tablebase_wdl::loss) {
+                    assert::is_true(next.wdl == libchess::tablebase_wdl::win);
+                    assert::is_true(next.distance <= result.distance - 1);
+                }
+
+                if (!found && next.distance == result.distance - 1 && next.wdl != result.wdl) {
+                    found = true;
+                    result = next;
+                    break;
+                }
+
+                engine.unmake_move();
+            }
+
+            assert::is_true(found);
+        }
+
+        assert::is_true(result.wdl == libchess::tablebase_wdl::loss);
+        assert::is_true(engine.compute_checkmate(engine.get_current_turn()));
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_consistency"; }
+};
+
+// from the other side's point of view, a ply further back
+static libchess::tablebase_result_t negate_result(libchess::tablebase_result_t result) {
+    if (result.wdl != libchess::tablebase_wdl::draw) {
+        result.wdl = result.wdl == libchess::tablebase_wdl::win ? libchess::tablebase_wdl::loss
+                                                                 : libchess::tablebase_wdl::win;
+        result.distance++;
+    }
+
+    return result;
+}
+
+// the best result over every move, from the tables. a position the tables can't probe, because
+// en passant is available, is searched another ply - or probed as if it weren't
+static bool search_result(libchess::engine& engine, const libchess::tablebase_set& tablebases,
+                          bool en_passant, libchess::tablebase_result_t& best) {
+    libchess::move_list moves;
+    engine.generate_legal_moves(moves);
+
+    bool found = false;
+    for (auto move : moves) {
+        engine.make_move(move);
+
+        auto data = engine.get_board()->get_data();
+        libchess::tablebase_result_t result;
+        bool probed = tablebases.probe(data, result);
+
+        if (!probed && en_passant) {
+            probed = search_result(engine, tablebases, false, result);
+        } else if (!probed) {
+            data.en_passant_target.reset();
+            probed = tablebases.probe(data, result);
+        }
+
+        engine.unmake_move();
+        assert::is_true(probed);
+
+        result = negate_result(result);
+        if (!found || result.wdl > best.wdl ||
+            (result.wdl == best.wdl && (result.wdl == libchess::tablebase_wdl::win
+                                            ? result.distance < best.distance
+                                            : result.distance > best.distance))) {
+            best = result;
+        }
+
+        found = true;
+    }
+
+    return found;
+}
+
+class tablebase_en_passant : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto tablebases = get_pawn_tablebases();
+        size_t checked = 0, changed = 0;
+
+        // a white pawn that can get past a black one by pushing two squares, wherever the kings
+        // are - the table has to agree with a search that lets black take en passant
+        for (int32_t file = 0; file < 8; file++) {
+            for (int32_t capturer : { file - 1, file + 1 }) {
+                if (capturer < 0 || capturer >= 8) {
+                    continue;
+                }
+
+                for (size_t white_king = 0; white_king < 64; white_king++) {
+                    for (size_t black_king = 0; black_king < 64; black_king++) {
+                        std::string squares(64, '1');
+                        squares[8 + file] = 'P';
+                        squares[24 + capturer] = 'p';
+
+                        if (squares[white_king] != '1' || white_king == black_king ||
+                            squares[black_king] != '1') {
+                            continue;
+                        }
+
+                        squares[white_king] = 'K';
+                        squares[black_king] = 'k';
+
+                        std::string fen;
+                        for (size_t rank = 8; rank > 0; rank--) {
+                            fen += squares.substr((rank - 1) * 8, 8) + (rank > 1 ? "/" : "");
+                        }
+
+                        libchess::board::data_t data;
+                        libchess::tablebase_result_t expected, result;
+                        assert::is_true(libchess::board::parse_fen(fen + " w - - 0 1", data) ==
+                                        libchess::fen_error::none);
+
+                        libchess::engine engine(libchess::board::create(data));
+                        if (!tablebases->probe(data, expected) ||
+                            !search_result(engine, *tablebases, true, result)) {
+                            continue;
+                        }
+
+                        assert::is_equal((size_t)result.wdl, (size_t)expected.wdl);
+                        assert::is_equal(result.distance, expected.distance);
+                        checked++;
+
+                        // and the capture has to actually matter somewhere
+                        assert::is_true(search_result(engine, *tablebases, false, result));
+                        if (result.wdl != expected.wdl || result.distance != expected.distance) {
+                            changed++;
+                        }
+                    }
+                }
+            }
+        }
+
+        assert::is_true(checked > 0);
+        assert::is_true(changed > 0);
+
+        // a2-a4 gets past b4 and draws, if black can't take en passant. it can, and white loses
+        libchess::board::data_t data;
+        assert::is_true(libchess::board::parse_fen("8/8/8/8/1p6/8/P7/1k1K4 w - - 0 1", data) ==
+                        libchess::fen_error::none);
+
+        libchess::tablebase_result_t result;
+        assert::is_true(tablebases->probe(data, result));
+        assert::is_true(result.wdl == libchess::tablebase_wdl::loss);
+
+        libchess::engine engine(libchess::board::create(data));
+        assert::is_true(search_result(engine, *tablebases, false, result));
+        assert::is_true(result.wdl == libchess::tablebase_wdl::draw);
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_en_passant"; }
+};
+
+class tablebase_round_trip : public test_fact {
+protected:
+    virtual void invoke() override {
+        auto table = get_tablebases()->find("KPK");
+        assert::is_not_nullptr(table);
+
+        std::stringstream stream;
+        assert::is_true(table->write(stream));
+
+        auto bytes = stream.str();
+        auto loaded = libchess::tablebase::create(bytes);
+        assert::is_not_nullptr(loaded);
+        assert::is_equal(loaded->get_signature(), "KPK");
+        assert::is_equal(loaded->get_entry_count(), table->get_entry_count());
+
+        libchess::board::data_t data;
+        assert::is_true(libchess::board::parse_fen("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", data) ==
+                        libchess::fen_error::none);
+
+        libchess::tablebase_result_t result;
+        assert::is_true(loaded->probe(data, result));
+        assert::is_true(result.wdl == libchess::tablebase_wdl::loss);
+        assert::is_equal(result.distance, 24);
+
+        // truncated, or not a table at all
+        assert::is_nullptr(libchess::tablebase::create(bytes.substr(0, bytes.length() - 1)));
+        assert::is_nullptr(libchess::tablebase::create(std::string(bytes.length(), 'x')));
+    }
+
+    virtual std::string get_check_name() override { return "tablebase_round_trip"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<tablebase_signatures>();
+    invoke_check<tablebase_results>();
+    invoke_check<tablebase_misses>();
+    invoke_check<tablebase_mirrors>();
+    invoke_check<tablebase_longest_mates>();
+    invoke_check<tablebase_consistency>();
+    invoke_check<tablebase_round_trip>();
+    invoke_check<tablebase_en_passant>();
+}
\ No newline at end of file
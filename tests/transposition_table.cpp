@@ -0,0 +1,195 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+static libchess::packed_move_t make_move(const std::string& uci) {
+    libchess::packed_move_t move;
+    assert::is_true(libchess::uci::parse(uci, move));
+
+    return move;
+}
+
+class tt_store_and_probe : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::transposition_table table(1);
+        assert::is_equal(table.get_bucket_count(), 1024 * 1024 / 64);
+        assert::is_equal(table.get_size_mb(), 1);
+
+        uint64_t key = 0x123456789ABCDEF0ull;
+        libchess::tt_entry_t entry;
+        assert::is_false(table.probe(key, entry));
+
+        table.store(key, make_move("e2e4"), -31990, 7, libchess::tt_bound::lower);
+        assert::is_true(table.probe(key, entry));
+        assert::is_equal(libchess::uci::serialize(entry.move), "e2e4");
+        assert::is_equal(entry.score, -31990);
+        assert::is_equal(entry.depth, 7);
+        assert::is_true(entry.bound == libchess::tt_bound::lower);
+
+        // same bucket, different position - whichever bits differ
+        assert::is_false(table.probe(key ^ (1ull << 63), entry));
+        assert::is_false(table.probe(key ^ (1ull << 40), entry));
+
+        // an empty move keeps the one already there
+        table.store(key, {}, 25, 8, libchess::tt_bound::exact);
+        assert::is_true(table.probe(key, entry));
+        assert::is_equal(libchess::uci::serialize(entry.move), "e2e4");
+        assert::is_equal(entry.score, 25);
+
+        // a much shallower bound doesn't replace a deeper result from the same search
+        table.store(key, make_move("d2d4"), 0, 2, libchess::tt_bound::upper);
+        assert::is_true(table.probe(key, entry));
+        assert::is_equal(entry.depth, 8);
+
+        table.new_search();
+        table.store(key, make_move("d2d4"), 0, 2, libchess::tt_bound::upper);
+        assert::is_true(table.probe(key, entry));
+        assert::is_equal(entry.depth, 2);
+
+        table.clear();
+        assert::is_false(table.probe(key, entry));
+    }
+
+    virtual std::string get_check_name() override { return "tt_store_and_probe"; }
+};
+
+class tt_replacement : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::transposition_table table(1);
+
+        // one bucket's worth of positions, then one more - the shallowest has to go
+        auto get_key = [&](uint64_t i) { return (i << 48) | 5; };
+        for (uint64_t i = 1; i <= libchess::transposition_table::entries_per_bucket; i++) {
+            table.store(get_key(i), {}, 0, (uint32_t)(i == 3 ? 1 : 10 + i),
+                        libchess::tt_bound::exact);
+        }
+
+        libchess::tt_entry_t entry;
+        table.store(get_key(100), {}, 0, 5, libchess::tt_bound::exact);
+
+        assert::is_true(table.probe(get_key(100), entry));
+        assert::is_false(table.probe(get_key(3), entry));
+        assert::is_true(table.probe(get_key(4), entry));
+
+        // entries from earlier searches go first, even if they're deeper
+        table.new_search();
+        table.new_search();
+        table.store(get_key(101), {}, 0, 1, libchess::tt_bound::exact);
+        table.store(get_key(102), {}, 0, 1, libchess::tt_bound::exact);
+
+        assert::is_true(table.probe(get_key(101), entry));
+        assert::is_true(table.probe(get_key(102), entry));
+        assert::is_false(table.probe(get_key(100), entry));
+        assert::is_false(table.probe(get_key(1), entry));
+    }
+
+    virtual std::string get_check_name() override { return "tt_replacement"; }
+};
+
+class tt_shared_between_threads : public test_fact {
+protected:
+    virtual void invoke() override {
+        libchess::thread_pool pool(4);
+        libchess::transposition_table table(1, &pool);
+
+        // every thread writes scores derived from the key, so any hit can be checked
+        auto score_of = [](uint64_t key) { return (int32_t)(int16_t)(key >> 20); };
+        std::atomic<uint64_t> bad_hits = 0;
+
+        for (size_t thread = 0; thread < pool.get_thread_count(); thread++) {
+            pool.submit([&, thread](size_t) {
+                uint64_t state = thread + 1;
+                for (size_t i = 0; i < 200000; i++) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+
+                    // few enough keys to collide a lot
+                    uint64_t key = ((state >> 33) % 4096) * 0x9E3779B97F4A7C15ull;
+
+                    libchess::tt_entry_t entry;
+                    if (table.probe(key, entry) && entry.score != score_of(key)) {
+                        bad_hits++;
+                    }
+
+                    table.store(key, {}, score_of(key), (uint32_t)(i % 20),
+                                libchess::tt_bound::exact);
+                }
+            });
+        }
+
+        pool.wait();
+        assert::is_equal(bad_hits.load(), 0);
+
+        // a resize starts empty
+        table.resize(2, &pool);
+        assert::is_equal(table.get_size_mb(), 2);
+        assert::is_equal(table.get_hashfull(), 0);
+    }
+
+    virtual std::string get_check_name() override { return "tt_shared_between_threads"; }
+};
+
+class tt_search : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+        inline_data({ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" });
+        inline_data(
+            { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::search_limits_t limits;
+        limits.depth = 5;
+
+        auto search = [&](std::shared_ptr<libchess::transposition_table> table) {
+            libchess::engine engine(libchess::board::create(data[0]));
+
+            libchess::searcher searcher;
+            searcher.set_transposition_table(table);
+
+            libchess::search_info_t info;
+            assert::is_true(searcher.search(engine, limits, info));
+
+            return info;
+        };
+
+        auto without = search(nullptr);
+        auto table = std::make_shared<libchess::transposition_table>(4);
+        auto with = search(table);
+
+        assert::is_true(with.nodes < without.nodes);
+        assert::is_equal(with.score, without.score);
+        assert::is_true(table->get_hashfull() > 0);
+
+        // searching the same position again reuses what the first search left behind
+        auto warm = search(table);
+        assert::is_true(warm.nodes < with.nodes);
+        assert::is_equal(warm.score, with.score);
+    }
+
+    virtual std::string get_check_name() override { return "tt_search"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<tt_store_and_probe>();
+    invoke_check<tt_replacement>();
+    invoke_check<tt_shared_between_threads>();
+    invoke_check<tt_search>();
+}
\ No newline at end of file
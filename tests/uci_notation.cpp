@@ -0,0 +1,144 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <testbed.h>
+#include <libchess.h>
+
+// uci, position, destination, promotion
+class uci_moves : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "e2e4", "12", "28", "" });
+        inline_data({ "a1h8", "0", "63", "" });
+        inline_data({ "h8a1", "63", "0", "" });
+        inline_data({ "e7e8q", "52", "60", "q" });
+        inline_data({ "b2a1r", "9", "0", "r" });
+        inline_data({ "g7g8n", "54", "62", "n" });
+        inline_data({ "c2c1b", "10", "2", "b" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::packed_move_t move;
+        assert::is_true(libchess::uci::parse(data[0], move));
+
+        assert::is_equal(move.get_position(), (size_t)std::stoull(data[1]));
+        assert::is_equal(move.get_destination(), (size_t)std::stoull(data[2]));
+
+        libchess::piece_type promotion = libchess::piece_type::none;
+        if (!data[3].empty()) {
+            libchess::piece_info_t piece;
+            assert::is_true(libchess::util::parse_piece(data[3][0], piece, false));
+
+            promotion = piece.type;
+        }
+
+        assert::is_equal(move.get_promotion(), promotion);
+        assert::is_equal(libchess::uci::serialize(move), data[0]);
+
+        // and back through the unpacked form
+        auto repacked = libchess::packed_move_t::pack(move.unpack());
+        assert::is_true(repacked == move);
+    }
+
+    virtual std::string get_check_name() override { return "uci_moves"; }
+};
+
+// uci
+class bad_uci : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "" });
+        inline_data({ "e2" });
+        inline_data({ "e2e" });
+        inline_data({ "e2e4qq" });
+        inline_data({ "i2e4" });
+        inline_data({ "e9e4" });
+        inline_data({ "e0e4" });
+        inline_data({ "E2E4" });
+        inline_data({ "e7e8k" });
+        inline_data({ "e7e8p" });
+        inline_data({ "e2-4" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        libchess::packed_move_t move;
+        move.value = 0x1234;
+
+        assert::is_false(libchess::uci::parse(data[0], move));
+        assert::is_equal(move.value, 0x1234);
+    }
+
+    virtual std::string get_check_name() override { return "bad_uci"; }
+};
+
+// uci, expected flag, position
+class move_flags : public test_theory {
+protected:
+    virtual void add_inline_data() override {
+        inline_data({ "e5d6", "en_passant",
+                      "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 1" });
+        inline_data({ "e1g1", "castling", "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1" });
+        inline_data({ "e8c8", "castling", "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1" });
+        inline_data({ "e1f1", "none", "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1" });
+        inline_data({ "e7e8n", "promotion", "3k4/4P3/8/8/8/8/8/4K3 w - - 0 1" });
+        inline_data({ "e2e4", "none", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" });
+    }
+
+    virtual void invoke(const std::vector<std::string>& data) override {
+        auto board = libchess::board::create(data[2]);
+        assert::is_not_nullptr(board);
+
+        libchess::packed_move_t parsed;
+        assert::is_true(libchess::uci::parse(data[0], parsed));
+
+        libchess::engine engine(board);
+        libchess::move_list moves;
+        engine.generate_legal_moves(moves);
+
+        const libchess::packed_move_t* found = nullptr;
+        for (const auto& move : moves) {
+            if (move.matches(parsed)) {
+                assert::is_nullptr(found);
+                found = &move;
+            }
+        }
+
+        assert::is_not_nullptr(found);
+
+        libchess::packed_move_t::move_flag flag = libchess::packed_move_t::flag_none;
+        if (data[1] == "en_passant") {
+            flag = libchess::packed_move_t::flag_en_passant;
+        } else if (data[1] == "castling") {
+            flag = libchess::packed_move_t::flag_castling;
+        } else if (data[1] == "promotion") {
+            flag = libchess::packed_move_t::flag_promotion;
+        }
+
+        assert::is_equal(found->get_flag(), flag);
+        assert::is_equal(libchess::uci::serialize(*found), data[0]);
+
+        // flagged moves play out the same as their unflagged coordinates
+        assert::is_true(engine.commit_move(*found));
+    }
+
+    virtual std::string get_check_name() override { return "move_flags"; }
+};
+
+DEFINE_ENTRYPOINT() {
+    invoke_check<uci_moves>();
+    invoke_check<bad_uci>();
+    invoke_check<move_flags>();
+}
\ No newline at end of file
@@ -0,0 +1,420 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <libchess.h>
+#include <chrono>
+#include <iostream>
+
+namespace libchess::perft_tool {
+    static const std::string s_default_fen =
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    struct position_t {
+        std::string fen;
+
+        // (depth, nodes) pairs from ";D<depth> <nodes>" suffixes in a position file
+        std::vector<std::pair<uint32_t, uint64_t>> expected;
+    };
+
+    struct options_t {
+        uint32_t depth = 5;
+        bool divide = false;
+
+        // 1 runs the serial perft. 0 uses one thread per hardware thread
+        size_t threads = 1;
+        uint32_t split_depth = 2;
+        bool scaling = false;
+
+        // size of the perft table in megabytes. 0 disables it
+        size_t hash_mb = 0;
+        std::vector<position_t> positions;
+    };
+
+    static void print_usage(const char* program) {
+        std::cout << "usage: " << program << " [options] [fen ...]\n"
+                  << "  -d, --depth <n>    search depth (default 5)\n"
+                  << "  -f, --file <path>  read positions from a file, one per line\n"
+                  << "  --divide           print the node count under each root move (serial)\n"
+                  << "  -t, --threads <n>  worker threads, 0 for all hardware threads (default 1)\n"
+                  << "  -s, --split <n>    plies searched before handing out tasks (default 2)\n"
+                  << "  --scaling          time every position at 1, 2, 4... up to --threads\n"
+                  << "  --hash <mb>        cache subtree counts in a table of this size\n"
+                  << "  -h, --help         show this message\n\n"
+                  << "lines in a position file may carry expected counts, e.g.\n"
+                  << "  <fen> ;D1 20 ;D2 400 ;D3 8902\n"
+                  << "in which case every listed depth up to --depth is checked" << std::endl;
+    }
+
+    // expected counts are epd operations named D<depth>, e.g. "D3 8902"
+    static bool parse_position(const epd_record_t& record, position_t& position) {
+        board::fen_buffer_t fen;
+        if (board::serialize(record.data, fen.data(), fen.size()) == 0) {
+            return false;
+        }
+
+        position.fen = fen.data();
+        for (size_t i = 0; i < record.operation_count; i++) {
+            const auto& operation = record.operations[i];
+            if (operation.opcode.length() < 2 || operation.opcode[0] != 'D') {
+                continue;
+            }
+
+            try {
+                auto depth = (uint32_t)std::stoul(std::string(operation.opcode.substr(1)));
+                auto nodes = (uint64_t)std::stoull(std::string(operation.operands));
+
+                position.expected.push_back(std::make_pair(depth, nodes));
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool load_positions(const std::string& path, std::vector<position_t>& positions) {
+        auto reader = epd_reader::open(path);
+        if (!reader) {
+            std::cerr << "could not open " << path << std::endl;
+            return false;
+        }
+
+        epd_record_t record;
+        while (reader->next(record)) {
+            position_t position;
+            if (record.error != fen_error::none || !parse_position(record, position)) {
+                std::cerr << path << ":" << record.line_number << ": malformed position"
+                          << std::endl;
+
+                return false;
+            }
+
+            positions.push_back(position);
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    static bool parse_number(int argc, const char** argv, int& index, T& result) {
+        if (++index >= argc) {
+            return false;
+        }
+
+        try {
+            result = (T)std::stoull(argv[index]);
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        return true;
+    }
+
+    static bool parse_options(int argc, const char** argv, options_t& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+
+            if (arg == "-h" || arg == "--help") {
+                return false;
+            } else if (arg == "--divide") {
+                options.divide = true;
+            } else if (arg == "--scaling") {
+                options.scaling = true;
+            } else if (arg == "-d" || arg == "--depth") {
+                if (!parse_number(argc, argv, i, options.depth)) {
+                    return false;
+                }
+            } else if (arg == "-t" || arg == "--threads") {
+                if (!parse_number(argc, argv, i, options.threads)) {
+                    return false;
+                }
+            } else if (arg == "-s" || arg == "--split") {
+                if (!parse_number(argc, argv, i, options.split_depth)) {
+                    return false;
+                }
+            } else if (arg == "--hash") {
+                if (!parse_number(argc, argv, i, options.hash_mb)) {
+                    return false;
+                }
+            } else if (arg == "-f" || arg == "--file") {
+                if (++i >= argc || !load_positions(argv[i], options.positions)) {
+                    return false;
+                }
+            } else if (!arg.empty() && arg[0] == '-') {
+                std::cerr << "unknown option: " << arg << std::endl;
+                return false;
+            } else {
+                position_t position;
+                position.fen = arg;
+
+                options.positions.push_back(position);
+            }
+        }
+
+        if (options.threads == 0) {
+            options.threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        if (options.positions.empty()) {
+            position_t position;
+            position.fen = s_default_fen;
+
+            options.positions.push_back(position);
+        }
+
+        return true;
+    }
+
+    static double get_mnps(uint64_t nodes, double seconds) {
+        return seconds > 0.0 ? (double)nodes / seconds / 1e6 : 0.0;
+    }
+
+    // the number of leaf nodes at the given depth. with --divide, each root move's share is
+    // also listed in entries. otherwise the count runs on the pool and the table, if given
+    static uint64_t count_nodes(engine& instance, uint32_t depth, const options_t& options,
+                                thread_pool* pool, perft_table* table,
+                                std::vector<perft_divide_entry_t>& entries) {
+        if (options.divide) {
+            return perft_divide(instance, depth, entries);
+        } else if (pool != nullptr) {
+            return perft_parallel(instance, depth, *pool, options.split_depth, table);
+        } else {
+            return perft(instance, depth, table);
+        }
+    }
+
+    static std::unique_ptr<perft_table> create_table(const options_t& options) {
+        std::unique_ptr<perft_table> table;
+        if (options.hash_mb > 0 && !options.divide) {
+            table = std::make_unique<perft_table>(options.hash_mb);
+        }
+
+        return table;
+    }
+
+    static double get_seconds_since(std::chrono::steady_clock::time_point start) {
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    // the deepest listed depth within the limit, or the limit itself if nothing is listed
+    static std::pair<uint32_t, std::optional<uint64_t>> get_target(const position_t& position,
+                                                                   uint32_t max_depth) {
+        std::pair<uint32_t, std::optional<uint64_t>> target;
+        if (position.expected.empty()) {
+            target.first = max_depth;
+            return target;
+        }
+
+        target.first = 0;
+        for (const auto& [depth, nodes] : position.expected) {
+            if (depth <= max_depth && depth >= target.first) {
+                target.first = depth;
+                target.second = nodes;
+            }
+        }
+
+        return target;
+    }
+
+    // the number of leaf nodes at the given depth. with --divide, each root move's share is
+    // also listed in entries. otherwise the count runs on the pool and the table, if given
+    static bool run_depth(engine& instance, uint32_t depth, std::optional<uint64_t> expected,
+                          const options_t& options, thread_pool* pool, perft_table* table,
+                          uint64_t& total_nodes, double& total_seconds) {
+        std::vector<perft_divide_entry_t> entries;
+        if (table != nullptr) {
+            table->reset_stats();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        uint64_t nodes = count_nodes(instance, depth, options, pool, table, entries);
+        double seconds = get_seconds_since(start);
+
+        for (const auto& entry : entries) {
+            std::cout << "  " << uci::serialize(entry.move) << ": " << entry.nodes << "\n";
+        }
+
+        std::cout << "depth " << depth << ": " << nodes << " nodes in " << seconds << " s ("
+                  << get_mnps(nodes, seconds) << " Mnps)";
+
+        bool passed = true;
+        if (expected.has_value()) {
+            passed = nodes == expected.value();
+            if (passed) {
+                std::cout << " - ok";
+            } else {
+                std::cout << " - MISMATCH, expected " << expected.value();
+            }
+        }
+
+        if (table != nullptr) {
+            auto stats = table->get_stats();
+            double hit_rate = stats.probes > 0 ? (double)stats.hits / (double)stats.probes : 0.0;
+
+            std::cout << "\n  hash: " << stats.hits << " hits of " << stats.probes << " probes ("
+                      << hit_rate * 100.0 << "%)";
+        }
+
+        std::cout << std::endl;
+
+        total_nodes += nodes;
+        total_seconds += seconds;
+
+        return passed;
+    }
+
+    // the same work at doubling thread counts, so that the speedup can be read off directly
+    static int run_scaling(const options_t& options) {
+        std::vector<std::shared_ptr<board>> boards;
+        std::vector<std::pair<uint32_t, std::optional<uint64_t>>> targets;
+
+        for (const auto& position : options.positions) {
+            auto _board = board::create(position.fen);
+            if (!_board) {
+                std::cerr << "invalid fen: " << position.fen << std::endl;
+                return 1;
+            }
+
+            boards.push_back(_board);
+            targets.push_back(get_target(position, options.depth));
+        }
+
+        std::vector<size_t> thread_counts;
+        for (size_t threads = 1; threads < options.threads; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+
+        thread_counts.push_back(options.threads);
+        auto table = create_table(options);
+        std::cout << "threads\tseconds\tMnps\tspeedup\tefficiency" << std::endl;
+
+        double serial_seconds = 0.0;
+        size_t failures = 0;
+
+        for (size_t threads : thread_counts) {
+            thread_pool pool(threads);
+            if (table) {
+                // every thread count starts from the same cold table
+                table->clear();
+            }
+
+            uint64_t total_nodes = 0;
+            auto start = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < boards.size(); i++) {
+                engine instance(boards[i]);
+                const auto& [depth, expected] = targets[i];
+
+                uint64_t nodes =
+                    perft_parallel(instance, depth, pool, options.split_depth, table.get());
+                if (expected.has_value() && nodes != expected.value()) {
+                    std::cerr << options.positions[i].fen << ": " << nodes << " nodes at depth "
+                              << depth << ", expected " << expected.value() << std::endl;
+
+                    failures++;
+                }
+
+                total_nodes += nodes;
+            }
+
+            double seconds = get_seconds_since(start);
+            if (threads == 1) {
+                serial_seconds = seconds;
+            }
+
+            double speedup = seconds > 0.0 ? serial_seconds / seconds : 0.0;
+            std::cout << threads << "\t" << seconds << "\t" << get_mnps(total_nodes, seconds)
+                      << "\t" << speedup << "\t" << speedup / (double)threads << std::endl;
+        }
+
+        if (failures > 0) {
+            std::cout << failures << " failure(s)" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    static int entrypoint(int argc, const char** argv) {
+        options_t options;
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (options.scaling) {
+            return run_scaling(options);
+        }
+
+        std::unique_ptr<thread_pool> pool;
+        if (options.threads > 1 && !options.divide) {
+            pool = std::make_unique<thread_pool>(options.threads);
+        }
+
+        auto table = create_table(options);
+
+        uint64_t total_nodes = 0;
+        double total_seconds = 0.0;
+        size_t failures = 0;
+
+        for (const auto& position : options.positions) {
+            auto _board = board::create(position.fen);
+            if (!_board) {
+                std::cerr << "invalid fen: " << position.fen << std::endl;
+
+                failures++;
+                continue;
+            }
+
+            std::cout << "position: " << position.fen << std::endl;
+            engine instance(_board);
+
+            if (position.expected.empty()) {
+                if (!run_depth(instance, options.depth, {}, options, pool.get(), table.get(),
+                               total_nodes, total_seconds)) {
+                    failures++;
+                }
+            } else {
+                for (const auto& [depth, nodes] : position.expected) {
+                    if (depth > options.depth) {
+                        continue;
+                    }
+
+                    if (!run_depth(instance, depth, nodes, options, pool.get(), table.get(),
+                                   total_nodes, total_seconds)) {
+                        failures++;
+                    }
+                }
+            }
+
+            std::cout << std::endl;
+        }
+
+        std::cout << "total: " << total_nodes << " nodes in " << total_seconds << " s ("
+                  << get_mnps(total_nodes, total_seconds) << " Mnps)" << std::endl;
+
+        if (failures > 0) {
+            std::cout << failures << " failure(s)" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+} // namespace libchess::perft_tool
+
+int main(int argc, const char** argv) { return libchess::perft_tool::entrypoint(argc, argv); }
\ No newline at end of file
@@ -0,0 +1,224 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <libchess.h>
+#include <iostream>
+
+namespace libchess::search_bench {
+    // opening, endgame and tactical positions
+    static const std::vector<std::string> s_default_fens = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1"
+    };
+
+    struct options_t {
+        uint32_t depth = 5;
+
+        // thread counts double from 1 up to this. 0 uses one per hardware thread
+        size_t threads = 0;
+        size_t hash_mb = transposition_table::default_size_mb;
+
+        // scores positions with eval::evaluate if there is none
+        std::shared_ptr<nnue::network> network;
+
+        std::vector<std::string> fens;
+    };
+
+    static void print_usage(const char* program) {
+        std::cout << "usage: " << program << " [options] [fen ...]\n"
+                  << "  -d, --depth <n>    depth to search every position to (default 5)\n"
+                  << "  -f, --file <path>  read positions from a file, one per line\n"
+                  << "  -t, --threads <n>  largest thread count, 0 for all hardware threads\n"
+                  << "  --hash <mb>        transposition table size (default 16)\n"
+                  << "  --network <path>   evaluate with a network file instead of the tables\n"
+                  << "  -h, --help         show this message\n\n"
+                  << "every position is searched to the same depth at 1, 2, 4... threads, with "
+                     "the\ntable cleared in between, and the time to depth compared. first% is how "
+                     "often\nthe first move searched caused a cutoff"
+                  << std::endl;
+    }
+
+    static bool load_positions(const std::string& path, std::vector<std::string>& fens) {
+        auto reader = epd_reader::open(path);
+        if (!reader) {
+            std::cerr << "could not open " << path << std::endl;
+            return false;
+        }
+
+        epd_record_t record;
+        while (reader->next(record)) {
+            board::fen_buffer_t fen;
+            if (record.error != fen_error::none ||
+                board::serialize(record.data, fen.data(), fen.size()) == 0) {
+                std::cerr << path << ":" << record.line_number << ": malformed position"
+                          << std::endl;
+
+                return false;
+            }
+
+            fens.push_back(fen.data());
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    static bool parse_number(int argc, const char** argv, int& index, T& result) {
+        if (++index >= argc) {
+            return false;
+        }
+
+        try {
+            result = (T)std::stoull(argv[index]);
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        return true;
+    }
+
+    static bool parse_options(int argc, const char** argv, options_t& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+
+            if (arg == "-h" || arg == "--help") {
+                return false;
+            } else if (arg == "-d" || arg == "--depth") {
+                if (!parse_number(argc, argv, i, options.depth) || options.depth == 0) {
+                    return false;
+                }
+            } else if (arg == "-t" || arg == "--threads") {
+                if (!parse_number(argc, argv, i, options.threads)) {
+                    return false;
+                }
+            } else if (arg == "--hash") {
+                if (!parse_number(argc, argv, i, options.hash_mb)) {
+                    return false;
+                }
+            } else if (arg == "--network") {
+                if (++i >= argc) {
+                    return false;
+                }
+
+                options.network = nnue::network::open(argv[i]);
+                if (!options.network) {
+                    std::cerr << "could not load a network from " << argv[i] << std::endl;
+                    return false;
+                }
+            } else if (arg == "-f" || arg == "--file") {
+                if (++i >= argc || !load_positions(argv[i], options.fens)) {
+                    return false;
+                }
+            } else if (!arg.empty() && arg[0] == '-') {
+                std::cerr << "unknown option: " << arg << std::endl;
+                return false;
+            } else {
+                options.fens.push_back(arg);
+            }
+        }
+
+        if (options.threads == 0) {
+            options.threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        if (options.fens.empty()) {
+            options.fens = s_default_fens;
+        }
+
+        return true;
+    }
+
+    static int entrypoint(int argc, const char** argv) {
+        options_t options;
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::vector<std::shared_ptr<board>> boards;
+        for (const auto& fen : options.fens) {
+            auto _board = board::create(fen);
+            if (!_board) {
+                std::cerr << "invalid fen: " << fen << std::endl;
+                return 1;
+            }
+
+            boards.push_back(_board);
+        }
+
+        std::vector<size_t> thread_counts;
+        for (size_t threads = 1; threads < options.threads; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+
+        thread_counts.push_back(options.threads);
+
+        auto table = std::make_shared<transposition_table>(options.hash_mb);
+        std::cout << "threads\tseconds\tnodes\tMnps\tspeedup\tefficiency\tfirst%" << std::endl;
+
+        double serial_seconds = 0.0;
+        for (size_t threads : thread_counts) {
+            searcher instance;
+            instance.set_transposition_table(table);
+            instance.set_thread_count(threads);
+            instance.set_network(options.network);
+
+            search_limits_t limits;
+            limits.depth = options.depth;
+
+            uint64_t nodes = 0;
+            double seconds = 0.0;
+
+            // how often the first move searched caused a cutoff, a check on move ordering
+            uint64_t cutoffs = 0;
+            uint64_t first_move_cutoffs = 0;
+
+            for (const auto& _board : boards) {
+                // every thread count starts every position from the same cold table
+                table->clear();
+
+                engine position(board::create(_board->get_data()));
+                search_info_t info;
+
+                instance.search(position, limits, info);
+                nodes += info.nodes;
+                cutoffs += info.cutoffs;
+                first_move_cutoffs += info.first_move_cutoffs;
+                seconds += info.seconds;
+            }
+
+            if (threads == 1) {
+                serial_seconds = seconds;
+            }
+
+            double speedup = seconds > 0.0 ? serial_seconds / seconds : 0.0;
+            double mnps = seconds > 0.0 ? (double)nodes / seconds / 1e6 : 0.0;
+
+            double first = cutoffs > 0 ? 100.0 * first_move_cutoffs / cutoffs : 0.0;
+
+            std::cout << threads << "\t" << seconds << "\t" << nodes << "\t" << mnps << "\t"
+                      << speedup << "\t" << speedup / (double)threads << "\t" << first
+                      << std::endl;
+        }
+
+        return 0;
+    }
+} // namespace libchess::search_bench
+
+int main(int argc, const char** argv) { return libchess::search_bench::entrypoint(argc, argv); }
\ No newline at end of file
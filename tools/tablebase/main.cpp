@@ -0,0 +1,173 @@
+/*
+   Copyright 2022-2023 Nora Beda
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <libchess.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace libchess::tablebase_tool {
+    struct options_t {
+        std::vector<std::string> signatures, tables, fens;
+
+        // tables are only written if a directory is given
+        std::string output;
+
+        // 1 generates on the calling thread. 0 uses one thread per hardware thread
+        size_t threads = 1;
+    };
+
+    static void print_usage(const char* program) {
+        std::cout << "usage: " << program << " [options] [signature ...]\n"
+                  << "  -o, --output <dir>   write each listed table to <dir>/<signature>.lctb\n"
+                  << "  -l, --load <path>    load a table instead of generating it\n"
+                  << "  -p, --probe <fen>    look a position up once every table is ready\n"
+                  << "  -t, --threads <n>    worker threads, 0 for all hardware threads "
+                     "(default 1)\n"
+                  << "  -h, --help           show this message\n\n"
+                  << "signatures list white's pieces, then black's, e.g. KQK or KRKP. tables "
+                     "that\ncaptures and promotions lead into are generated along the way"
+                  << std::endl;
+    }
+
+    static bool parse_options(int argc, const char** argv, options_t& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+
+            if (arg == "-h" || arg == "--help") {
+                return false;
+            } else if (arg == "-o" || arg == "--output" || arg == "-l" || arg == "--load" ||
+                       arg == "-p" || arg == "--probe" || arg == "-t" || arg == "--threads") {
+                if (++i >= argc) {
+                    return false;
+                }
+
+                std::string value = argv[i];
+                if (arg == "-o" || arg == "--output") {
+                    options.output = value;
+                } else if (arg == "-l" || arg == "--load") {
+                    options.tables.push_back(value);
+                } else if (arg == "-p" || arg == "--probe") {
+                    options.fens.push_back(value);
+                } else {
+                    try {
+                        options.threads = (size_t)std::stoull(value);
+                    } catch (const std::exception&) {
+                        return false;
+                    }
+                }
+            } else if (!arg.empty() && arg[0] == '-') {
+                std::cerr << "unknown option: " << arg << std::endl;
+                return false;
+            } else {
+                std::string signature;
+                if (!tablebase::parse_signature(arg, signature)) {
+                    std::cerr << "invalid signature: " << arg << std::endl;
+                    return false;
+                }
+
+                options.signatures.push_back(signature);
+            }
+        }
+
+        if (options.threads == 0) {
+            options.threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        return !options.signatures.empty() || !options.fens.empty();
+    }
+
+    static void print_result(const std::string& fen, const tablebase_result_t& result) {
+        static const char* names[] = { "loss", "draw", "win" };
+
+        std::cout << fen << ": " << names[(size_t)result.wdl];
+        if (result.wdl != tablebase_wdl::draw) {
+            std::cout << " in " << result.distance << " plies";
+        }
+
+        std::cout << std::endl;
+    }
+
+    static int entrypoint(int argc, const char** argv) {
+        options_t options;
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        tablebase_set tablebases;
+        for (const auto& path : options.tables) {
+            auto table = tablebase::open(path);
+            if (!table) {
+                std::cerr << "could not load " << path << std::endl;
+                return 1;
+            }
+
+            tablebases.add(table);
+        }
+
+        std::unique_ptr<thread_pool> pool;
+        if (options.threads > 1) {
+            pool = std::make_unique<thread_pool>(options.threads);
+        }
+
+        for (const auto& signature : options.signatures) {
+            auto start = std::chrono::steady_clock::now();
+            if (!tablebases.generate(signature, pool.get())) {
+                std::cerr << "could not generate " << signature << std::endl;
+                return 1;
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+
+            auto table = tablebases.find(signature);
+            std::cout << signature << ": " << table->get_entry_count() << " positions in "
+                      << seconds << " s" << std::endl;
+
+            if (options.output.empty()) {
+                continue;
+            }
+
+            std::string path = options.output + "/" + signature + ".lctb";
+            std::ofstream stream(path, std::ios::binary);
+
+            if (!stream.is_open() || !table->write(stream)) {
+                std::cerr << "could not write " << path << std::endl;
+                return 1;
+            }
+        }
+
+        size_t failures = 0;
+        for (const auto& fen : options.fens) {
+            auto _board = board::create(fen);
+            tablebase_result_t result;
+
+            if (!_board || !tablebases.probe(_board->get_data(), result)) {
+                std::cerr << fen << ": not in any loaded table" << std::endl;
+
+                failures++;
+                continue;
+            }
+
+            print_result(fen, result);
+        }
+
+        return failures > 0 ? 1 : 0;
+    }
+} // namespace libchess::tablebase_tool
+
+int main(int argc, const char** argv) { return libchess::tablebase_tool::entrypoint(argc, argv); }
\ No newline at end of file